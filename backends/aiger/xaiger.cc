@@ -769,11 +769,15 @@ struct XAigerBackend : public Backend {
 		log("    -map <filename>\n");
 		log("        write an extra file with port and box symbols\n");
 		log("\n");
+		log("    -map_scratchpad <varname>\n");
+		log("        store the port and box symbols in the given scratchpad variable of the\n");
+		log("        design instead of a file (see 'read_aiger -map_scratchpad')\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		bool ascii_mode = false;
-		std::string map_filename;
+		std::string map_filename, map_scratchpad;
 
 		log_header(design, "Executing XAIGER backend.\n");
 
@@ -788,6 +792,10 @@ struct XAigerBackend : public Backend {
 				map_filename = args[++argidx];
 				continue;
 			}
+			if (map_scratchpad.empty() && args[argidx] == "-map_scratchpad" && argidx+1 < args.size()) {
+				map_scratchpad = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx, !ascii_mode);
@@ -815,6 +823,12 @@ struct XAigerBackend : public Backend {
 				log_error("Can't open file `%s' for writing: %s\n", map_filename.c_str(), strerror(errno));
 			writer.write_map(mapf);
 		}
+
+		if (!map_scratchpad.empty()) {
+			std::stringstream maps;
+			writer.write_map(maps);
+			design->scratchpad_set_string(map_scratchpad, maps.str());
+		}
 	}
 } XAigerBackend;
 
@@ -26,6 +26,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 #include <string>
 
 USING_YOSYS_NAMESPACE
@@ -49,29 +50,127 @@ struct BlifDumperConfig
 	std::map<RTLIL::IdString, std::pair<RTLIL::IdString, RTLIL::IdString>> unbuf_types;
 	std::string true_type, true_out, false_type, false_out, undef_type, undef_out;
 
+	// The gate types that are written as .names and .latch statements, and the
+	// other names that BlifDumper looks up. They are created by setup() on the
+	// main thread, so that BlifDumper never creates or copies an IdString and
+	// can run on worker threads.
+	struct NamesGate {
+		vector<RTLIL::IdString> ports;
+		const char *table;
+	};
+	struct LatchGate {
+		const char *type;
+		RTLIL::IdString ctrl;
+	};
+	dict<RTLIL::IdString, NamesGate> names_gates;
+	dict<RTLIL::IdString, LatchGate> latch_gates;
+	RTLIL::IdString id_A, id_Y, id_D, id_Q, id_init, id_lut, id_sop, id_WIDTH, id_DEPTH, id_LUT, id_TABLE;
+	std::string true_cmd, false_cmd, undef_cmd, buf_cmd;
+
 	BlifDumperConfig() : icells_mode(false), conn_mode(false), impltf_mode(false), gates_mode(false),
 			cname_mode(false), iname_mode(false), param_mode(false), attr_mode(false), iattr_mode(false),
 			blackbox_mode(false), noalias_mode(false) { }
+
+	static bool is_blackbox(const RTLIL::Module *module)
+	{
+		auto it = module->attributes.find(ID::blackbox);
+		if (it != module->attributes.end() && it->second.as_bool())
+			return true;
+		it = module->attributes.find(ID::whitebox);
+		return it != module->attributes.end() && it->second.as_bool();
+	}
+
+	const char *subckt_or_gate(RTLIL::Design *design, const RTLIL::IdString &cell_type) const
+	{
+		if (!gates_mode)
+			return "subckt";
+		auto it = design->modules_.find(cell_type);
+		if (it == design->modules_.end() || is_blackbox(it->second))
+			return "gate";
+		return "subckt";
+	}
+
+	void setup(RTLIL::Design *design)
+	{
+		if (!icells_mode) {
+			names_gates[ID($_NOT_)] = {{ID(A), ID(Y)}, "0 1\n"};
+			names_gates[ID($_AND_)] = {{ID(A), ID(B), ID(Y)}, "11 1\n"};
+			names_gates[ID($_OR_)] = {{ID(A), ID(B), ID(Y)}, "1- 1\n-1 1\n"};
+			names_gates[ID($_XOR_)] = {{ID(A), ID(B), ID(Y)}, "10 1\n01 1\n"};
+			names_gates[ID($_NAND_)] = {{ID(A), ID(B), ID(Y)}, "0- 1\n-0 1\n"};
+			names_gates[ID($_NOR_)] = {{ID(A), ID(B), ID(Y)}, "00 1\n"};
+			names_gates[ID($_XNOR_)] = {{ID(A), ID(B), ID(Y)}, "11 1\n00 1\n"};
+			names_gates[ID($_ANDNOT_)] = {{ID(A), ID(B), ID(Y)}, "10 1\n"};
+			names_gates[ID($_ORNOT_)] = {{ID(A), ID(B), ID(Y)}, "1- 1\n-0 1\n"};
+			names_gates[ID($_AOI3_)] = {{ID(A), ID(B), ID(C), ID(Y)}, "-00 1\n0-0 1\n"};
+			names_gates[ID($_OAI3_)] = {{ID(A), ID(B), ID(C), ID(Y)}, "00- 1\n--0 1\n"};
+			names_gates[ID($_AOI4_)] = {{ID(A), ID(B), ID(C), ID(D), ID(Y)}, "-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n"};
+			names_gates[ID($_OAI4_)] = {{ID(A), ID(B), ID(C), ID(D), ID(Y)}, "00-- 1\n--00 1\n"};
+			names_gates[ID($_MUX_)] = {{ID(A), ID(B), ID(S), ID(Y)}, "1-0 1\n-11 1\n"};
+			names_gates[ID($_NMUX_)] = {{ID(A), ID(B), ID(S), ID(Y)}, "0-0 1\n-01 1\n"};
+
+			latch_gates[ID($_FF_)] = {nullptr, RTLIL::IdString()};
+			latch_gates[ID($_DFF_N_)] = {"fe", ID(C)};
+			latch_gates[ID($_DFF_P_)] = {"re", ID(C)};
+			latch_gates[ID($_DLATCH_N_)] = {"al", ID(E)};
+			latch_gates[ID($_DLATCH_P_)] = {"ah", ID(E)};
+
+			id_lut = ID($lut);
+			id_sop = ID($sop);
+		}
+
+		id_A = ID(A);
+		id_Y = ID(Y);
+		id_D = ID(D);
+		id_Q = ID(Q);
+		id_init = ID(init);
+		id_WIDTH = ID(WIDTH);
+		id_DEPTH = ID(DEPTH);
+		id_LUT = ID(LUT);
+		id_TABLE = ID(TABLE);
+
+		true_cmd = subckt_or_gate(design, RTLIL::escape_id(true_type));
+		false_cmd = subckt_or_gate(design, RTLIL::escape_id(false_type));
+		undef_cmd = subckt_or_gate(design, RTLIL::escape_id(undef_type));
+		buf_cmd = subckt_or_gate(design, RTLIL::escape_id(buf_type));
+
+		settle_for_concurrent_reads(names_gates);
+		settle_for_concurrent_reads(latch_gates);
+		settle_for_concurrent_reads(design->modules_);
+		for (auto &it : design->modules_) {
+			settle_for_concurrent_reads(it.second->wires_);
+			settle_for_concurrent_reads(it.second->attributes);
+		}
+	}
 };
 
 struct BlifDumper
 {
-	std::ostream &f;
+	// Output is formatted into 'out' and handed to 'f' in large blocks. Without
+	// an output stream everything is kept in 'out' for the caller to collect.
+	std::ostream *f;
+	std::string out;
 	RTLIL::Module *module;
 	RTLIL::Design *design;
 	BlifDumperConfig *config;
-	CellTypes ct;
 
 	SigMap sigmap;
 	dict<SigBit, int> init_bits;
 
-	BlifDumper(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig *config) :
-			f(f), module(module), design(design), config(config), ct(design), sigmap(module)
+	// Net names are built once per wire, in a flat array with a slice for
+	// every wire that starts at its entry in 'wire_offsets'.
+	dict<const RTLIL::Wire*, int> wire_offsets;
+	vector<std::string> bit_names;
+	std::string false_name, true_name, undef_name;
+	pool<SigBit> bits_seen;
+
+	BlifDumper(std::ostream *f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig *config) :
+			f(f), module(module), design(design), config(config), sigmap(module)
 	{
 		for (Wire *wire : module->wires())
-			if (wire->attributes.count("\\init")) {
+			if (wire->attributes.count(config->id_init)) {
 				SigSpec initsig = sigmap(wire);
-				Const initval = wire->attributes.at("\\init");
+				const Const &initval = wire->attributes.at(config->id_init);
 				for (int i = 0; i < GetSize(initsig) && i < GetSize(initval); i++)
 					switch (initval[i]) {
 						case State::S0:
@@ -84,91 +183,162 @@ struct BlifDumper
 							break;
 					}
 			}
+
+		false_name = config->false_type == "-" || config->false_type == "+" ? config->false_out : "$false";
+		true_name = config->true_type == "-" || config->true_type == "+" ? config->true_out : "$true";
+		undef_name = config->undef_type == "-" || config->undef_type == "+" ? config->undef_out : "$undef";
 	}
 
-	vector<shared_str> cstr_buf;
-	pool<SigBit> cstr_bits_seen;
+	void flush()
+	{
+		if (f != nullptr) {
+			f->write(out.data(), out.size());
+			out.clear();
+		}
+	}
 
-	const char *cstr(RTLIL::IdString id)
+	void maybe_flush()
 	{
-		std::string str = RTLIL::unescape_id(id);
-		for (size_t i = 0; i < str.size(); i++)
-			if (str[i] == '#' || str[i] == '=' || str[i] == '<' || str[i] == '>')
-				str[i] = '?';
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+		if (GetSize(out) >= 1 << 20)
+			flush();
 	}
 
-	const char *cstr(RTLIL::SigBit sig)
+	void put_int(int value)
 	{
-		cstr_bits_seen.insert(sig);
+		char buf[16], *p = buf + sizeof(buf);
+		unsigned int v = value < 0 ? 0u - (unsigned int)value : value;
+		do {
+			*--p = '0' + v % 10;
+			v /= 10;
+		} while (v != 0);
+		if (value < 0)
+			*--p = '-';
+		out.append(p, buf + sizeof(buf) - p);
+	}
+
+	// Same as RTLIL::unescape_id(id), with the characters that have a meaning
+	// in BLIF replaced by '?' unless 'raw' is set.
+	void put_id(const RTLIL::IdString &id, bool raw = false)
+	{
+		const char *str = id.c_str();
+		if (str[0] == '\\' && str[1] != 0 && str[1] != '$' && str[1] != '\\' && (str[1] < '0' || str[1] > '9'))
+			str++;
+		if (raw) {
+			out += str;
+			return;
+		}
+		for (const char *p = str; *p; p++)
+			out += *p == '#' || *p == '=' || *p == '<' || *p == '>' ? '?' : *p;
+	}
+
+	void put_bit(RTLIL::SigBit sig)
+	{
+		if (config->noalias_mode)
+			bits_seen.insert(sig);
 
 		if (sig.wire == NULL) {
-			if (sig == RTLIL::State::S0) return config->false_type == "-" || config->false_type == "+" ? config->false_out.c_str() : "$false";
-			if (sig == RTLIL::State::S1) return config->true_type == "-" || config->true_type == "+" ? config->true_out.c_str() : "$true";
-			return config->undef_type == "-" || config->undef_type == "+" ? config->undef_out.c_str() : "$undef";
+			if (sig == RTLIL::State::S0) out += false_name;
+			else if (sig == RTLIL::State::S1) out += true_name;
+			else out += undef_name;
+			return;
 		}
 
-		std::string str = RTLIL::unescape_id(sig.wire->name);
-		for (size_t i = 0; i < str.size(); i++)
-			if (str[i] == '#' || str[i] == '=' || str[i] == '<' || str[i] == '>')
-				str[i] = '?';
+		auto it = wire_offsets.find(sig.wire);
+		int offset;
+		if (it == wire_offsets.end()) {
+			offset = GetSize(bit_names);
+			wire_offsets[sig.wire] = offset;
 
-		if (sig.wire->width != 1)
-			str += stringf("[%d]", sig.wire->upto ? sig.wire->start_offset+sig.wire->width-sig.offset-1 : sig.wire->start_offset+sig.offset);
+			std::string prefix, str;
+			std::swap(out, prefix);
+			put_id(sig.wire->name);
+			std::swap(out, prefix);
 
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+			for (int i = 0; i < sig.wire->width; i++) {
+				str = prefix;
+				if (sig.wire->width != 1)
+					str += stringf("[%d]", sig.wire->upto ? sig.wire->start_offset+sig.wire->width-i-1 : sig.wire->start_offset+i);
+				bit_names.push_back(str);
+			}
+		} else
+			offset = it->second;
+
+		out += bit_names[offset + sig.offset];
 	}
 
-	const char *cstr_init(RTLIL::SigBit sig)
+	void put_init(RTLIL::SigBit sig)
 	{
 		sigmap.apply(sig);
 
-		if (init_bits.count(sig) == 0)
-			return " 2";
+		auto it = init_bits.find(sig);
+		if (it == init_bits.end())
+			out += " 2";
+		else
+			out += it->second ? " 1" : " 0";
+	}
 
-		string str = stringf(" %d", init_bits.at(sig));
+	const RTLIL::SigSpec &port(const RTLIL::Cell *cell, const RTLIL::IdString &name)
+	{
+		return cell->connections().at(name);
+	}
 
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+	void put_names(RTLIL::Cell *cell, const BlifDumperConfig::NamesGate &gate)
+	{
+		out += ".names";
+		for (auto &name : gate.ports) {
+			out += ' ';
+			put_bit(port(cell, name));
+		}
+		out += '\n';
+		out += gate.table;
 	}
 
-	const char *subckt_or_gate(std::string cell_type)
+	void put_latch(RTLIL::Cell *cell, const BlifDumperConfig::LatchGate &gate)
 	{
-		if (!config->gates_mode)
-			return "subckt";
-		if (!design->modules_.count(RTLIL::escape_id(cell_type)))
-			return "gate";
-		if (design->modules_.at(RTLIL::escape_id(cell_type))->get_blackbox_attribute())
-			return "gate";
-		return "subckt";
+		out += ".latch ";
+		put_bit(port(cell, config->id_D));
+		out += ' ';
+		put_bit(port(cell, config->id_Q));
+		if (gate.type != nullptr) {
+			out += ' ';
+			out += gate.type;
+			out += ' ';
+			put_bit(port(cell, gate.ctrl));
+		}
+		put_init(port(cell, config->id_Q));
+		out += '\n';
 	}
 
 	void dump_params(const char *command, dict<IdString, Const> &params)
 	{
 		for (auto &param : params) {
-			f << stringf("%s %s ", command, RTLIL::id2cstr(param.first));
+			out += command;
+			out += ' ';
+			put_id(param.first, true);
+			out += ' ';
 			if (param.second.flags & RTLIL::CONST_FLAG_STRING) {
 				std::string str = param.second.decode_string();
-				f << stringf("\"");
+				out += '"';
 				for (char ch : str)
 					if (ch == '"' || ch == '\\')
-						f << stringf("\\%c", ch);
+						out += stringf("\\%c", ch);
 					else if (ch < 32 || ch >= 127)
-						f << stringf("\\%03o", ch);
+						out += stringf("\\%03o", ch);
 					else
-						f << stringf("%c", ch);
-				f << stringf("\"\n");
-			} else
-				f << stringf("%s\n", param.second.as_string().c_str());
+						out += ch;
+				out += "\"\n";
+			} else {
+				out += param.second.as_string();
+				out += '\n';
+			}
 		}
 	}
 
 	void dump()
 	{
-		f << stringf("\n");
-		f << stringf(".model %s\n", cstr(module->name));
+		out += "\n.model ";
+		put_id(module->name);
+		out += '\n';
 
 		std::map<int, RTLIL::Wire*> inputs, outputs;
 
@@ -180,267 +350,191 @@ struct BlifDumper
 				outputs[wire->port_id] = wire;
 		}
 
-		f << stringf(".inputs");
+		out += ".inputs";
 		for (auto &it : inputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", cstr(RTLIL::SigSpec(wire, i)));
+			for (int i = 0; i < wire->width; i++) {
+				out += ' ';
+				put_bit(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		out += '\n';
 
-		f << stringf(".outputs");
+		out += ".outputs";
 		for (auto &it : outputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", cstr(RTLIL::SigSpec(wire, i)));
+			for (int i = 0; i < wire->width; i++) {
+				out += ' ';
+				put_bit(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		out += '\n';
 
-		if (module->get_blackbox_attribute()) {
-			f << stringf(".blackbox\n");
-			f << stringf(".end\n");
+		if (BlifDumperConfig::is_blackbox(module)) {
+			out += ".blackbox\n";
+			out += ".end\n";
+			flush();
 			return;
 		}
 
 		if (!config->impltf_mode) {
 			if (!config->false_type.empty()) {
 				if (config->false_type == "+")
-					f << stringf(".names %s\n", config->false_out.c_str());
+					out += stringf(".names %s\n", config->false_out.c_str());
 				else if (config->false_type != "-")
-					f << stringf(".%s %s %s=$false\n", subckt_or_gate(config->false_type),
+					out += stringf(".%s %s %s=$false\n", config->false_cmd.c_str(),
 							config->false_type.c_str(), config->false_out.c_str());
 			} else
-				f << stringf(".names $false\n");
+				out += ".names $false\n";
 			if (!config->true_type.empty()) {
 				if (config->true_type == "+")
-					f << stringf(".names %s\n1\n", config->true_out.c_str());
+					out += stringf(".names %s\n1\n", config->true_out.c_str());
 				else if (config->true_type != "-")
-					f << stringf(".%s %s %s=$true\n", subckt_or_gate(config->true_type),
+					out += stringf(".%s %s %s=$true\n", config->true_cmd.c_str(),
 							config->true_type.c_str(), config->true_out.c_str());
 			} else
-				f << stringf(".names $true\n1\n");
+				out += ".names $true\n1\n";
 			if (!config->undef_type.empty()) {
 				if (config->undef_type == "+")
-					f << stringf(".names %s\n", config->undef_out.c_str());
+					out += stringf(".names %s\n", config->undef_out.c_str());
 				else if (config->undef_type != "-")
-					f << stringf(".%s %s %s=$undef\n", subckt_or_gate(config->undef_type),
+					out += stringf(".%s %s %s=$undef\n", config->undef_cmd.c_str(),
 							config->undef_type.c_str(), config->undef_out.c_str());
 			} else
-				f << stringf(".names $undef\n");
+				out += ".names $undef\n";
 		}
 
 		for (auto &cell_it : module->cells_)
 		{
 			RTLIL::Cell *cell = cell_it.second;
-
-			if (config->unbuf_types.count(cell->type)) {
-				auto portnames = config->unbuf_types.at(cell->type);
-				f << stringf(".names %s %s\n1 1\n",
-						cstr(cell->getPort(portnames.first)), cstr(cell->getPort(portnames.second)));
+			maybe_flush();
+
+			auto unbuf_it = config->unbuf_types.find(cell->type);
+			if (unbuf_it != config->unbuf_types.end()) {
+				out += ".names ";
+				put_bit(port(cell, unbuf_it->second.first));
+				out += ' ';
+				put_bit(port(cell, unbuf_it->second.second));
+				out += "\n1 1\n";
 				continue;
 			}
 
-			if (!config->icells_mode && cell->type == "$_NOT_") {
-				f << stringf(".names %s %s\n0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_AND_") {
-				f << stringf(".names %s %s %s\n11 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_OR_") {
-				f << stringf(".names %s %s %s\n1- 1\n-1 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_XOR_") {
-				f << stringf(".names %s %s %s\n10 1\n01 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_NAND_") {
-				f << stringf(".names %s %s %s\n0- 1\n-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_NOR_") {
-				f << stringf(".names %s %s %s\n00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_XNOR_") {
-				f << stringf(".names %s %s %s\n11 1\n00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_ANDNOT_") {
-				f << stringf(".names %s %s %s\n10 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_ORNOT_") {
-				f << stringf(".names %s %s %s\n1- 1\n-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_AOI3_") {
-				f << stringf(".names %s %s %s %s\n-00 1\n0-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\C")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_OAI3_") {
-				f << stringf(".names %s %s %s %s\n00- 1\n--0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\C")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_AOI4_") {
-				f << stringf(".names %s %s %s %s %s\n-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\C")), cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_OAI4_") {
-				f << stringf(".names %s %s %s %s %s\n00-- 1\n--00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\C")), cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_MUX_") {
-				f << stringf(".names %s %s %s %s\n1-0 1\n-11 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\S")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_NMUX_") {
-				f << stringf(".names %s %s %s %s\n0-0 1\n-01 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\S")), cstr(cell->getPort("\\Y")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_FF_") {
-				f << stringf(".latch %s %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr_init(cell->getPort("\\Q")));
+			auto names_it = config->names_gates.find(cell->type);
+			if (names_it != config->names_gates.end()) {
+				put_names(cell, names_it->second);
 				goto internal_cell;
 			}
 
-			if (!config->icells_mode && cell->type == "$_DFF_N_") {
-				f << stringf(".latch %s %s fe %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\C")), cstr_init(cell->getPort("\\Q")));
+			if (config->latch_gates.count(cell->type)) {
+				put_latch(cell, config->latch_gates.at(cell->type));
 				goto internal_cell;
 			}
 
-			if (!config->icells_mode && cell->type == "$_DFF_P_") {
-				f << stringf(".latch %s %s re %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\C")), cstr_init(cell->getPort("\\Q")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_DLATCH_N_") {
-				f << stringf(".latch %s %s al %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\E")), cstr_init(cell->getPort("\\Q")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$_DLATCH_P_") {
-				f << stringf(".latch %s %s ah %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\E")), cstr_init(cell->getPort("\\Q")));
-				goto internal_cell;
-			}
-
-			if (!config->icells_mode && cell->type == "$lut") {
-				f << stringf(".names");
-				auto &inputs = cell->getPort("\\A");
-				auto width = cell->parameters.at("\\WIDTH").as_int();
+			if (!config->icells_mode && cell->type == config->id_lut) {
+				out += ".names";
+				auto &inputs = port(cell, config->id_A);
+				auto width = cell->parameters.at(config->id_WIDTH).as_int();
 				log_assert(inputs.size() == width);
-				for (int i = width-1; i >= 0; i--)
-					f << stringf(" %s", cstr(inputs.extract(i, 1)));
-				auto &output = cell->getPort("\\Y");
+				for (int i = width-1; i >= 0; i--) {
+					out += ' ';
+					put_bit(inputs[i]);
+				}
+				auto &output = port(cell, config->id_Y);
 				log_assert(output.size() == 1);
-				f << stringf(" %s", cstr(output));
-				f << stringf("\n");
-				RTLIL::SigSpec mask = cell->parameters.at("\\LUT");
+				out += ' ';
+				put_bit(output);
+				out += '\n';
+				RTLIL::SigSpec mask = cell->parameters.at(config->id_LUT);
 				for (int i = 0; i < (1 << width); i++)
 					if (mask[i] == State::S1) {
 						for (int j = width-1; j >= 0; j--) {
-							f << ((i>>j)&1 ? '1' : '0');
+							out += (i>>j)&1 ? '1' : '0';
 						}
-						f << " 1\n";
+						out += " 1\n";
 					}
 				goto internal_cell;
 			}
 
-			if (!config->icells_mode && cell->type == "$sop") {
-				f << stringf(".names");
-				auto &inputs = cell->getPort("\\A");
-				auto width = cell->parameters.at("\\WIDTH").as_int();
-				auto depth = cell->parameters.at("\\DEPTH").as_int();
-				vector<State> table = cell->parameters.at("\\TABLE").bits;
+			if (!config->icells_mode && cell->type == config->id_sop) {
+				out += ".names";
+				auto &inputs = port(cell, config->id_A);
+				auto width = cell->parameters.at(config->id_WIDTH).as_int();
+				auto depth = cell->parameters.at(config->id_DEPTH).as_int();
+				vector<State> table = cell->parameters.at(config->id_TABLE).bits;
 				while (GetSize(table) < 2*width*depth)
 					table.push_back(State::S0);
 				log_assert(inputs.size() == width);
-				for (int i = 0; i < width; i++)
-					f << stringf(" %s", cstr(inputs.extract(i, 1)));
-				auto &output = cell->getPort("\\Y");
+				for (int i = 0; i < width; i++) {
+					out += ' ';
+					put_bit(inputs[i]);
+				}
+				auto &output = port(cell, config->id_Y);
 				log_assert(output.size() == 1);
-				f << stringf(" %s", cstr(output));
-				f << stringf("\n");
+				out += ' ';
+				put_bit(output);
+				out += '\n';
 				for (int i = 0; i < depth; i++) {
 					for (int j = 0; j < width; j++) {
 						bool pat0 = table.at(2*width*i + 2*j + 0) == State::S1;
 						bool pat1 = table.at(2*width*i + 2*j + 1) == State::S1;
-						if (pat0 && !pat1) f << "0";
-						else if (!pat0 && pat1) f << "1";
-						else f << "-";
+						if (pat0 && !pat1) out += '0';
+						else if (!pat0 && pat1) out += '1';
+						else out += '-';
 					}
-					f << " 1\n";
+					out += " 1\n";
 				}
 				goto internal_cell;
 			}
 
-			f << stringf(".%s %s", subckt_or_gate(cell->type.str()), cstr(cell->type));
+			out += '.';
+			out += config->subckt_or_gate(design, cell->type);
+			out += ' ';
+			put_id(cell->type);
 			for (auto &conn : cell->connections())
 			{
 				if (conn.second.size() == 1) {
-					f << stringf(" %s=%s", cstr(conn.first), cstr(conn.second[0]));
+					out += ' ';
+					put_id(conn.first);
+					out += '=';
+					put_bit(conn.second[0]);
 					continue;
 				}
 
-				Module *m = design->module(cell->type);
-				Wire *w = m ? m->wire(conn.first) : nullptr;
+				auto mod_it = design->modules_.find(cell->type);
+				Wire *w = nullptr;
+				if (mod_it != design->modules_.end()) {
+					auto wire_it = mod_it->second->wires_.find(conn.first);
+					if (wire_it != mod_it->second->wires_.end())
+						w = wire_it->second;
+				}
 
 				if (w == nullptr) {
-					for (int i = 0; i < GetSize(conn.second); i++)
-						f << stringf(" %s[%d]=%s", cstr(conn.first), i, cstr(conn.second[i]));
+					for (int i = 0; i < GetSize(conn.second); i++) {
+						out += ' ';
+						put_id(conn.first);
+						out += '[';
+						put_int(i);
+						out += "]=";
+						put_bit(conn.second[i]);
+					}
 				} else {
 					for (int i = 0; i < std::min(GetSize(conn.second), GetSize(w)); i++) {
-						SigBit sig(w, i);
-						f << stringf(" %s[%d]=%s", cstr(conn.first), sig.wire->upto ?
-								sig.wire->start_offset+sig.wire->width-sig.offset-1 :
-								sig.wire->start_offset+sig.offset, cstr(conn.second[i]));
+						out += ' ';
+						put_id(conn.first);
+						out += '[';
+						put_int(w->upto ? w->start_offset+w->width-i-1 : w->start_offset+i);
+						out += "]=";
+						put_bit(conn.second[i]);
 					}
 				}
 			}
-			f << stringf("\n");
+			out += '\n';
 
-			if (config->cname_mode)
-				f << stringf(".cname %s\n", cstr(cell->name));
+			if (config->cname_mode) {
+				out += ".cname ";
+				put_id(cell->name);
+				out += '\n';
+			}
 			if (config->attr_mode)
 				dump_params(".attr", cell->attributes);
 			if (config->param_mode)
@@ -448,8 +542,11 @@ struct BlifDumper
 
 			if (0) {
 		internal_cell:
-				if (config->iname_mode)
-					f << stringf(".cname %s\n", cstr(cell->name));
+				if (config->iname_mode) {
+					out += ".cname ";
+					put_id(cell->name);
+					out += '\n';
+				}
 				if (config->iattr_mode)
 					dump_params(".attr", cell->attributes);
 			}
@@ -461,25 +558,35 @@ struct BlifDumper
 			SigBit lhs_bit = conn.first[i];
 			SigBit rhs_bit = conn.second[i];
 
-			if (config->noalias_mode && cstr_bits_seen.count(lhs_bit) == 0)
+			if (config->noalias_mode && bits_seen.count(lhs_bit) == 0)
 				continue;
 
-			if (config->conn_mode)
-				f << stringf(".conn %s %s\n", cstr(rhs_bit), cstr(lhs_bit));
-			else if (!config->buf_type.empty())
-				f << stringf(".%s %s %s=%s %s=%s\n", subckt_or_gate(config->buf_type), config->buf_type.c_str(),
-						config->buf_in.c_str(), cstr(rhs_bit), config->buf_out.c_str(), cstr(lhs_bit));
-			else
-				f << stringf(".names %s %s\n1 1\n", cstr(rhs_bit), cstr(lhs_bit));
+			if (config->conn_mode) {
+				out += ".conn ";
+				put_bit(rhs_bit);
+				out += ' ';
+				put_bit(lhs_bit);
+				out += '\n';
+			} else if (!config->buf_type.empty()) {
+				out += stringf(".%s %s %s=", config->buf_cmd.c_str(), config->buf_type.c_str(), config->buf_in.c_str());
+				put_bit(rhs_bit);
+				out += ' ';
+				out += config->buf_out;
+				out += '=';
+				put_bit(lhs_bit);
+				out += '\n';
+			} else {
+				out += ".names ";
+				put_bit(rhs_bit);
+				out += ' ';
+				put_bit(lhs_bit);
+				out += "\n1 1\n";
+			}
+			maybe_flush();
 		}
 
-		f << stringf(".end\n");
-	}
-
-	static void dump(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig &config)
-	{
-		BlifDumper dumper(f, module, design, &config);
-		dumper.dump();
+		out += ".end\n";
+		flush();
 	}
 };
 
@@ -554,6 +661,10 @@ struct BlifBackend : public Backend {
 		log("    -impltf\n");
 		log("        do not write definitions for the $true, $false and $undef wires.\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        generate the BLIF code for N modules at once on separate threads.\n");
+		log("        N may be zero to use all available cores. (default = 1)\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
@@ -562,6 +673,7 @@ struct BlifBackend : public Backend {
 		std::string true_type, true_out;
 		std::string false_type, false_out;
 		BlifDumperConfig config;
+		int num_threads = 1;
 
 		log_header(design, "Executing BLIF backend.\n");
 
@@ -644,6 +756,10 @@ struct BlifBackend : public Backend {
 				config.noalias_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -670,7 +786,7 @@ struct BlifBackend : public Backend {
 				log_error("Found unmapped memories in module %s: unmapped memories are not supported in BLIF backend!\n", RTLIL::id2cstr(module->name));
 
 			if (module->name == RTLIL::escape_id(top_module_name)) {
-				BlifDumper::dump(*f, module, design, config);
+				mod_list.insert(mod_list.begin(), module);
 				top_module_name.clear();
 				continue;
 			}
@@ -681,8 +797,40 @@ struct BlifBackend : public Backend {
 		if (!top_module_name.empty())
 			log_error("Can't find top module `%s'!\n", top_module_name.c_str());
 
-		for (auto module : mod_list)
-			BlifDumper::dump(*f, module, design, config);
+		config.setup(design);
+
+		if (num_threads > 1 && GetSize(mod_list) > 1)
+		{
+			// Every module is written into its own buffer. The modules are
+			// handled in batches of a few modules per thread, and the buffers
+			// of a batch are written in the original order before the next
+			// batch starts.
+			int batch_size = 4 * num_threads;
+			vector<string> buffers;
+			for (int begin = 0; begin < GetSize(mod_list); begin += batch_size)
+			{
+				int count = std::min(batch_size, GetSize(mod_list) - begin);
+				buffers.clear();
+				buffers.resize(count);
+				parallel_for(num_threads, count, [&](int i) {
+					BlifDumper dumper(nullptr, mod_list[begin + i], design, &config);
+					dumper.dump();
+					buffers[i] = std::move(dumper.out);
+				});
+
+				for (auto &buffer : buffers) {
+					f->write(buffer.data(), buffer.size());
+					string().swap(buffer);
+				}
+			}
+		}
+		else
+		{
+			for (auto module : mod_list) {
+				BlifDumper dumper(f, module, design, &config);
+				dumper.dump();
+			}
+		}
 	}
 } BlifBackend;
 
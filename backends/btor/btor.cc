@@ -39,6 +39,11 @@ struct BtorWorker
 	RTLIL::Module *module;
 	bool verbose;
 	bool single_bad;
+	string props_prefix;
+
+	// output is collected here and written to f in large blocks. with
+	// props_prefix the whole model is kept for the property files.
+	string buffer;
 
 	int next_nid = 1;
 	int initstate_nid = -1;
@@ -64,27 +69,57 @@ struct BtorWorker
 	// nids for constants
 	dict<Const, int> consts;
 
+	// (<nid>, <upper>, <lower>) => <nid>
+	dict<std::tuple<int, int, int>, int> slice_nids;
+
+	// (<nid-high>, <nid-low>) => <nid>
+	dict<pair<int, int>, int> concat_nids;
+
+	// (<nid>, <extra-width>, <signed>) => <nid>
+	dict<std::tuple<int, int, int>, int> ext_nids;
+
 	// ff inputs that need to be evaluated (<nid>, <ff_cell>)
 	vector<pair<int, Cell*>> ff_todo;
 
 	pool<Cell*> cell_recursion_guard;
 	vector<int> bad_properties;
+	vector<pair<int, string>> props;
 	dict<SigBit, bool> initbits;
 	pool<Wire*> statewires;
 	string indent;
 
+	void flush()
+	{
+		f.write(buffer.data(), buffer.size());
+		buffer.clear();
+	}
+
 	void btorf(const char *fmt, ...)
 	{
-		va_list ap;
+		va_list ap, ap2;
 		va_start(ap, fmt);
-		f << indent << vstringf(fmt, ap);
+		va_copy(ap2, ap);
+
+		char str[256];
+		int len = vsnprintf(str, sizeof(str), fmt, ap);
+
+		buffer += indent;
+		if (len >= 0 && len < int(sizeof(str)))
+			buffer.append(str, len);
+		else
+			buffer += vstringf(fmt, ap2);
+
+		va_end(ap2);
 		va_end(ap);
+
+		if (props_prefix.empty() && GetSize(buffer) >= 1 << 20)
+			flush();
 	}
 
 	void btorf_push(const string &id)
 	{
 		if (verbose) {
-			f << indent << stringf("  ; begin %s\n", id.c_str());
+			btorf("  ; begin %s\n", id.c_str());
 			indent += "    ";
 		}
 	}
@@ -93,7 +128,7 @@ struct BtorWorker
 	{
 		if (verbose) {
 			indent = indent.substr(4);
-			f << indent << stringf("  ; end %s\n", id.c_str());
+			btorf("  ; end %s\n", id.c_str());
 		}
 	}
 
@@ -120,10 +155,55 @@ struct BtorWorker
 		return sorts_mem.at(key);
 	}
 
+	// slice, concat and extension nodes are structurally hashed, so that
+	// repeated slices and concatenations of the same signals are emitted once
+
+	int get_slice_nid(int nid, int upper, int lower)
+	{
+		auto key = std::make_tuple(nid, upper, lower);
+		auto it = slice_nids.find(key);
+		if (it != slice_nids.end())
+			return it->second;
+
+		int sid = get_bv_sid(upper-lower+1);
+		int nid2 = next_nid++;
+		btorf("%d slice %d %d %d %d\n", nid2, sid, nid, upper, lower);
+		slice_nids[key] = nid2;
+		return nid2;
+	}
+
+	int get_concat_nid(int width, int nid_high, int nid_low)
+	{
+		auto key = make_pair(nid_high, nid_low);
+		auto it = concat_nids.find(key);
+		if (it != concat_nids.end())
+			return it->second;
+
+		int sid = get_bv_sid(width);
+		int nid = next_nid++;
+		btorf("%d concat %d %d %d\n", nid, sid, nid_high, nid_low);
+		concat_nids[key] = nid;
+		return nid;
+	}
+
+	int get_ext_nid(int width, int nid, int extra_width, bool is_signed)
+	{
+		auto key = std::make_tuple(nid, extra_width, int(is_signed));
+		auto it = ext_nids.find(key);
+		if (it != ext_nids.end())
+			return it->second;
+
+		int sid = get_bv_sid(width);
+		int nid2 = next_nid++;
+		btorf("%d %s %d %d %d\n", nid2, is_signed ? "sext" : "uext", sid, nid, extra_width);
+		ext_nids[key] = nid2;
+		return nid2;
+	}
+
 	void add_nid_sig(int nid, const SigSpec &sig)
 	{
 		if (verbose)
-			f << indent << stringf("; %d %s\n", nid, log_signal(sig));
+			btorf("; %d %s\n", nid, log_signal(sig));
 
 		for (int i = 0; i < GetSize(sig); i++)
 			bit_nid[sig[i]] = make_pair(nid, i);
@@ -936,19 +1016,13 @@ struct BtorWorker
 
 				int nid3 = nid2;
 
-				if (lower != 0 || upper+1 != nid_width.at(nid2)) {
-					int sid = get_bv_sid(upper-lower+1);
-					nid3 = next_nid++;
-					btorf("%d slice %d %d %d %d\n", nid3, sid, nid2, upper, lower);
-				}
+				if (lower != 0 || upper+1 != nid_width.at(nid2))
+					nid3 = get_slice_nid(nid2, upper, lower);
 
 				int nid4 = nid3;
 
-				if (nid >= 0) {
-					int sid = get_bv_sid(width+upper-lower+1);
-					nid4 = next_nid++;
-					btorf("%d concat %d %d %d\n", nid4, sid, nid3, nid);
-				}
+				if (nid >= 0)
+					nid4 = get_concat_nid(width+upper-lower+1, nid3, nid);
 
 				width += upper-lower+1;
 				nid = nid4;
@@ -964,27 +1038,16 @@ struct BtorWorker
 		if (to_width >= 0 && to_width != GetSize(sig))
 		{
 			if (to_width < GetSize(sig))
-			{
-				int sid = get_bv_sid(to_width);
-				int nid2 = next_nid++;
-				btorf("%d slice %d %d %d 0\n", nid2, sid, nid, to_width-1);
-				nid = nid2;
-			}
+				nid = get_slice_nid(nid, to_width-1, 0);
 			else
-			{
-				int sid = get_bv_sid(to_width);
-				int nid2 = next_nid++;
-				btorf("%d %s %d %d %d\n", nid2, is_signed ? "sext" : "uext",
-						sid, nid, to_width - GetSize(sig));
-				nid = nid2;
-			}
+				nid = get_ext_nid(to_width, nid, to_width - GetSize(sig), is_signed);
 		}
 
 		return nid;
 	}
 
-	BtorWorker(std::ostream &f, RTLIL::Module *module, bool verbose, bool single_bad) :
-			f(f), sigmap(module), module(module), verbose(verbose), single_bad(single_bad)
+	BtorWorker(std::ostream &f, RTLIL::Module *module, bool verbose, bool single_bad, const string &props_prefix) :
+			f(f), sigmap(module), module(module), verbose(verbose), single_bad(single_bad), props_prefix(props_prefix)
 	{
 		btorf_push("inputs");
 
@@ -1069,13 +1132,15 @@ struct BtorWorker
 				if (single_bad) {
 					bad_properties.push_back(nid_en_and_not_a);
 				} else {
-					int nid = next_nid++;
 					string infostr = log_id(cell);
 					if (infostr[0] == '$' && cell->attributes.count("\\src")) {
 						infostr = cell->attributes.at("\\src").decode_string().c_str();
 						std::replace(infostr.begin(), infostr.end(), ' ', '_');
 					}
-					btorf("%d bad %d %s\n", nid, nid_en_and_not_a, infostr.c_str());
+					if (props_prefix.empty())
+						btorf("%d bad %d %s\n", next_nid++, nid_en_and_not_a, infostr.c_str());
+					else
+						props.push_back(make_pair(nid_en_and_not_a, infostr));
 				}
 
 				btorf_pop(log_id(cell));
@@ -1210,6 +1275,32 @@ struct BtorWorker
 				btorf("%d bad %d\n", nid, todo[cursor]);
 			}
 		}
+
+		if (!props_prefix.empty())
+		{
+			// The model is complete at this point. Every property file gets a
+			// copy of it followed by one bad property, the main output gets all.
+			for (int i = 0; i < GetSize(props); i++)
+			{
+				string filename = stringf("%s%d.btor", props_prefix.c_str(), i);
+				std::ofstream pf(filename.c_str(), std::ofstream::trunc);
+				if (pf.fail())
+					log_error("Can't open file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+
+				pf << stringf("; BTOR description generated by %s for module %s, property %s.\n",
+						yosys_version_str, log_id(module), props[i].second.c_str());
+				pf.write(buffer.data(), buffer.size());
+				pf << stringf("%d bad %d %s\n", next_nid, props[i].first, props[i].second.c_str());
+				pf << stringf("; end of yosys output\n");
+			}
+
+			for (auto &it : props)
+				btorf("%d bad %d %s\n", next_nid++, it.first, it.second.c_str());
+
+			log("Wrote %d property files %s<n>.btor.\n", GetSize(props), props_prefix.c_str());
+		}
+
+		flush();
 	}
 };
 
@@ -1229,10 +1320,16 @@ struct BtorBackend : public Backend {
 		log("  -s\n");
 		log("    Output only a single bad property for all asserts\n");
 		log("\n");
+		log("  -props <prefix>\n");
+		log("    Also write one file <prefix><n>.btor for every assert, numbered from 0.\n");
+		log("    Each file holds the model shared by all properties, followed by the bad\n");
+		log("    property of one assert. The model is only generated once.\n");
+		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		bool verbose = false, single_bad = false;
+		string props_prefix;
 
 		log_header(design, "Executing BTOR backend.\n");
 
@@ -1247,10 +1344,17 @@ struct BtorBackend : public Backend {
 				single_bad = true;
 				continue;
 			}
+			if (args[argidx] == "-props" && argidx+1 < args.size()) {
+				props_prefix = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
+		if (single_bad && !props_prefix.empty())
+			log_cmd_error("Options -s and -props are exclusive.\n");
+
 		RTLIL::Module *topmod = design->top_module();
 
 		if (topmod == nullptr)
@@ -1259,7 +1363,7 @@ struct BtorBackend : public Backend {
 		*f << stringf("; BTOR description generated by %s for module %s.\n",
 				yosys_version_str, log_id(topmod));
 
-		BtorWorker(*f, topmod, verbose, single_bad);
+		BtorWorker(*f, topmod, verbose, single_bad, props_prefix);
 
 		*f << stringf("; end of yosys output\n");
 	}
@@ -38,8 +38,8 @@ struct EdifNames
 {
 	int counter;
 	char delim_left, delim_right;
-	std::set<std::string> generated_names, used_names;
-	std::map<std::string, std::string> name_map;
+	pool<std::string> generated_names, used_names;
+	dict<std::string, std::string> name_map;
 
 	EdifNames() : counter(1), delim_left('['), delim_right(']') { }
 
@@ -88,6 +88,34 @@ struct EdifNames
 	}
 };
 
+// One end of a net: a bit of a port of a cell instance, or of a port of the
+// module itself (cell == nullptr). member is -1 for single-bit ports.
+struct EdifPortRef
+{
+	RTLIL::Cell *cell;
+	RTLIL::IdString port;
+	int member;
+	bool is_driver;
+
+	EdifPortRef(RTLIL::Cell *cell, RTLIL::IdString port, int member, bool is_driver) :
+			cell(cell), port(port), member(member), is_driver(is_driver) { }
+};
+
+// Same as log_signal(bit) without spaces and backslashes
+std::string edif_netname(RTLIL::SigBit bit)
+{
+	if (bit.wire == nullptr)
+		return bit == RTLIL::State::S0 ? "GND_NET" : "VCC_NET";
+
+	std::string netname;
+	for (const char *p = bit.wire->name.c_str(); *p; p++)
+		if (*p != ' ' && *p != '\\')
+			netname += *p;
+	if (bit.wire->width != 1)
+		netname += stringf("[%d]", bit.offset);
+	return netname;
+}
+
 struct EdifBackend : public Backend {
 	EdifBackend() : Backend("edif", "write design to EDIF netlist file") { }
 	void help() YS_OVERRIDE
@@ -332,7 +360,24 @@ struct EdifBackend : public Backend {
 				continue;
 
 			SigMap sigmap(module);
-			std::map<RTLIL::SigSpec, std::set<std::pair<std::string, bool>>> net_join_db;
+
+			// Nets are numbered in the order in which their (sigmapped) bits are
+			// first seen, every port bit connected to a net adds one reference.
+			dict<RTLIL::SigBit, int> net_ids;
+			std::vector<RTLIL::SigBit> net_bits;
+			std::vector<std::pair<int, EdifPortRef>> net_refs;
+
+			auto add_ref = [&](RTLIL::SigBit bit, const EdifPortRef &ref) {
+				auto it = net_ids.find(bit);
+				int net_id;
+				if (it == net_ids.end()) {
+					net_id = GetSize(net_bits);
+					net_ids[bit] = net_id;
+					net_bits.push_back(bit);
+				} else
+					net_id = it->second;
+				net_refs.push_back(std::make_pair(net_id, ref));
+			};
 
 			*f << stringf("    (cell %s\n", EDIF_DEF(module->name));
 			*f << stringf("      (cellType GENERIC)\n");
@@ -354,8 +399,7 @@ struct EdifBackend : public Backend {
 						for (auto &p : wire->attributes)
 							add_prop(p.first, p.second);
 					*f << ")\n";
-					RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire));
-					net_join_db[sig].insert(make_pair(stringf("(portRef %s)", EDIF_REF(wire->name)), wire->port_input));
+					add_ref(sigmap(RTLIL::SigBit(wire)), EdifPortRef(nullptr, wire->name, -1, wire->port_input));
 				} else {
 					int b[2];
 					b[wire->upto ? 0 : 1] = wire->start_offset;
@@ -366,10 +410,8 @@ struct EdifBackend : public Backend {
 							add_prop(p.first, p.second);
 
 					*f << ")\n";
-					for (int i = 0; i < wire->width; i++) {
-						RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire, i));
-						net_join_db[sig].insert(make_pair(stringf("(portRef (member %s %d))", EDIF_REF(wire->name), GetSize(wire)-i-1), wire->port_input));
-					}
+					for (int i = 0; i < wire->width; i++)
+						add_ref(sigmap(RTLIL::SigBit(wire, i)), EdifPortRef(nullptr, wire->name, GetSize(wire)-i-1, wire->port_input));
 				}
 			}
 			*f << stringf("        )\n");
@@ -380,71 +422,87 @@ struct EdifBackend : public Backend {
 			}
 			for (auto &cell_it : module->cells_) {
 				RTLIL::Cell *cell = cell_it.second;
-				*f << stringf("          (instance %s\n", EDIF_DEF(cell->name));
-				*f << stringf("            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_REF(cell->type),
-						lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
+				*f << "          (instance " << EDIF_DEF(cell->name) << "\n";
+				*f << "            (viewRef VIEW_NETLIST (cellRef " << EDIF_REF(cell->type)
+						<< (lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "") << "))";
 				for (auto &p : cell->parameters)
 					add_prop(p.first, p.second);
 				if (attr_properties)
 					for (auto &p : cell->attributes)
 						add_prop(p.first, p.second);
 
-				*f << stringf(")\n");
+				*f << ")\n";
+				auto m = design->module(cell->type);
 				for (auto &p : cell->connections()) {
 					RTLIL::SigSpec sig = sigmap(p.second);
+					int width = GetSize(sig);
+					if (m) {
+						auto w = m->wire(p.first);
+						if (w)
+							width = GetSize(w);
+					}
+					bool is_output = cell->output(p.first);
 					for (int i = 0; i < GetSize(sig); i++)
 						if (sig[i].wire == NULL && sig[i] != RTLIL::State::S0 && sig[i] != RTLIL::State::S1)
 							log_warning("Bit %d of cell port %s.%s.%s driven by %s will be left unconnected in EDIF output.\n",
 									i, log_id(module), log_id(cell), log_id(p.first), log_signal(sig[i]));
-						else {
-							int member_idx = GetSize(sig)-i-1;
-							auto m = design->module(cell->type);
-							int width = sig.size();
-							if (m) {
-								auto w = m->wire(p.first);
-								if (w) {
-									member_idx = GetSize(w)-i-1;
-									width = GetSize(w);
-								}
-							}
-							if (width == 1)
-								net_join_db[sig[i]].insert(make_pair(stringf("(portRef %s (instanceRef %s))", EDIF_REF(p.first), EDIF_REF(cell->name)), cell->output(p.first)));
-							else {
-								net_join_db[sig[i]].insert(make_pair(stringf("(portRef (member %s %d) (instanceRef %s))",
-										EDIF_REF(p.first), member_idx, EDIF_REF(cell->name)), cell->output(p.first)));
-							}
-						}
+						else
+							add_ref(sig[i], EdifPortRef(cell, p.first, width == 1 ? -1 : width-i-1, is_output));
 				}
 			}
-			for (auto &it : net_join_db) {
-				RTLIL::SigBit sig = it.first;
+
+			// group the references by net
+			std::vector<int> net_refs_begin(GetSize(net_bits)+1);
+			for (auto &it : net_refs)
+				net_refs_begin[it.first+1]++;
+			for (int i = 0; i < GetSize(net_bits); i++)
+				net_refs_begin[i+1] += net_refs_begin[i];
+			std::vector<const EdifPortRef*> refs_by_net(GetSize(net_refs));
+			{
+				std::vector<int> cursor(net_refs_begin.begin(), net_refs_begin.end()-1);
+				for (auto &it : net_refs)
+					refs_by_net[cursor[it.first]++] = &it.second;
+			}
+
+			auto write_ref = [&](const EdifPortRef &ref) {
+				*f << "            (portRef ";
+				if (ref.member < 0)
+					*f << EDIF_REF(ref.port);
+				else
+					*f << "(member " << EDIF_REF(ref.port) << " " << ref.member << ")";
+				if (ref.cell != nullptr)
+					*f << " (instanceRef " << EDIF_REF(ref.cell->name) << ")";
+				*f << ")\n";
+			};
+
+			auto ref_str = [&](const EdifPortRef &ref) {
+				std::string str = stringf("(portRef %s", EDIF_REF(ref.port));
+				if (ref.member >= 0)
+					str = stringf("(portRef (member %s %d)", EDIF_REF(ref.port), ref.member);
+				if (ref.cell != nullptr)
+					str += stringf(" (instanceRef %s)", EDIF_REF(ref.cell->name));
+				return str + ")";
+			};
+
+			for (int net_id = 0; net_id < GetSize(net_bits); net_id++) {
+				RTLIL::SigBit sig = net_bits[net_id];
+				int refs_begin = net_refs_begin[net_id], refs_end = net_refs_begin[net_id+1];
 				if (sig.wire == NULL && sig != RTLIL::State::S0 && sig != RTLIL::State::S1) {
 					if (sig == RTLIL::State::Sx) {
-						for (auto &ref : it.second)
-							log_warning("Exporting x-bit on %s as zero bit.\n", ref.first.c_str());
+						for (int i = refs_begin; i < refs_end; i++)
+							log_warning("Exporting x-bit on %s as zero bit.\n", ref_str(*refs_by_net[i]).c_str());
 						sig = RTLIL::State::S0;
 					} else if (sig == RTLIL::State::Sz) {
 						continue;
 					} else {
-						for (auto &ref : it.second)
-							log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref.first.c_str());
+						for (int i = refs_begin; i < refs_end; i++)
+							log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref_str(*refs_by_net[i]).c_str());
 						log_abort();
 					}
 				}
-				std::string netname;
-				if (sig == RTLIL::State::S0)
-					netname = "GND_NET";
-				else if (sig == RTLIL::State::S1)
-					netname = "VCC_NET";
-				else {
-					netname = log_signal(sig);
-					for (size_t i = 0; i < netname.size(); i++)
-						if (netname[i] == ' ' || netname[i] == '\\')
-							netname.erase(netname.begin() + i--);
-				}
-				*f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-				for (auto &ref : it.second)
-					*f << stringf("            %s\n", ref.first.c_str());
+				*f << "          (net " << EDIF_DEF(edif_netname(sig)) << " (joined\n";
+				for (int i = refs_begin; i < refs_end; i++)
+					write_ref(*refs_by_net[i]);
 				if (sig.wire == NULL) {
 					if (nogndvcc)
 						log_error("Design contains constant nodes (map with \"hilomap\" first).\n");
@@ -452,12 +510,12 @@ struct EdifBackend : public Backend {
 						*f << stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
 					if (sig == RTLIL::State::S1)
 						*f << stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
-				}				
-				*f << stringf("            )");
+				}
+				*f << "            )";
 				if (attr_properties && sig.wire != NULL)
 					for (auto &p : sig.wire->attributes)
 						add_prop(p.first, p.second);
-				*f << stringf("\n          )\n");
+				*f << "\n          )\n";
 			}
 			for (auto &wire_it : module->wires_) {
 				RTLIL::Wire *wire = wire_it.second;
@@ -466,17 +524,13 @@ struct EdifBackend : public Backend {
 				for(int i = 0; i < wire->width; i++) {
 					SigBit raw_sig = RTLIL::SigSpec(wire, i);
 					SigBit mapped_sig = sigmap(raw_sig);
-					if (raw_sig == mapped_sig || net_join_db.count(mapped_sig) == 0)
+					if (raw_sig == mapped_sig || net_ids.count(mapped_sig) == 0)
 						continue;
-					std::string netname = log_signal(raw_sig);
-					for (size_t i = 0; i < netname.size(); i++)
-						if (netname[i] == ' ' || netname[i] == '\\')
-							netname.erase(netname.begin() + i--);
-					*f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-					auto &refs = net_join_db.at(mapped_sig);
-					for (auto &ref : refs)
-						if (ref.second)
-							*f << stringf("            %s\n", ref.first.c_str());
+					*f << stringf("          (net %s (joined\n", EDIF_DEF(edif_netname(raw_sig)));
+					int net_id = net_ids.at(mapped_sig);
+					for (int j = net_refs_begin[net_id]; j < net_refs_begin[net_id+1]; j++)
+						if (refs_by_net[j]->is_driver)
+							write_ref(*refs_by_net[j]);
 					*f << stringf("            )");
 					if (attr_properties && raw_sig.wire != NULL)
 						for (auto &p : raw_sig.wire->attributes)
@@ -23,6 +23,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/cellaigs.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 #include <string>
 
 USING_YOSYS_NAMESPACE
@@ -30,7 +31,10 @@ PRIVATE_NAMESPACE_BEGIN
 
 struct JsonWriter
 {
-	std::ostream &f;
+	// Output is formatted into 'out' and handed to 'f' in large blocks. Without
+	// an output stream everything is kept in 'out' for the caller to collect.
+	std::ostream *f;
+	std::string out;
 	bool use_selection;
 	bool aig_mode;
 	bool compat_int_mode;
@@ -38,51 +42,102 @@ struct JsonWriter
 	Design *design;
 	Module *module;
 
+	// Bit IDs are stored in a flat array with a slice for every wire. Both the
+	// array and the index are reused from module to module.
 	SigMap sigmap;
 	int sigidcounter;
-	dict<SigBit, string> sigids;
+	dict<const Wire*, int> wire_offsets;
+	vector<int> sigids;
 	pool<Aig> aig_models;
 
-	JsonWriter(std::ostream &f, bool use_selection, bool aig_mode, bool compat_int_mode) :
+	JsonWriter(std::ostream *f, bool use_selection, bool aig_mode, bool compat_int_mode) :
 			f(f), use_selection(use_selection), aig_mode(aig_mode),
 			compat_int_mode(compat_int_mode) { }
 
-	string get_string(string str)
+	void flush()
 	{
-		string newstr = "\"";
-		for (char c : str) {
-			if (c == '\\')
-				newstr += c;
-			newstr += c;
+		if (f != nullptr) {
+			f->write(out.data(), out.size());
+			out.clear();
 		}
-		return newstr + "\"";
 	}
 
-	string get_name(IdString name)
+	void maybe_flush()
 	{
-		return get_string(RTLIL::unescape_id(name));
+		if (GetSize(out) >= 1 << 20)
+			flush();
 	}
 
-	string get_bits(SigSpec sig)
+	void put_uint(unsigned int value)
 	{
+		char buf[16], *p = buf + sizeof(buf);
+		do {
+			*--p = '0' + value % 10;
+			value /= 10;
+		} while (value != 0);
+		out.append(p, buf + sizeof(buf) - p);
+	}
+
+	void put_int(int value)
+	{
+		if (value < 0) {
+			out += '-';
+			put_uint(0u - (unsigned int)value);
+		} else
+			put_uint(value);
+	}
+
+	void put_string(const char *str)
+	{
+		out += '"';
+		for (const char *p = str; *p; p++) {
+			if (*p == '\\')
+				out += '\\';
+			out += *p;
+		}
+		out += '"';
+	}
+
+	void put_string(const string &str)
+	{
+		put_string(str.c_str());
+	}
+
+	// Same as put_string(RTLIL::unescape_id(name)), without the copies
+	void put_name(const IdString &name)
+	{
+		const char *str = name.c_str();
+		if (str[0] == '\\' && str[1] != 0 && str[1] != '$' && str[1] != '\\' && (str[1] < '0' || str[1] > '9'))
+			str++;
+		put_string(str);
+	}
+
+	void put_bits(const SigSpec &sig)
+	{
+		const Wire *last_wire = nullptr;
+		int last_offset = 0;
 		bool first = true;
-		string str = "[";
+		out += '[';
 		for (auto bit : sigmap(sig)) {
-			str += first ? " " : ", ";
+			out += first ? " " : ", ";
 			first = false;
-			if (sigids.count(bit) == 0) {
-				string &s = sigids[bit];
-				if (bit.wire == nullptr) {
-					if (bit == State::S0) s = "\"0\"";
-					else if (bit == State::S1) s = "\"1\"";
-					else if (bit == State::Sz) s = "\"z\"";
-					else s = "\"x\"";
-				} else
-					s = stringf("%d", sigidcounter++);
+			if (bit.wire == nullptr) {
+				if (bit == State::S0) out += "\"0\"";
+				else if (bit == State::S1) out += "\"1\"";
+				else if (bit == State::Sz) out += "\"z\"";
+				else out += "\"x\"";
+				continue;
 			}
-			str += sigids[bit];
+			if (bit.wire != last_wire) {
+				last_wire = bit.wire;
+				last_offset = wire_offsets.at(bit.wire);
+			}
+			int &id = sigids[last_offset + bit.offset];
+			if (id == 0)
+				id = sigidcounter++;
+			put_int(id);
 		}
-		return str + " ]";
+		out += " ]";
 	}
 
 	void write_parameter_value(const Const &value)
@@ -103,14 +158,14 @@ struct JsonWriter
 			}
 			if (state < 2)
 				str += " ";
-			f << get_string(str);
+			put_string(str);
 		} else if (compat_int_mode && GetSize(value) <= 32 && value.is_fully_def()) {
 			if ((value.flags & RTLIL::ConstFlags::CONST_FLAG_SIGNED) != 0)
-				f << stringf("%d", value.as_int());
+				put_int(value.as_int());
 			else
-				f << stringf("%u", value.as_int());
+				put_uint(value.as_int());
 		} else {
-			f << get_string(value.as_string());
+			put_string(value.as_string());
 		}
 	}
 
@@ -118,167 +173,284 @@ struct JsonWriter
 	{
 		bool first = true;
 		for (auto &param : parameters) {
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s%s: ", for_module ? "" : "    ", get_name(param.first).c_str());
+			out += first ? "\n" : ",\n";
+			out += for_module ? "        " : "            ";
+			put_name(param.first);
+			out += ": ";
 			write_parameter_value(param.second);
 			first = false;
 		}
 	}
 
+	// Same as Cell::known(), Cell::input() and Cell::output(), but looking up
+	// the IdStrings by reference, so that it is safe on worker threads.
+	bool cell_known(const Cell *cell)
+	{
+		return yosys_celltypes.cell_types.count(cell->type) || design->modules_.count(cell->type);
+	}
+
+	const char *port_direction(const Cell *cell, const IdString &port)
+	{
+		bool input = false, output = false;
+		auto ct = yosys_celltypes.cell_types.find(cell->type);
+		if (ct != yosys_celltypes.cell_types.end()) {
+			input = ct->second.inputs.count(port) != 0;
+			output = ct->second.outputs.count(port) != 0;
+		} else {
+			const Module *mod = design->modules_.at(cell->type);
+			auto it = mod->wires_.find(port);
+			if (it != mod->wires_.end()) {
+				input = it->second->port_input;
+				output = it->second->port_output;
+			}
+		}
+		if (input)
+			return output ? "inout" : "input";
+		return "output";
+	}
+
 	void write_module(Module *module_)
 	{
 		module = module_;
 		log_assert(module->design == design);
 		sigmap.set(module);
-		sigids.clear();
 
-		// reserve 0 and 1 to avoid confusion with "0" and "1"
+		// reserve 0 and 1 to avoid confusion with "0" and "1",
+		// 0 also marks bits that have no ID yet
 		sigidcounter = 2;
+		int num_bits = 0;
+		wire_offsets.clear();
+		for (auto w : module->wires()) {
+			wire_offsets[w] = num_bits;
+			num_bits += w->width;
+		}
+		sigids.assign(num_bits, 0);
 
-		f << stringf("    %s: {\n", get_name(module->name).c_str());
+		out += "    ";
+		put_name(module->name);
+		out += ": {\n";
 
-		f << stringf("      \"attributes\": {");
+		out += "      \"attributes\": {";
 		write_parameters(module->attributes, /*for_module=*/true);
-		f << stringf("\n      },\n");
+		out += "\n      },\n";
 
-		f << stringf("      \"ports\": {");
+		out += "      \"ports\": {";
 		bool first = true;
-		for (auto n : module->ports) {
-			Wire *w = module->wire(n);
+		for (auto &n : module->ports) {
+			Wire *w = module->wires_.at(n);
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(n).c_str());
-			f << stringf("          \"direction\": \"%s\",\n", w->port_input ? w->port_output ? "inout" : "input" : "output");
-			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
+			out += first ? "\n" : ",\n";
+			out += "        ";
+			put_name(n);
+			out += ": {\n";
+			out += "          \"direction\": \"";
+			out += w->port_input ? w->port_output ? "inout" : "input" : "output";
+			out += "\",\n";
+			if (w->start_offset) {
+				out += "          \"offset\": ";
+				put_int(w->start_offset);
+				out += ",\n";
+			}
 			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
-			f << stringf("          \"bits\": %s\n", get_bits(w).c_str());
-			f << stringf("        }");
+				out += "          \"upto\": 1,\n";
+			out += "          \"bits\": ";
+			put_bits(w);
+			out += "\n        }";
 			first = false;
 		}
-		f << stringf("\n      },\n");
+		out += "\n      },\n";
 
-		f << stringf("      \"cells\": {");
+		out += "      \"cells\": {";
 		first = true;
 		for (auto c : module->cells()) {
 			if (use_selection && !module->selected(c))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(c->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", c->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"type\": %s,\n", get_name(c->type).c_str());
+			out += first ? "\n" : ",\n";
+			out += "        ";
+			put_name(c->name);
+			out += ": {\n";
+			out += c->name[0] == '$' ? "          \"hide_name\": 1,\n" : "          \"hide_name\": 0,\n";
+			out += "          \"type\": ";
+			put_name(c->type);
+			out += ",\n";
 			if (aig_mode) {
 				Aig aig(c);
 				if (!aig.name.empty()) {
-					f << stringf("          \"model\": \"%s\",\n", aig.name.c_str());
+					out += "          \"model\": \"";
+					out += aig.name;
+					out += "\",\n";
 					aig_models.insert(aig);
 				}
 			}
-			f << stringf("          \"parameters\": {");
+			out += "          \"parameters\": {";
 			write_parameters(c->parameters);
-			f << stringf("\n          },\n");
-			f << stringf("          \"attributes\": {");
+			out += "\n          },\n";
+			out += "          \"attributes\": {";
 			write_parameters(c->attributes);
-			f << stringf("\n          },\n");
-			if (c->known()) {
-				f << stringf("          \"port_directions\": {");
+			out += "\n          },\n";
+			if (cell_known(c)) {
+				out += "          \"port_directions\": {";
 				bool first2 = true;
 				for (auto &conn : c->connections()) {
-					string direction = "output";
-					if (c->input(conn.first))
-						direction = c->output(conn.first) ? "inout" : "input";
-					f << stringf("%s\n", first2 ? "" : ",");
-					f << stringf("            %s: \"%s\"", get_name(conn.first).c_str(), direction.c_str());
+					const char *direction = port_direction(c, conn.first);
+					out += first2 ? "\n" : ",\n";
+					out += "            ";
+					put_name(conn.first);
+					out += ": \"";
+					out += direction;
+					out += "\"";
 					first2 = false;
 				}
-				f << stringf("\n          },\n");
+				out += "\n          },\n";
 			}
-			f << stringf("          \"connections\": {");
+			out += "          \"connections\": {";
 			bool first2 = true;
 			for (auto &conn : c->connections()) {
-				f << stringf("%s\n", first2 ? "" : ",");
-				f << stringf("            %s: %s", get_name(conn.first).c_str(), get_bits(conn.second).c_str());
+				out += first2 ? "\n" : ",\n";
+				out += "            ";
+				put_name(conn.first);
+				out += ": ";
+				put_bits(conn.second);
 				first2 = false;
 			}
-			f << stringf("\n          }\n");
-			f << stringf("        }");
+			out += "\n          }\n";
+			out += "        }";
 			first = false;
+			maybe_flush();
 		}
-		f << stringf("\n      },\n");
+		out += "\n      },\n";
 
-		f << stringf("      \"netnames\": {");
+		out += "      \"netnames\": {";
 		first = true;
 		for (auto w : module->wires()) {
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(w->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", w->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"bits\": %s,\n", get_bits(w).c_str());
-			if (w->start_offset)
-				f << stringf("          \"offset\": %d,\n", w->start_offset);
+			out += first ? "\n" : ",\n";
+			out += "        ";
+			put_name(w->name);
+			out += ": {\n";
+			out += w->name[0] == '$' ? "          \"hide_name\": 1,\n" : "          \"hide_name\": 0,\n";
+			out += "          \"bits\": ";
+			put_bits(w);
+			out += ",\n";
+			if (w->start_offset) {
+				out += "          \"offset\": ";
+				put_int(w->start_offset);
+				out += ",\n";
+			}
 			if (w->upto)
-				f << stringf("          \"upto\": 1,\n");
-			f << stringf("          \"attributes\": {");
+				out += "          \"upto\": 1,\n";
+			out += "          \"attributes\": {";
 			write_parameters(w->attributes);
-			f << stringf("\n          }\n");
-			f << stringf("        }");
+			out += "\n          }\n";
+			out += "        }";
 			first = false;
+			maybe_flush();
 		}
-		f << stringf("\n      }\n");
+		out += "\n      }\n";
 
-		f << stringf("    }");
+		out += "    }";
 	}
 
-	void write_design(Design *design_)
+	void write_design(Design *design_, int num_threads = 1)
 	{
 		design = design_;
 		design->sort();
 
-		f << stringf("{\n");
-		f << stringf("  \"creator\": %s,\n", get_string(yosys_version_str).c_str());
-		f << stringf("  \"modules\": {\n");
+		out += "{\n";
+		out += "  \"creator\": ";
+		put_string(yosys_version_str);
+		out += ",\n";
+		out += "  \"modules\": {\n";
 		vector<Module*> modules = use_selection ? design->selected_modules() : design->modules();
-		bool first_module = true;
-		for (auto mod : modules) {
-			if (!first_module)
-				f << stringf(",\n");
-			write_module(mod);
-			first_module = false;
+
+		// Module-level selections and AIG models are collected in the writer
+		// itself, so only plain write_json can write modules on several threads.
+		if (num_threads > 1 && GetSize(modules) > 1 && !use_selection && !aig_mode)
+		{
+			settle_for_concurrent_reads(design->modules_);
+			settle_for_concurrent_reads(yosys_celltypes.cell_types);
+			for (auto &it : yosys_celltypes.cell_types) {
+				settle_for_concurrent_reads(it.second.inputs);
+				settle_for_concurrent_reads(it.second.outputs);
+			}
+			for (auto mod : modules)
+				settle_for_concurrent_reads(mod->wires_);
+
+			// Every module is written into its own buffer, with its own bit
+			// IDs. The modules are handled in batches of a few modules per
+			// thread, and the buffers of a batch are written in the original
+			// order before the next batch starts. This bounds the number of
+			// buffers that are held in memory at once.
+			int batch_size = 4 * num_threads;
+			vector<string> buffers;
+			for (int begin = 0; begin < GetSize(modules); begin += batch_size)
+			{
+				int count = std::min(batch_size, GetSize(modules) - begin);
+				buffers.clear();
+				buffers.resize(count);
+				parallel_for(num_threads, count, [&](int i) {
+					JsonWriter writer(nullptr, use_selection, aig_mode, compat_int_mode);
+					writer.design = design;
+					writer.write_module(modules[begin + i]);
+					buffers[i] = std::move(writer.out);
+				});
+
+				for (int i = 0; i < count; i++) {
+					if (begin + i != 0)
+						out += ",\n";
+					flush();
+					if (f != nullptr)
+						f->write(buffers[i].data(), buffers[i].size());
+					else
+						out += buffers[i];
+					string().swap(buffers[i]);
+				}
+			}
 		}
-		f << stringf("\n  }");
+		else
+		{
+			bool first_module = true;
+			for (auto mod : modules) {
+				if (!first_module)
+					out += ",\n";
+				write_module(mod);
+				first_module = false;
+			}
+		}
+		out += "\n  }";
 		if (!aig_models.empty()) {
-			f << stringf(",\n  \"models\": {\n");
+			out += ",\n  \"models\": {\n";
 			bool first_model = true;
 			for (auto &aig : aig_models) {
 				if (!first_model)
-					f << stringf(",\n");
-				f << stringf("    \"%s\": [\n", aig.name.c_str());
+					out += ",\n";
+				out += stringf("    \"%s\": [\n", aig.name.c_str());
 				int node_idx = 0;
 				for (auto &node : aig.nodes) {
 					if (node_idx != 0)
-						f << stringf(",\n");
-					f << stringf("      /* %3d */ [ ", node_idx);
+						out += ",\n";
+					out += stringf("      /* %3d */ [ ", node_idx);
 					if (node.portbit >= 0)
-						f << stringf("\"%sport\", \"%s\", %d", node.inverter ? "n" : "",
+						out += stringf("\"%sport\", \"%s\", %d", node.inverter ? "n" : "",
 								log_id(node.portname), node.portbit);
 					else if (node.left_parent < 0 && node.right_parent < 0)
-						f << stringf("\"%s\"", node.inverter ? "true" : "false");
+						out += stringf("\"%s\"", node.inverter ? "true" : "false");
 					else
-						f << stringf("\"%s\", %d, %d", node.inverter ? "nand" : "and", node.left_parent, node.right_parent);
+						out += stringf("\"%s\", %d, %d", node.inverter ? "nand" : "and", node.left_parent, node.right_parent);
 					for (auto &op : node.outports)
-						f << stringf(", \"%s\", %d", log_id(op.first), op.second);
-					f << stringf(" ]");
+						out += stringf(", \"%s\", %d", log_id(op.first), op.second);
+					out += " ]";
 					node_idx++;
 				}
-				f << stringf("\n    ]");
+				out += "\n    ]";
 				first_model = false;
 			}
-			f << stringf("\n  }");
+			out += "\n  }";
 		}
-		f << stringf("\n}\n");
+		out += "\n}\n";
+		flush();
 	}
 };
 
@@ -299,6 +471,11 @@ struct JsonBackend : public Backend {
 		log("        emit 32-bit or smaller fully-defined parameter values directly\n");
 		log("        as JSON numbers (for compatibility with old parsers)\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        generate the JSON code for N modules at once on separate threads.\n");
+		log("        N may be zero to use all available cores. (default = 1)\n");
+		log("        -aig always uses a single thread.\n");
+		log("\n");
 		log("\n");
 		log("The general syntax of the JSON output created by this command is as follows:\n");
 		log("\n");
@@ -500,10 +677,15 @@ struct JsonBackend : public Backend {
 	{
 		bool aig_mode = false;
 		bool compat_int_mode = false;
+		int num_threads = 1;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
 		{
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			if (args[argidx] == "-aig") {
 				aig_mode = true;
 				continue;
@@ -518,8 +700,8 @@ struct JsonBackend : public Backend {
 
 		log_header(design, "Executing JSON backend.\n");
 
-		JsonWriter json_writer(*f, false, aig_mode, compat_int_mode);
-		json_writer.write_design(design);
+		JsonWriter json_writer(f, false, aig_mode, compat_int_mode);
+		json_writer.write_design(design, num_threads);
 	}
 } JsonBackend;
 
@@ -587,7 +769,7 @@ struct JsonPass : public Pass {
 			f = &buf;
 		}
 
-		JsonWriter json_writer(*f, true, aig_mode, compat_int_mode);
+		JsonWriter json_writer(f, true, aig_mode, compat_int_mode);
 		json_writer.write_design(design);
 
 		if (!filename.empty()) {
@@ -0,0 +1,255 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/rtlil_bin/rtlil_bin.h"
+
+USING_YOSYS_NAMESPACE
+using namespace RTLIL_BIN;
+PRIVATE_NAMESPACE_BEGIN
+
+struct RtlilBinWriter
+{
+	dict<RTLIL::IdString, int> string_index;
+	std::vector<std::string> strings;
+
+	dict<RTLIL::Wire*, int> wire_index;
+	Encoder enc;
+
+	int id(RTLIL::IdString name)
+	{
+		auto it = string_index.find(name);
+		if (it != string_index.end())
+			return it->second;
+		int idx = GetSize(strings);
+		string_index[name] = idx;
+		strings.push_back(name.str());
+		return idx;
+	}
+
+	void write_const(const RTLIL::Const &data)
+	{
+		enc.u(data.flags);
+		enc.const_bits(data.bits, 0, GetSize(data.bits));
+	}
+
+	void write_attributes(const dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		enc.u(attributes.size());
+		for (auto &it : attributes) {
+			enc.u(id(it.first));
+			write_const(it.second);
+		}
+	}
+
+	void write_sigspec(const RTLIL::SigSpec &sig)
+	{
+		enc.u(GetSize(sig.chunks()));
+		for (auto &chunk : sig.chunks())
+		{
+			if (chunk.wire == nullptr) {
+				enc.u(0);
+				enc.const_bits(chunk.data, 0, chunk.width);
+				continue;
+			}
+
+			int idx = wire_index.at(chunk.wire) + 1;
+			if (chunk.offset == 0 && chunk.width == chunk.wire->width) {
+				enc.u(2*idx);
+			} else {
+				enc.u(2*idx + 1);
+				enc.u(chunk.offset);
+				enc.u(chunk.width);
+			}
+		}
+	}
+
+	void write_sigsigs(const std::vector<RTLIL::SigSig> &sigsigs)
+	{
+		enc.u(sigsigs.size());
+		for (auto &it : sigsigs) {
+			write_sigspec(it.first);
+			write_sigspec(it.second);
+		}
+	}
+
+	void write_case(const RTLIL::CaseRule *cs)
+	{
+		write_attributes(cs->attributes);
+		enc.u(cs->compare.size());
+		for (auto &sig : cs->compare)
+			write_sigspec(sig);
+		write_sigsigs(cs->actions);
+		enc.u(cs->switches.size());
+		for (auto sw : cs->switches) {
+			write_attributes(sw->attributes);
+			write_sigspec(sw->signal);
+			enc.u(sw->cases.size());
+			for (auto child : sw->cases)
+				write_case(child);
+		}
+	}
+
+	std::string write_module(RTLIL::Module *module)
+	{
+		enc.buf.clear();
+		wire_index.clear();
+
+		write_attributes(module->attributes);
+		enc.u(module->avail_parameters.size());
+		for (auto &p : module->avail_parameters)
+			enc.u(id(p));
+
+		enc.u(GetSize(module->wires()));
+		for (auto wire : module->wires()) {
+			int idx = GetSize(wire_index);
+			wire_index[wire] = idx;
+			enc.u(id(wire->name));
+			enc.u(wire->width);
+			enc.s(wire->start_offset);
+			enc.u(wire->port_id);
+			enc.u((wire->port_input ? WIRE_INPUT : 0) | (wire->port_output ? WIRE_OUTPUT : 0) | (wire->upto ? WIRE_UPTO : 0));
+			write_attributes(wire->attributes);
+		}
+
+		enc.u(module->memories.size());
+		for (auto &it : module->memories) {
+			enc.u(id(it.second->name));
+			enc.u(it.second->width);
+			enc.s(it.second->start_offset);
+			enc.u(it.second->size);
+			write_attributes(it.second->attributes);
+		}
+
+		enc.u(GetSize(module->cells()));
+		for (auto cell : module->cells()) {
+			enc.u(id(cell->name));
+			enc.u(id(cell->type));
+			enc.u(cell->parameters.size());
+			for (auto &it : cell->parameters) {
+				enc.u(id(it.first));
+				write_const(it.second);
+			}
+			enc.u(cell->connections().size());
+			for (auto &it : cell->connections()) {
+				enc.u(id(it.first));
+				write_sigspec(it.second);
+			}
+			write_attributes(cell->attributes);
+		}
+
+		enc.u(module->processes.size());
+		for (auto &it : module->processes) {
+			RTLIL::Process *proc = it.second;
+			enc.u(id(proc->name));
+			write_attributes(proc->attributes);
+			write_case(&proc->root_case);
+			enc.u(proc->syncs.size());
+			for (auto sync : proc->syncs) {
+				enc.u(sync->type);
+				write_sigspec(sync->signal);
+				write_sigsigs(sync->actions);
+			}
+		}
+
+		write_sigsigs(module->connections());
+
+		return enc.buf;
+	}
+
+	void write_design(std::ostream &f, RTLIL::Design *design, bool only_selected)
+	{
+		std::vector<std::pair<int, std::string>> sections;
+		for (auto module : design->modules())
+			if (!only_selected || design->selected(module))
+				sections.push_back(std::make_pair(id(module->name), write_module(module)));
+
+		enc.buf.clear();
+		enc.buf.append(magic, magic_size);
+		enc.u(format_version);
+		enc.u(autoidx);
+
+		enc.u(strings.size());
+		for (auto &str : strings)
+			enc.bytes(str);
+
+		uint64_t offset = 0;
+		enc.u(sections.size());
+		for (auto &it : sections) {
+			enc.u(it.first);
+			enc.u(offset);
+			enc.u(it.second.size());
+			offset += it.second.size();
+		}
+
+		f.write(enc.buf.data(), enc.buf.size());
+		for (auto &it : sections)
+			f.write(it.second.data(), it.second.size());
+
+		log("Wrote %d modules and %d strings (%llu bytes of module data).\n", GetSize(sections),
+				GetSize(strings), (unsigned long long)offset);
+	}
+};
+
+struct RtlilBinBackend : public Backend {
+	RtlilBinBackend() : Backend("rtlil_bin", "write design to binary RTLIL file") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_rtlil_bin [options] [filename]\n");
+		log("\n");
+		log("Write the current design to a binary RTLIL file. This file holds the same\n");
+		log("information as an ilang file, but is much smaller and faster to read and\n");
+		log("write. It contains an index of its modules, so that 'read_rtlil_bin -module'\n");
+		log("can load single modules without parsing the others. The format is versioned,\n");
+		log("but only meant for checkpoints of the same Yosys version. Use 'write_ilang'\n");
+		log("for archival or for exchange with other tools.\n");
+		log("\n");
+		log("    -selected\n");
+		log("        only write selected modules. partially selected modules are written\n");
+		log("        completely.\n");
+		log("\n");
+	}
+	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
+	{
+		bool selected = false;
+
+		log_header(design, "Executing RTLIL_BIN backend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-selected") {
+				selected = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx, true);
+
+		design->sort();
+
+		log("Output filename: %s\n", filename.c_str());
+		RtlilBinWriter writer;
+		writer.write_design(*f, design, selected);
+	}
+} RtlilBinBackend;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,165 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  A binary representation of RTLIL, written by 'write_rtlil_bin' and read
+ *  by 'read_rtlil_bin'. It holds the same information as an ilang file.
+ *
+ *  All integers are LEB128 varints (signed values zigzag encoded). A file
+ *  consists of:
+ *
+ *    magic "YSRTLILB", format version, autoidx
+ *    string table: number of strings, then length and bytes of each string
+ *    module index: number of modules, then name, offset and size of each
+ *                  module section (offsets are relative to the first section)
+ *    module sections
+ *
+ *  Names are indices into the string table and wires are referenced by their
+ *  index within the module. A SigSpec is a list of chunks, each chunk being
+ *  a constant, a whole wire or a slice of a wire. Constants store their bits
+ *  packed 8 per byte when they only contain 0 and 1, otherwise 2 per byte.
+ *
+ */
+
+#ifndef RTLIL_BIN_H
+#define RTLIL_BIN_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_BIN
+{
+	static const char magic[] = "YSRTLILB";
+	static const int magic_size = 8;
+	static const int format_version = 1;
+
+	enum wire_flags_t {
+		WIRE_INPUT  = 1,
+		WIRE_OUTPUT = 2,
+		WIRE_UPTO   = 4
+	};
+
+	struct Encoder
+	{
+		std::string buf;
+
+		void u(uint64_t v) {
+			while (v >= 0x80) {
+				buf += char(v | 0x80);
+				v >>= 7;
+			}
+			buf += char(v);
+		}
+
+		void s(int64_t v) {
+			u((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+		}
+
+		void bytes(const std::string &str) {
+			u(str.size());
+			buf += str;
+		}
+
+		// Writes the bits of a constant, without its flags.
+		void const_bits(const std::vector<RTLIL::State> &bits, int offset, int width)
+		{
+			bool binary = true;
+			for (int i = offset; i < offset + width; i++)
+				if (bits[i] != RTLIL::State::S0 && bits[i] != RTLIL::State::S1) {
+					binary = false;
+					break;
+				}
+
+			u((uint64_t(width) << 1) | (binary ? 0 : 1));
+
+			int per_byte = binary ? 8 : 2;
+			for (int i = 0; i < width; i += per_byte) {
+				unsigned char byte = 0;
+				for (int j = 0; j < per_byte && i + j < width; j++)
+					byte |= (unsigned char)bits[offset + i + j] << (binary ? j : 4*j);
+				buf += char(byte);
+			}
+		}
+	};
+
+	struct Decoder
+	{
+		const unsigned char *ptr, *end;
+
+		Decoder(const std::string &data) : ptr((const unsigned char*)data.data()), end(ptr + data.size()) { }
+
+		void check(size_t n) {
+			if (size_t(end - ptr) < n)
+				log_error("Unexpected end of binary RTLIL data.\n");
+		}
+
+		uint64_t u() {
+			uint64_t v = 0;
+			for (int shift = 0;; shift += 7) {
+				check(1);
+				unsigned char byte = *ptr++;
+				if (shift < 64)
+					v |= uint64_t(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+					return v;
+			}
+		}
+
+		int64_t s() {
+			uint64_t v = u();
+			return int64_t(v >> 1) ^ -int64_t(v & 1);
+		}
+
+		int i() {
+			return int(u());
+		}
+
+		std::string bytes() {
+			size_t n = u();
+			check(n);
+			std::string str((const char*)ptr, n);
+			ptr += n;
+			return str;
+		}
+
+		void const_bits(std::vector<RTLIL::State> &bits)
+		{
+			uint64_t head = u();
+			int width = head >> 1;
+			bool binary = (head & 1) == 0;
+			int per_byte = binary ? 8 : 2;
+
+			check((width + per_byte - 1) / per_byte);
+			bits.resize(width);
+			for (int i = 0; i < width; i += per_byte) {
+				unsigned char byte = *ptr++;
+				for (int j = 0; j < per_byte && i + j < width; j++) {
+					int state = binary ? (byte >> j) & 1 : (byte >> 4*j) & 15;
+					if (state > RTLIL::State::Sm)
+						log_error("Invalid constant bit in binary RTLIL data.\n");
+					bits[i + j] = RTLIL::State(state);
+				}
+			}
+		}
+	};
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -37,18 +37,22 @@ struct Smt2Worker
 	int idcounter = 0, statebv_width = 0;
 
 	std::vector<std::string> decls, trans, hier, dtmembers;
-	std::map<RTLIL::SigBit, RTLIL::Cell*> bit_driver;
-	std::set<RTLIL::Cell*> exported_cells, hiercells, hiercells_queue;
+	dict<RTLIL::SigBit, RTLIL::Cell*> bit_driver;
+	pool<RTLIL::Cell*> exported_cells, hiercells, hiercells_queue;
 	pool<Cell*> recursive_cells, registers;
 
 	pool<SigBit> clock_posedge, clock_negedge;
 	vector<string> ex_state_eq, ex_input_eq;
 
-	std::map<RTLIL::SigBit, std::pair<int, int>> fcache;
-	std::map<Cell*, int> memarrays;
-	std::map<int, int> bvsizes;
+	dict<RTLIL::SigBit, std::pair<int, int>> fcache;
+	dict<Cell*, int> memarrays;
+	dict<int, int> bvsizes;
 	dict<IdString, char*> ids;
 
+	// sort and body of every define-fun created for a cell, so that cells with
+	// structurally identical expressions share one definition (hash-consing)
+	dict<std::string, int> expr_cache;
+
 	const char *get_id(IdString n)
 	{
 		if (ids.count(n) == 0) {
@@ -229,7 +233,7 @@ struct Smt2Worker
 		fcache[bit] = std::pair<int, int>(id, -1);
 	}
 
-	void register_bv(RTLIL::SigSpec sig, int id)
+	void register_bv(RTLIL::SigSpec sig, int id, bool shared = false)
 	{
 		if (verbose) log("%*s-> register_bv: %s %d\n", 2+2*GetSize(recursive_cells), "",
 				log_signal(sig), id);
@@ -237,8 +241,12 @@ struct Smt2Worker
 		log_assert(bvmode);
 		sigmap.apply(sig);
 
-		log_assert(bvsizes.count(id) == 0);
-		bvsizes[id] = GetSize(sig);
+		if (shared) {
+			log_assert(bvsizes.at(id) == GetSize(sig));
+		} else {
+			log_assert(bvsizes.count(id) == 0);
+			bvsizes[id] = GetSize(sig);
+		}
 
 		for (int i = 0; i < GetSize(sig); i++) {
 			log_assert(fcache.count(sig[i]) == 0);
@@ -339,7 +347,7 @@ struct Smt2Worker
 				continue;
 			}
 
-			std::set<RTLIL::SigBit> seen_bits = { sig[i] };
+			pool<RTLIL::SigBit> seen_bits = { sig[i] };
 			while (i+j < GetSize(sig) && sig[i+j].wire && !fcache.count(sig[i+j]) && !seen_bits.count(sig[i+j]))
 				seen_bits.insert(sig[i+j]), j++;
 
@@ -365,6 +373,17 @@ struct Smt2Worker
 		}
 	}
 
+	// Returns the ID of an earlier definition with the same sort and body, or -1
+	// if there is none, in which case the next ID is recorded for this body.
+	int find_expr(const std::string &sort, const std::string &expr)
+	{
+		auto it = expr_cache.find(sort + " " + expr);
+		if (it != expr_cache.end())
+			return it->second;
+		expr_cache[sort + " " + expr] = idcounter;
+		return -1;
+	}
+
 	void export_gate(RTLIL::Cell *cell, std::string expr)
 	{
 		RTLIL::SigBit bit = sigmap(cell->getPort("\\Y").as_bit());
@@ -382,9 +401,14 @@ struct Smt2Worker
 		if (verbose)
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
-		decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-				get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(bit)));
-		register_bool(bit, idcounter++);
+		int id = find_expr("Bool", processed_expr);
+		if (id >= 0) {
+			register_bool(bit, id);
+		} else {
+			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(bit)));
+			register_bool(bit, idcounter++);
+		}
 		recursive_cells.erase(cell);
 	}
 
@@ -429,13 +453,23 @@ struct Smt2Worker
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
 		if (type == 'b') {
-			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
-			register_boolvec(sig_y, idcounter++);
+			int id = find_expr("Bool", processed_expr);
+			if (id >= 0) {
+				register_boolvec(sig_y, id);
+			} else {
+				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+						get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
+				register_boolvec(sig_y, idcounter++);
+			}
 		} else {
-			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
-					get_id(module), idcounter, get_id(module), GetSize(sig_y), processed_expr.c_str(), log_signal(sig_y)));
-			register_bv(sig_y, idcounter++);
+			int id = find_expr(stringf("(_ BitVec %d)", GetSize(sig_y)), processed_expr);
+			if (id >= 0) {
+				register_bv(sig_y, id, true);
+			} else {
+				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
+						get_id(module), idcounter, get_id(module), GetSize(sig_y), processed_expr.c_str(), log_signal(sig_y)));
+				register_bv(sig_y, idcounter++);
+			}
 		}
 
 		recursive_cells.erase(cell);
@@ -459,9 +493,14 @@ struct Smt2Worker
 		if (verbose)
 			log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
-		decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
-				get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
-		register_boolvec(sig_y, idcounter++);
+		int id = find_expr("Bool", processed_expr);
+		if (id >= 0) {
+			register_boolvec(sig_y, id);
+		} else {
+			decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) Bool %s) ; %s\n",
+					get_id(module), idcounter, get_id(module), processed_expr.c_str(), log_signal(sig_y)));
+			register_boolvec(sig_y, idcounter++);
+		}
 		recursive_cells.erase(cell);
 	}
 
@@ -627,9 +666,14 @@ struct Smt2Worker
 					log("%*s-> import cell: %s\n", 2+2*GetSize(recursive_cells), "", log_id(cell));
 
 				RTLIL::SigSpec sig = sigmap(cell->getPort("\\Y"));
-				decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
-						get_id(module), idcounter, get_id(module), width, processed_expr.c_str(), log_signal(sig)));
-				register_bv(sig, idcounter++);
+				int id = find_expr(stringf("(_ BitVec %d)", width), processed_expr);
+				if (id >= 0) {
+					register_bv(sig, id, true);
+				} else {
+					decls.push_back(stringf("(define-fun |%s#%d| ((state |%s_s|)) (_ BitVec %d) %s) ; %s\n",
+							get_id(module), idcounter, get_id(module), width, processed_expr.c_str(), log_signal(sig)));
+					register_bv(sig, idcounter++);
+				}
 				recursive_cells.erase(cell);
 				return;
 			}
@@ -924,7 +968,7 @@ struct Smt2Worker
 
 		while (!hiercells_queue.empty())
 		{
-			std::set<RTLIL::Cell*> queue;
+			pool<RTLIL::Cell*> queue;
 			queue.swap(hiercells_queue);
 
 			for (auto cell : queue)
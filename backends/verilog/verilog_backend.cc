@@ -25,6 +25,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include "kernel/sigtools.h"
+#include "kernel/threading.h"
 #include <string>
 #include <sstream>
 #include <set>
@@ -33,22 +34,87 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// IdStrings must not be created or copied on the worker threads of
+// 'write_verilog -threads', as their reference counts are not atomic. The names
+// that are used while dumping a module are created once on the main thread by
+// setup_verilog_ids(), and are only passed by reference after that.
+#define VERILOG_IDS(X) \
+	X($_ANDNOT_) X($_AND_) X($_AOI3_) X($_AOI4_) X($_DFFSR_NNN_) X($_DFFSR_NNP_) X($_DFFSR_NPN_) X($_DFFSR_NPP_) \
+	X($_DFFSR_PNN_) X($_DFFSR_PNP_) X($_DFFSR_PPN_) X($_DFFSR_PPP_) X($_DFF_NN0_) X($_DFF_NN1_) X($_DFF_NP0_) \
+	X($_DFF_NP1_) X($_DFF_N_) X($_DFF_PN0_) X($_DFF_PN1_) X($_DFF_PP0_) X($_DFF_PP1_) X($_DFF_P_) X($_MUX_) \
+	X($_NAND_) X($_NMUX_) X($_NOR_) X($_NOT_) X($_OAI3_) X($_OAI4_) X($_ORNOT_) X($_OR_) X($_XNOR_) X($_XOR_) \
+	X($add) X($adff) X($and) X($assert) X($assume) X($concat) X($cover) X($dff) X($dffe) X($dffsr) X($div) \
+	X($dlatch) X($eq) X($eqx) X($ge) X($gt) X($le) X($logic_and) X($logic_not) X($logic_or) X($lt) X($lut) \
+	X($mem) X($mod) X($mul) X($mux) X($ne) X($neg) X($nex) X($not) X($or) X($pmux) X($pos) X($pow) \
+	X($reduce_and) X($reduce_bool) X($reduce_or) X($reduce_xnor) X($reduce_xor) X($shift) X($shiftx) X($shl) \
+	X($shr) X($slice) X($specify2) X($specify3) X($specrule) X($sshl) X($sshr) X($sub) X($tribuf) X($xnor) \
+	X($xor) X(A) X(ABITS) X(ARST) X(ARST_POLARITY) X(ARST_VALUE) X(A_SIGNED) X(B) X(B_SIGNED) X(C) X(CLK) \
+	X(CLK_POLARITY) X(CLR) X(CLR_POLARITY) X(D) X(DAT) X(DAT_DST_PEN) X(DAT_DST_POL) X(DST) X(DST_EN) X(DST_PEN) \
+	X(DST_POL) X(EDGE_EN) X(EDGE_POL) X(EN) X(EN_POLARITY) X(FULL) X(INIT) X(LUT) X(MEMID) X(OFFSET) X(Q) X(R) \
+	X(RD_ADDR) X(RD_CLK) X(RD_CLK_ENABLE) X(RD_CLK_POLARITY) X(RD_DATA) X(RD_EN) X(RD_PORTS) X(RD_TRANSPARENT) \
+	X(S) X(SET) X(SET_POLARITY) X(SIZE) X(SRC) X(SRC_DST_PEN) X(SRC_DST_POL) X(SRC_EN) X(SRC_PEN) X(SRC_POL) \
+	X(TYPE) X(T_FALL_MAX) X(T_FALL_MIN) X(T_FALL_TYP) X(T_LIMIT2_MAX) X(T_LIMIT2_MIN) X(T_LIMIT2_TYP) \
+	X(T_LIMIT_MAX) X(T_LIMIT_MIN) X(T_LIMIT_TYP) X(T_RISE_MAX) X(T_RISE_MIN) X(T_RISE_TYP) X(WIDTH) X(WR_ADDR) \
+	X(WR_CLK) X(WR_CLK_POLARITY) X(WR_DATA) X(WR_EN) X(WR_PORTS) X(Y) X(Y_WIDTH) X(init)
+
+namespace VID {
+#define X(_id) static RTLIL::IdString _id;
+VERILOG_IDS(X)
+#undef X
+}
+
+static void setup_verilog_ids()
+{
+	if (!VID::A.empty())
+		return;
+#define X(_id) VID::_id = RTLIL::escape_id(#_id);
+	VERILOG_IDS(X)
+#undef X
+}
+
+// Same as cell->type.in(...), without copying the IdStrings.
+static bool type_in(const RTLIL::Cell *cell, const RTLIL::IdString &type)
+{
+	return cell->type == type;
+}
+
+template<typename... Args>
+static bool type_in(const RTLIL::Cell *cell, const RTLIL::IdString &type, const Args &...rest)
+{
+	return cell->type == type || type_in(cell, rest...);
+}
+
 bool verbose, norename, noattr, attr2comment, noexpr, nodec, nohex, nostr, extmem, defparam, decimal, siminit;
-int auto_name_counter, auto_name_offset, auto_name_digits, extmem_counter;
-std::map<RTLIL::IdString, int> auto_name_map;
-std::set<RTLIL::IdString> reg_wires, reg_ct;
+int extmem_counter;
+std::set<RTLIL::IdString> reg_ct;
 std::string auto_prefix, extmem_prefix;
 
-RTLIL::Module *active_module;
-dict<RTLIL::SigBit, RTLIL::State> active_initdata;
-SigMap active_sigmap;
-
-void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
+// Names that are created on the main thread before the modules are dumped:
+// the names of $mem cells, and the '<wire>_reg' names of register cells.
+dict<const RTLIL::Cell*, RTLIL::IdString> mem_ids;
+dict<const RTLIL::Cell*, std::string> reg_cell_names;
+
+// The state of the module that is being dumped. This is thread local so that
+// 'write_verilog -threads' can dump several modules at once. The renamed
+// names are keyed by the index of their IdString.
+thread_local int auto_name_counter, auto_name_offset, auto_name_digits;
+thread_local dict<int, int> auto_name_map;
+thread_local std::vector<const RTLIL::IdString*> auto_name_ids;
+thread_local std::vector<std::string> auto_names;
+thread_local pool<RTLIL::Wire*> reg_wires;
+
+thread_local RTLIL::Module *active_module;
+thread_local dict<RTLIL::SigBit, RTLIL::State> active_initdata;
+thread_local SigMap active_sigmap;
+
+void reset_auto_counter_id(const RTLIL::IdString &id, bool may_rename)
 {
 	const char *str = id.c_str();
 
-	if (*str == '$' && may_rename && !norename)
-		auto_name_map[id] = auto_name_counter++;
+	if (*str == '$' && may_rename && !norename) {
+		auto_name_map[id.index_] = auto_name_counter++;
+		auto_name_ids.push_back(&id);
+	}
 
 	if (str[0] != '\\' || str[1] != '_' || str[2] == 0)
 		return;
@@ -68,6 +134,8 @@ void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
 void reset_auto_counter(RTLIL::Module *module)
 {
 	auto_name_map.clear();
+	auto_name_ids.clear();
+	auto_names.clear();
 	auto_name_counter = 0;
 	auto_name_offset = 0;
 
@@ -88,9 +156,13 @@ void reset_auto_counter(RTLIL::Module *module)
 	for (size_t i = 10; i < auto_name_offset + auto_name_map.size(); i = i*10)
 		auto_name_digits++;
 
+	auto_names.resize(auto_name_counter);
+	for (int i = 0; i < auto_name_counter; i++)
+		auto_names[i] = stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + i);
+
 	if (verbose)
 		for (auto it = auto_name_map.begin(); it != auto_name_map.end(); ++it)
-			log("  renaming `%s' to `%s_%0*d_'.\n", it->first.c_str(), auto_prefix.c_str(), auto_name_digits, auto_name_offset + it->second);
+			log("  renaming `%s' to `%s'.\n", auto_name_ids[it->second]->c_str(), auto_names[it->second].c_str());
 }
 
 std::string next_auto_id()
@@ -98,19 +170,10 @@ std::string next_auto_id()
 	return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_counter++);
 }
 
-std::string id(RTLIL::IdString internal_id, bool may_rename = true)
+bool id_needs_escape(const char *str)
 {
-	const char *str = internal_id.c_str();
-	bool do_escape = false;
-
-	if (may_rename && auto_name_map.count(internal_id) != 0)
-		return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_map[internal_id]);
-
-	if (*str == '\\')
-		str++;
-
 	if ('0' <= *str && *str <= '9')
-		do_escape = true;
+		return true;
 
 	for (int i = 0; str[i]; i++)
 	{
@@ -122,11 +185,10 @@ std::string id(RTLIL::IdString internal_id, bool may_rename = true)
 			continue;
 		if (str[i] == '_')
 			continue;
-		do_escape = true;
-		break;
+		return true;
 	}
 
-	const pool<string> keywords = {
+	static const pool<string> keywords = {
 		// IEEE 1800-2017 Annex B
 		"accept_on", "alias", "always", "always_comb", "always_ff", "always_latch", "and", "assert", "assign", "assume", "automatic", "before",
 		"begin", "bind", "bins", "binsof", "bit", "break", "buf", "bufif0", "bufif1", "byte", "case", "casex", "casez", "cell", "chandle",
@@ -150,14 +212,56 @@ std::string id(RTLIL::IdString internal_id, bool may_rename = true)
 		"untyped", "use", "uwire", "var", "vectored", "virtual", "void", "wait", "wait_order", "wand", "weak", "weak0", "weak1", "while",
 		"wildcard", "wire", "with", "within", "wor", "xnor", "xor",
 	};
-	if (keywords.count(str))
-		do_escape = true;
+	return keywords.count(str) != 0;
+}
+
+const std::string *auto_name(const RTLIL::IdString &internal_id)
+{
+	if (auto_name_map.empty())
+		return nullptr;
+	auto it = auto_name_map.find(internal_id.index_);
+	if (it == auto_name_map.end())
+		return nullptr;
+	return &auto_names[it->second];
+}
+
+std::string id(const char *str)
+{
+	if (*str == '\\')
+		str++;
 
-	if (do_escape)
+	if (id_needs_escape(str))
 		return "\\" + std::string(str) + " ";
 	return std::string(str);
 }
 
+std::string id(const RTLIL::IdString &internal_id, bool may_rename = true)
+{
+	const std::string *name = may_rename ? auto_name(internal_id) : nullptr;
+	if (name != nullptr)
+		return *name;
+	return id(internal_id.c_str());
+}
+
+// Same as f << id(internal_id), without building a temporary string.
+void dump_id(std::ostream &f, const RTLIL::IdString &internal_id, bool may_rename = true)
+{
+	const std::string *name = may_rename ? auto_name(internal_id) : nullptr;
+	if (name != nullptr) {
+		f << *name;
+		return;
+	}
+
+	const char *str = internal_id.c_str();
+	if (*str == '\\')
+		str++;
+
+	if (id_needs_escape(str))
+		f << '\\' << str << ' ';
+	else
+		f << str;
+}
+
 bool is_reg_wire(RTLIL::SigSpec sig, std::string &reg_name)
 {
 	if (!sig.is_chunk() || sig.as_chunk().wire == NULL)
@@ -165,7 +269,7 @@ bool is_reg_wire(RTLIL::SigSpec sig, std::string &reg_name)
 
 	RTLIL::SigChunk chunk = sig.as_chunk();
 
-	if (reg_wires.count(chunk.wire->name) == 0)
+	if (reg_wires.count(chunk.wire) == 0)
 		return false;
 
 	reg_name = id(chunk.wire->name);
@@ -206,11 +310,11 @@ void dump_const(std::ostream &f, const RTLIL::Const &data, int width = -1, int o
 					val |= 1 << (i - offset);
 			}
 			if (decimal)
-				f << stringf("%d", val);
+				f << val;
 			else if (set_signed && val < 0)
-				f << stringf("-32'sd%u", -val);
+				f << "-32'sd" << -(uint32_t)val;
 			else
-				f << stringf("32'%sd%u", set_signed ? "s" : "", val);
+				f << (set_signed ? "32'sd" : "32'd") << (uint32_t)val;
 		} else {
 	dump_hex:
 			if (nohex)
@@ -261,49 +365,49 @@ void dump_const(std::ostream &f, const RTLIL::Const &data, int width = -1, int o
 				int val = 8*(bit_3 - '0') + 4*(bit_2 - '0') + 2*(bit_1 - '0') + (bit_0 - '0');
 				hex_digits.push_back(val < 10 ? '0' + val : 'a' + val - 10);
 			}
-			f << stringf("%d'%sh", width, set_signed ? "s" : "");
+			f << width << (set_signed ? "'sh" : "'h");
 			for (int i = GetSize(hex_digits)-1; i >= 0; i--)
 				f << hex_digits[i];
 		}
 		if (0) {
 	dump_bin:
-			f << stringf("%d'%sb", width, set_signed ? "s" : "");
+			f << width << (set_signed ? "'sb" : "'b");
 			if (width == 0)
-				f << stringf("0");
+				f << '0';
 			for (int i = offset+width-1; i >= offset; i--) {
 				log_assert(i < (int)data.bits.size());
 				switch (data.bits[i]) {
-				case State::S0: f << stringf("0"); break;
-				case State::S1: f << stringf("1"); break;
-				case RTLIL::Sx: f << stringf("x"); break;
-				case RTLIL::Sz: f << stringf("z"); break;
-				case RTLIL::Sa: f << stringf("?"); break;
+				case State::S0: f << '0'; break;
+				case State::S1: f << '1'; break;
+				case RTLIL::Sx: f << 'x'; break;
+				case RTLIL::Sz: f << 'z'; break;
+				case RTLIL::Sa: f << '?'; break;
 				case RTLIL::Sm: log_error("Found marker state in final netlist.");
 				}
 			}
 		}
 	} else {
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 		std::string str = data.decode_string();
 		for (size_t i = 0; i < str.size(); i++) {
 			if (str[i] == '\n')
-				f << stringf("\\n");
+				f << "\\n";
 			else if (str[i] == '\t')
-				f << stringf("\\t");
+				f << "\\t";
 			else if (str[i] < 32)
 				f << stringf("\\%03o", str[i]);
 			else if (str[i] == '"')
-				f << stringf("\\\"");
+				f << "\\\"";
 			else if (str[i] == '\\')
-				f << stringf("\\\\");
+				f << "\\\\";
 			else if (str[i] == '/' && escape_comment && i > 0 && str[i-1] == '*')
-				f << stringf("\\/");
+				f << "\\/";
 			else
 				f << str[i];
 		}
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 	}
 }
 
@@ -332,22 +436,21 @@ void dump_sigchunk(std::ostream &f, const RTLIL::SigChunk &chunk, bool no_decima
 	if (chunk.wire == NULL) {
 		dump_const(f, chunk.data, chunk.width, chunk.offset, no_decimal);
 	} else {
-		if (chunk.width == chunk.wire->width && chunk.offset == 0) {
-			f << stringf("%s", id(chunk.wire->name).c_str());
-		} else if (chunk.width == 1) {
+		dump_id(f, chunk.wire->name);
+		if (chunk.width == chunk.wire->width && chunk.offset == 0)
+			return;
+		if (chunk.width == 1) {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), chunk.offset + chunk.wire->start_offset);
+				f << '[' << chunk.offset + chunk.wire->start_offset << ']';
 		} else {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset,
-						(chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << '[' << (chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset
+						<< ':' << (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset << ']';
 			else
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.offset + chunk.width - 1) + chunk.wire->start_offset,
-						chunk.offset + chunk.wire->start_offset);
+				f << '[' << (chunk.offset + chunk.width - 1) + chunk.wire->start_offset
+						<< ':' << chunk.offset + chunk.wire->start_offset << ']';
 		}
 	}
 }
@@ -361,48 +464,48 @@ void dump_sigspec(std::ostream &f, const RTLIL::SigSpec &sig)
 	if (sig.is_chunk()) {
 		dump_sigchunk(f, sig.as_chunk());
 	} else {
-		f << stringf("{ ");
+		f << "{ ";
 		for (auto it = sig.chunks().rbegin(); it != sig.chunks().rend(); ++it) {
 			if (it != sig.chunks().rbegin())
-				f << stringf(", ");
+				f << ", ";
 			dump_sigchunk(f, *it, true);
 		}
-		f << stringf(" }");
+		f << " }";
 	}
 }
 
-void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n', bool modattr = false, bool regattr = false, bool as_comment = false)
+void dump_attributes(std::ostream &f, const std::string &indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n', bool modattr = false, bool regattr = false, bool as_comment = false)
 {
 	if (noattr)
 		return;
 	if (attr2comment)
 		as_comment = true;
 	for (auto it = attributes.begin(); it != attributes.end(); ++it) {
-		if (it->first == "\\init" && regattr) continue;
+		if (it->first == VID::init && regattr) continue;
 		f << stringf("%s" "%s %s", indent.c_str(), as_comment ? "/*" : "(*", id(it->first).c_str());
-		f << stringf(" = ");
+		f << " = ";
 		if (modattr && (it->second == State::S0 || it->second == Const(0)))
-			f << stringf(" 0 ");
+			f << " 0 ";
 		else if (modattr && (it->second == State::S1 || it->second == Const(1)))
-			f << stringf(" 1 ");
+			f << " 1 ";
 		else
 			dump_const(f, it->second, -1, 0, false, as_comment);
 		f << stringf(" %s%c", as_comment ? "*/" : "*)", term);
 	}
 }
 
-void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
+void dump_wire(std::ostream &f, const std::string &indent, RTLIL::Wire *wire)
 {
-	dump_attributes(f, indent, wire->attributes, '\n', /*modattr=*/false, /*regattr=*/reg_wires.count(wire->name));
+	dump_attributes(f, indent, wire->attributes, '\n', /*modattr=*/false, /*regattr=*/reg_wires.count(wire));
 #if 0
 	if (wire->port_input && !wire->port_output)
-		f << stringf("%s" "input %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "input %s", indent.c_str(), reg_wires.count(wire) ? "reg " : "");
 	else if (!wire->port_input && wire->port_output)
-		f << stringf("%s" "output %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "output %s", indent.c_str(), reg_wires.count(wire) ? "reg " : "");
 	else if (wire->port_input && wire->port_output)
-		f << stringf("%s" "inout %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << stringf("%s" "inout %s", indent.c_str(), reg_wires.count(wire) ? "reg " : "");
 	else
-		f << stringf("%s" "%s ", indent.c_str(), reg_wires.count(wire->name) ? "reg" : "wire");
+		f << stringf("%s" "%s ", indent.c_str(), reg_wires.count(wire) ? "reg" : "wire");
 	if (wire->width != 1)
 		f << stringf("[%d:%d] ", wire->width - 1 + wire->start_offset, wire->start_offset);
 	f << stringf("%s;\n", id(wire->name).c_str());
@@ -415,231 +518,243 @@ void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
 		else
 			range = stringf(" [%d:%d]", wire->width - 1 + wire->start_offset, wire->start_offset);
 	}
+	std::string name = id(wire->name);
 	if (wire->port_input && !wire->port_output)
-		f << stringf("%s" "input%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "input" << range << ' ' << name << ";\n";
 	if (!wire->port_input && wire->port_output)
-		f << stringf("%s" "output%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "output" << range << ' ' << name << ";\n";
 	if (wire->port_input && wire->port_output)
-		f << stringf("%s" "inout%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
-	if (reg_wires.count(wire->name)) {
-		f << stringf("%s" "reg%s %s", indent.c_str(), range.c_str(), id(wire->name).c_str());
-		if (wire->attributes.count("\\init")) {
-			f << stringf(" = ");
-			dump_const(f, wire->attributes.at("\\init"));
+		f << indent << "inout" << range << ' ' << name << ";\n";
+	if (reg_wires.count(wire)) {
+		f << indent << "reg" << range << ' ' << name;
+		if (wire->attributes.count(VID::init)) {
+			f << " = ";
+			dump_const(f, wire->attributes.at(VID::init));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 	} else if (!wire->port_input && !wire->port_output)
-		f << stringf("%s" "wire%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "wire" << range << ' ' << name << ";\n";
 #endif
 }
 
-void dump_memory(std::ostream &f, std::string indent, RTLIL::Memory *memory)
+void dump_memory(std::ostream &f, const std::string &indent, RTLIL::Memory *memory)
 {
 	dump_attributes(f, indent, memory->attributes);
 	f << stringf("%s" "reg [%d:0] %s [%d:%d];\n", indent.c_str(), memory->width-1, id(memory->name).c_str(), memory->size+memory->start_offset-1, memory->start_offset);
 }
 
-void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, std::string port, bool gen_signed = true)
+void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, const RTLIL::IdString &port, bool gen_signed = true)
 {
-	if (gen_signed && cell->parameters.count("\\" + port + "_SIGNED") > 0 && cell->parameters["\\" + port + "_SIGNED"].as_bool()) {
-		f << stringf("$signed(");
-		dump_sigspec(f, cell->getPort("\\" + port));
-		f << stringf(")");
-	} else
-		dump_sigspec(f, cell->getPort("\\" + port));
+	if (gen_signed) {
+		log_assert(port == VID::A || port == VID::B);
+		auto it = cell->parameters.find(port == VID::A ? VID::A_SIGNED : VID::B_SIGNED);
+		if (it != cell->parameters.end() && it->second.as_bool()) {
+			f << "$signed(";
+			dump_sigspec(f, cell->connections_.at(port));
+			f << ")";
+			return;
+		}
+	}
+	dump_sigspec(f, cell->connections_.at(port));
 }
 
-std::string cellname(RTLIL::Cell *cell)
+// Returns the '<wire>_reg' name of a register cell with an internal name, or
+// an empty string. This is called by prepare_module() on the main thread, as
+// it creates IdStrings.
+std::string reg_cell_name(RTLIL::Module *module, RTLIL::Cell *cell)
 {
-	if (!norename && cell->name[0] == '$' && reg_ct.count(cell->type) && cell->hasPort("\\Q"))
-	{
-		RTLIL::SigSpec sig = cell->getPort("\\Q");
-		if (GetSize(sig) != 1 || sig.is_fully_const())
-			goto no_special_reg_name;
+	if (norename || cell->name[0] != '$' || !reg_ct.count(cell->type) || !cell->hasPort(VID::Q))
+		return std::string();
 
-		RTLIL::Wire *wire = sig[0].wire;
+	RTLIL::SigSpec sig = cell->getPort(VID::Q);
+	if (GetSize(sig) != 1 || sig.is_fully_const())
+		return std::string();
 
-		if (wire->name[0] != '\\')
-			goto no_special_reg_name;
+	RTLIL::Wire *wire = sig[0].wire;
 
-		std::string cell_name = wire->name.str();
+	if (wire->name[0] != '\\')
+		return std::string();
 
-		size_t pos = cell_name.find('[');
-		if (pos != std::string::npos)
-			cell_name = cell_name.substr(0, pos) + "_reg" + cell_name.substr(pos);
-		else
-			cell_name = cell_name + "_reg";
+	std::string cell_name = wire->name.str();
 
-		if (wire->width != 1)
-			cell_name += stringf("[%d]", wire->start_offset + sig[0].offset);
+	size_t pos = cell_name.find('[');
+	if (pos != std::string::npos)
+		cell_name = cell_name.substr(0, pos) + "_reg" + cell_name.substr(pos);
+	else
+		cell_name = cell_name + "_reg";
 
-		if (active_module && active_module->count_id(cell_name) > 0)
-				goto no_special_reg_name;
+	if (wire->width != 1)
+		cell_name += stringf("[%d]", wire->start_offset + sig[0].offset);
 
-		return id(cell_name);
-	}
-	else
-	{
-no_special_reg_name:
-		return id(cell->name).c_str();
-	}
+	if (module->count_id(cell_name) > 0)
+		return std::string();
+
+	return cell_name;
 }
 
-void dump_cell_expr_uniop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+std::string cellname(RTLIL::Cell *cell)
 {
-	f << stringf("%s" "assign ", indent.c_str());
-	dump_sigspec(f, cell->getPort("\\Y"));
-	f << stringf(" = %s ", op.c_str());
+	auto it = reg_cell_names.find(cell);
+	if (it != reg_cell_names.end())
+		return id(it->second.c_str());
+	return id(cell->name);
+}
+
+void dump_cell_expr_uniop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const char *op)
+{
+	f << indent << "assign ";
+	dump_sigspec(f, cell->connections_.at(VID::Y));
+	f << " = " << op << ' ';
 	dump_attributes(f, "", cell->attributes, ' ');
-	dump_cell_expr_port(f, cell, "A", true);
-	f << stringf(";\n");
+	dump_cell_expr_port(f, cell, VID::A, true);
+	f << ";\n";
 }
 
-void dump_cell_expr_binop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+void dump_cell_expr_binop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const char *op)
 {
-	f << stringf("%s" "assign ", indent.c_str());
-	dump_sigspec(f, cell->getPort("\\Y"));
-	f << stringf(" = ");
-	dump_cell_expr_port(f, cell, "A", true);
-	f << stringf(" %s ", op.c_str());
+	f << indent << "assign ";
+	dump_sigspec(f, cell->connections_.at(VID::Y));
+	f << " = ";
+	dump_cell_expr_port(f, cell, VID::A, true);
+	f << ' ' << op << ' ';
 	dump_attributes(f, "", cell->attributes, ' ');
-	dump_cell_expr_port(f, cell, "B", true);
-	f << stringf(";\n");
+	dump_cell_expr_port(f, cell, VID::B, true);
+	f << ";\n";
 }
 
-bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+bool dump_cell_expr(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
-	if (cell->type == "$_NOT_") {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		f << stringf("~");
+	if (cell->type == VID::$_NOT_) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		f << "~";
 		dump_attributes(f, "", cell->attributes, ' ');
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type.in("$_AND_", "$_NAND_", "$_OR_", "$_NOR_", "$_XOR_", "$_XNOR_", "$_ANDNOT_", "$_ORNOT_")) {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		if (cell->type.in("$_NAND_", "$_NOR_", "$_XNOR_"))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(" ");
-		if (cell->type.in("$_AND_", "$_NAND_", "$_ANDNOT_"))
-			f << stringf("&");
-		if (cell->type.in("$_OR_", "$_NOR_", "$_ORNOT_"))
-			f << stringf("|");
-		if (cell->type.in("$_XOR_", "$_XNOR_"))
-			f << stringf("^");
+	if (type_in(cell, VID::$_AND_, VID::$_NAND_, VID::$_OR_, VID::$_NOR_, VID::$_XOR_, VID::$_XNOR_, VID::$_ANDNOT_, VID::$_ORNOT_)) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		if (type_in(cell, VID::$_NAND_, VID::$_NOR_, VID::$_XNOR_))
+			f << "~(";
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << " ";
+		if (type_in(cell, VID::$_AND_, VID::$_NAND_, VID::$_ANDNOT_))
+			f << "&";
+		if (type_in(cell, VID::$_OR_, VID::$_NOR_, VID::$_ORNOT_))
+			f << "|";
+		if (type_in(cell, VID::$_XOR_, VID::$_XNOR_))
+			f << "^";
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" ");
-		if (cell->type.in("$_ANDNOT_", "$_ORNOT_"))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "B", false);
-		if (cell->type.in("$_NAND_", "$_NOR_", "$_XNOR_", "$_ANDNOT_", "$_ORNOT_"))
-			f << stringf(")");
-		f << stringf(";\n");
+		f << " ";
+		if (type_in(cell, VID::$_ANDNOT_, VID::$_ORNOT_))
+			f << "~(";
+		dump_cell_expr_port(f, cell, VID::B, false);
+		if (type_in(cell, VID::$_NAND_, VID::$_NOR_, VID::$_XNOR_, VID::$_ANDNOT_, VID::$_ORNOT_))
+			f << ")";
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type == "$_MUX_") {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+	if (cell->type == VID::$_MUX_) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		dump_cell_expr_port(f, cell, VID::S, false);
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::B, false);
+		f << " : ";
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type == "$_NMUX_") {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = !(");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+	if (cell->type == VID::$_NMUX_) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = !(";
+		dump_cell_expr_port(f, cell, VID::S, false);
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(");\n");
+		dump_cell_expr_port(f, cell, VID::B, false);
+		f << " : ";
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << ");\n";
 		return true;
 	}
 
-	if (cell->type.in("$_AOI3_", "$_OAI3_")) {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(cell->type == "$_AOI3_" ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(cell->type == "$_AOI3_" ? ") |" : ") &");
+	if (type_in(cell, VID::$_AOI3_, VID::$_OAI3_)) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ~((";
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << stringf(cell->type == VID::$_AOI3_ ? " & " : " | ");
+		dump_cell_expr_port(f, cell, VID::B, false);
+		f << stringf(cell->type == VID::$_AOI3_ ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" ");
-		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(");\n");
+		f << " ";
+		dump_cell_expr_port(f, cell, VID::C, false);
+		f << ");\n";
 		return true;
 	}
 
-	if (cell->type.in("$_AOI4_", "$_OAI4_")) {
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(cell->type == "$_AOI4_" ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(cell->type == "$_AOI4_" ? ") |" : ") &");
+	if (type_in(cell, VID::$_AOI4_, VID::$_OAI4_)) {
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ~((";
+		dump_cell_expr_port(f, cell, VID::A, false);
+		f << stringf(cell->type == VID::$_AOI4_ ? " & " : " | ");
+		dump_cell_expr_port(f, cell, VID::B, false);
+		f << stringf(cell->type == VID::$_AOI4_ ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, ' ');
-		f << stringf(" (");
-		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(cell->type == "$_AOI4_" ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf("));\n");
+		f << " (";
+		dump_cell_expr_port(f, cell, VID::C, false);
+		f << stringf(cell->type == VID::$_AOI4_ ? " & " : " | ");
+		dump_cell_expr_port(f, cell, VID::D, false);
+		f << "));\n";
 		return true;
 	}
 
 	if (cell->type.begins_with("$_DFF_"))
 	{
 		std::string reg_name = cellname(cell);
-		bool out_is_reg_wire = is_reg_wire(cell->getPort("\\Q"), reg_name);
+		bool out_is_reg_wire = is_reg_wire(cell->connections_.at(VID::Q), reg_name);
 
 		if (!out_is_reg_wire) {
 			f << stringf("%s" "reg %s", indent.c_str(), reg_name.c_str());
-			dump_reg_init(f, cell->getPort("\\Q"));
+			dump_reg_init(f, cell->connections_.at(VID::Q));
 			f << ";\n";
 		}
 
 		dump_attributes(f, indent, cell->attributes);
 		f << stringf("%s" "always @(%sedge ", indent.c_str(), cell->type[6] == 'P' ? "pos" : "neg");
-		dump_sigspec(f, cell->getPort("\\C"));
+		dump_sigspec(f, cell->connections_.at(VID::C));
 		if (cell->type[7] != '_') {
 			f << stringf(" or %sedge ", cell->type[7] == 'P' ? "pos" : "neg");
-			dump_sigspec(f, cell->getPort("\\R"));
+			dump_sigspec(f, cell->connections_.at(VID::R));
 		}
-		f << stringf(")\n");
+		f << ")\n";
 
 		if (cell->type[7] != '_') {
 			f << stringf("%s" "  if (%s", indent.c_str(), cell->type[7] == 'P' ? "" : "!");
-			dump_sigspec(f, cell->getPort("\\R"));
-			f << stringf(")\n");
+			dump_sigspec(f, cell->connections_.at(VID::R));
+			f << ")\n";
 			f << stringf("%s" "    %s <= %c;\n", indent.c_str(), reg_name.c_str(), cell->type[8]);
-			f << stringf("%s" "  else\n", indent.c_str());
+			f << indent << "  else\n";
 		}
 
 		f << stringf("%s" "    %s <= ", indent.c_str(), reg_name.c_str());
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::D, false);
+		f << ";\n";
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
-			dump_sigspec(f, cell->getPort("\\Q"));
+			f << indent << "assign ";
+			dump_sigspec(f, cell->connections_.at(VID::Q));
 			f << stringf(" = %s;\n", reg_name.c_str());
 		}
 
@@ -651,41 +766,41 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		char pol_c = cell->type[8], pol_s = cell->type[9], pol_r = cell->type[10];
 
 		std::string reg_name = cellname(cell);
-		bool out_is_reg_wire = is_reg_wire(cell->getPort("\\Q"), reg_name);
+		bool out_is_reg_wire = is_reg_wire(cell->connections_.at(VID::Q), reg_name);
 
 		if (!out_is_reg_wire) {
 			f << stringf("%s" "reg %s", indent.c_str(), reg_name.c_str());
-			dump_reg_init(f, cell->getPort("\\Q"));
+			dump_reg_init(f, cell->connections_.at(VID::Q));
 			f << ";\n";
 		}
 
 		dump_attributes(f, indent, cell->attributes);
 		f << stringf("%s" "always @(%sedge ", indent.c_str(), pol_c == 'P' ? "pos" : "neg");
-		dump_sigspec(f, cell->getPort("\\C"));
+		dump_sigspec(f, cell->connections_.at(VID::C));
 		f << stringf(" or %sedge ", pol_s == 'P' ? "pos" : "neg");
-		dump_sigspec(f, cell->getPort("\\S"));
+		dump_sigspec(f, cell->connections_.at(VID::S));
 		f << stringf(" or %sedge ", pol_r == 'P' ? "pos" : "neg");
-		dump_sigspec(f, cell->getPort("\\R"));
-		f << stringf(")\n");
+		dump_sigspec(f, cell->connections_.at(VID::R));
+		f << ")\n";
 
 		f << stringf("%s" "  if (%s", indent.c_str(), pol_r == 'P' ? "" : "!");
-		dump_sigspec(f, cell->getPort("\\R"));
-		f << stringf(")\n");
+		dump_sigspec(f, cell->connections_.at(VID::R));
+		f << ")\n";
 		f << stringf("%s" "    %s <= 0;\n", indent.c_str(), reg_name.c_str());
 
 		f << stringf("%s" "  else if (%s", indent.c_str(), pol_s == 'P' ? "" : "!");
-		dump_sigspec(f, cell->getPort("\\S"));
-		f << stringf(")\n");
+		dump_sigspec(f, cell->connections_.at(VID::S));
+		f << ")\n";
 		f << stringf("%s" "    %s <= 1;\n", indent.c_str(), reg_name.c_str());
 
-		f << stringf("%s" "  else\n", indent.c_str());
+		f << indent << "  else\n";
 		f << stringf("%s" "    %s <= ", indent.c_str(), reg_name.c_str());
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::D, false);
+		f << ";\n";
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
-			dump_sigspec(f, cell->getPort("\\Q"));
+			f << indent << "assign ";
+			dump_sigspec(f, cell->connections_.at(VID::Q));
 			f << stringf(" = %s;\n", reg_name.c_str());
 		}
 
@@ -697,117 +812,117 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 #define HANDLE_BINOP(_type, _operator) \
 	if (cell->type ==_type) { dump_cell_expr_binop(f, indent, cell, _operator); return true; }
 
-	HANDLE_UNIOP("$not", "~")
-	HANDLE_UNIOP("$pos", "+")
-	HANDLE_UNIOP("$neg", "-")
-
-	HANDLE_BINOP("$and",  "&")
-	HANDLE_BINOP("$or",   "|")
-	HANDLE_BINOP("$xor",  "^")
-	HANDLE_BINOP("$xnor", "~^")
-
-	HANDLE_UNIOP("$reduce_and",  "&")
-	HANDLE_UNIOP("$reduce_or",   "|")
-	HANDLE_UNIOP("$reduce_xor",  "^")
-	HANDLE_UNIOP("$reduce_xnor", "~^")
-	HANDLE_UNIOP("$reduce_bool", "|")
-
-	HANDLE_BINOP("$shl",  "<<")
-	HANDLE_BINOP("$shr",  ">>")
-	HANDLE_BINOP("$sshl", "<<<")
-	HANDLE_BINOP("$sshr", ">>>")
-
-	HANDLE_BINOP("$lt",  "<")
-	HANDLE_BINOP("$le",  "<=")
-	HANDLE_BINOP("$eq",  "==")
-	HANDLE_BINOP("$ne",  "!=")
-	HANDLE_BINOP("$eqx", "===")
-	HANDLE_BINOP("$nex", "!==")
-	HANDLE_BINOP("$ge",  ">=")
-	HANDLE_BINOP("$gt",  ">")
-
-	HANDLE_BINOP("$add", "+")
-	HANDLE_BINOP("$sub", "-")
-	HANDLE_BINOP("$mul", "*")
-	HANDLE_BINOP("$div", "/")
-	HANDLE_BINOP("$mod", "%")
-	HANDLE_BINOP("$pow", "**")
-
-	HANDLE_UNIOP("$logic_not", "!")
-	HANDLE_BINOP("$logic_and", "&&")
-	HANDLE_BINOP("$logic_or",  "||")
+	HANDLE_UNIOP(VID::$not, "~")
+	HANDLE_UNIOP(VID::$pos, "+")
+	HANDLE_UNIOP(VID::$neg, "-")
+
+	HANDLE_BINOP(VID::$and,  "&")
+	HANDLE_BINOP(VID::$or,   "|")
+	HANDLE_BINOP(VID::$xor,  "^")
+	HANDLE_BINOP(VID::$xnor, "~^")
+
+	HANDLE_UNIOP(VID::$reduce_and,  "&")
+	HANDLE_UNIOP(VID::$reduce_or,   "|")
+	HANDLE_UNIOP(VID::$reduce_xor,  "^")
+	HANDLE_UNIOP(VID::$reduce_xnor, "~^")
+	HANDLE_UNIOP(VID::$reduce_bool, "|")
+
+	HANDLE_BINOP(VID::$shl,  "<<")
+	HANDLE_BINOP(VID::$shr,  ">>")
+	HANDLE_BINOP(VID::$sshl, "<<<")
+	HANDLE_BINOP(VID::$sshr, ">>>")
+
+	HANDLE_BINOP(VID::$lt,  "<")
+	HANDLE_BINOP(VID::$le,  "<=")
+	HANDLE_BINOP(VID::$eq,  "==")
+	HANDLE_BINOP(VID::$ne,  "!=")
+	HANDLE_BINOP(VID::$eqx, "===")
+	HANDLE_BINOP(VID::$nex, "!==")
+	HANDLE_BINOP(VID::$ge,  ">=")
+	HANDLE_BINOP(VID::$gt,  ">")
+
+	HANDLE_BINOP(VID::$add, "+")
+	HANDLE_BINOP(VID::$sub, "-")
+	HANDLE_BINOP(VID::$mul, "*")
+	HANDLE_BINOP(VID::$div, "/")
+	HANDLE_BINOP(VID::$mod, "%")
+	HANDLE_BINOP(VID::$pow, "**")
+
+	HANDLE_UNIOP(VID::$logic_not, "!")
+	HANDLE_BINOP(VID::$logic_and, "&&")
+	HANDLE_BINOP(VID::$logic_or,  "||")
 
 #undef HANDLE_UNIOP
 #undef HANDLE_BINOP
 
-	if (cell->type == "$shift")
+	if (cell->type == VID::$shift)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		if (cell->getParam("\\B_SIGNED").as_bool())
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		if (cell->parameters.at(VID::B_SIGNED).as_bool())
 		{
-			f << stringf("$signed(");
-			dump_sigspec(f, cell->getPort("\\B"));
-			f << stringf(")");
-			f << stringf(" < 0 ? ");
-			dump_sigspec(f, cell->getPort("\\A"));
-			f << stringf(" << - ");
-			dump_sigspec(f, cell->getPort("\\B"));
-			f << stringf(" : ");
-			dump_sigspec(f, cell->getPort("\\A"));
-			f << stringf(" >> ");
-			dump_sigspec(f, cell->getPort("\\B"));
+			f << "$signed(";
+			dump_sigspec(f, cell->connections_.at(VID::B));
+			f << ")";
+			f << " < 0 ? ";
+			dump_sigspec(f, cell->connections_.at(VID::A));
+			f << " << - ";
+			dump_sigspec(f, cell->connections_.at(VID::B));
+			f << " : ";
+			dump_sigspec(f, cell->connections_.at(VID::A));
+			f << " >> ";
+			dump_sigspec(f, cell->connections_.at(VID::B));
 		}
 		else
 		{
-			dump_sigspec(f, cell->getPort("\\A"));
-			f << stringf(" >> ");
-			dump_sigspec(f, cell->getPort("\\B"));
+			dump_sigspec(f, cell->connections_.at(VID::A));
+			f << " >> ";
+			dump_sigspec(f, cell->connections_.at(VID::B));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type == "$shiftx")
+	if (cell->type == VID::$shiftx)
 	{
 		std::string temp_id = next_auto_id();
-		f << stringf("%s" "wire [%d:0] %s = ", indent.c_str(), GetSize(cell->getPort("\\A"))-1, temp_id.c_str());
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(";\n");
+		f << stringf("%s" "wire [%d:0] %s = ", indent.c_str(), GetSize(cell->connections_.at(VID::A))-1, temp_id.c_str());
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << ";\n";
 
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
 		f << stringf(" = %s[", temp_id.c_str());
-		if (cell->getParam("\\B_SIGNED").as_bool())
-			f << stringf("$signed(");
-		dump_sigspec(f, cell->getPort("\\B"));
-		if (cell->getParam("\\B_SIGNED").as_bool())
-			f << stringf(")");
-		f << stringf(" +: %d", cell->getParam("\\Y_WIDTH").as_int());
-		f << stringf("];\n");
+		if (cell->parameters.at(VID::B_SIGNED).as_bool())
+			f << "$signed(";
+		dump_sigspec(f, cell->connections_.at(VID::B));
+		if (cell->parameters.at(VID::B_SIGNED).as_bool())
+			f << ")";
+		f << stringf(" +: %d", cell->parameters.at(VID::Y_WIDTH).as_int());
+		f << "];\n";
 		return true;
 	}
 
-	if (cell->type == "$mux")
+	if (cell->type == VID::$mux)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		dump_sigspec(f, cell->getPort("\\S"));
-		f << stringf(" ? ");
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		dump_sigspec(f, cell->connections_.at(VID::S));
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, ' ');
-		dump_sigspec(f, cell->getPort("\\B"));
-		f << stringf(" : ");
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(";\n");
+		dump_sigspec(f, cell->connections_.at(VID::B));
+		f << " : ";
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type == "$pmux")
+	if (cell->type == VID::$pmux)
 	{
-		int width = cell->parameters["\\WIDTH"].as_int();
-		int s_width = cell->getPort("\\S").size();
+		int width = cell->parameters.at(VID::WIDTH).as_int();
+		int s_width = cell->connections_.at(VID::S).size();
 		std::string func_name = cellname(cell);
 
 		f << stringf("%s" "function [%d:0] %s;\n", indent.c_str(), width-1, func_name.c_str());
@@ -817,8 +932,8 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 		dump_attributes(f, indent + "  ", cell->attributes);
 		if (!noattr)
-			f << stringf("%s" "  (* parallel_case *)\n", indent.c_str());
-		f << stringf("%s" "  casez (s)", indent.c_str());
+			f << indent << "  (* parallel_case *)\n";
+		f << indent << "  casez (s)";
 		f << stringf(noattr ? " // synopsys parallel_case\n" : "\n");
 
 		for (int i = 0; i < s_width; i++)
@@ -828,87 +943,87 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			for (int j = s_width-1; j >= 0; j--)
 				f << stringf("%c", j == i ? '1' : '?');
 
-			f << stringf(":\n");
+			f << ":\n";
 			f << stringf("%s" "      %s = b[%d:%d];\n", indent.c_str(), func_name.c_str(), (i+1)*width-1, i*width);
 		}
 
-		f << stringf("%s" "    default:\n", indent.c_str());
+		f << indent << "    default:\n";
 		f << stringf("%s" "      %s = a;\n", indent.c_str(), func_name.c_str());
 
-		f << stringf("%s" "  endcase\n", indent.c_str());
-		f << stringf("%s" "endfunction\n", indent.c_str());
+		f << indent << "  endcase\n";
+		f << indent << "endfunction\n";
 
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
 		f << stringf(" = %s(", func_name.c_str());
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(", ");
-		dump_sigspec(f, cell->getPort("\\B"));
-		f << stringf(", ");
-		dump_sigspec(f, cell->getPort("\\S"));
-		f << stringf(");\n");
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << ", ";
+		dump_sigspec(f, cell->connections_.at(VID::B));
+		f << ", ";
+		dump_sigspec(f, cell->connections_.at(VID::S));
+		f << ");\n";
 		return true;
 	}
 
-	if (cell->type == "$tribuf")
+	if (cell->type == VID::$tribuf)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		dump_sigspec(f, cell->getPort("\\EN"));
-		f << stringf(" ? ");
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(" : %d'bz;\n", cell->parameters.at("\\WIDTH").as_int());
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		dump_sigspec(f, cell->connections_.at(VID::EN));
+		f << " ? ";
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << stringf(" : %d'bz;\n", cell->parameters.at(VID::WIDTH).as_int());
 		return true;
 	}
 
-	if (cell->type == "$slice")
+	if (cell->type == VID::$slice)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(" >> %d;\n", cell->parameters.at("\\OFFSET").as_int());
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << stringf(" >> %d;\n", cell->parameters.at(VID::OFFSET).as_int());
 		return true;
 	}
 
-	if (cell->type == "$concat")
+	if (cell->type == VID::$concat)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = { ");
-		dump_sigspec(f, cell->getPort("\\B"));
-		f << stringf(" , ");
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(" };\n");
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = { ";
+		dump_sigspec(f, cell->connections_.at(VID::B));
+		f << " , ";
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << " };\n";
 		return true;
 	}
 
-	if (cell->type == "$lut")
+	if (cell->type == VID::$lut)
 	{
-		f << stringf("%s" "assign ", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\Y"));
-		f << stringf(" = ");
-		dump_const(f, cell->parameters.at("\\LUT"));
-		f << stringf(" >> ");
+		f << indent << "assign ";
+		dump_sigspec(f, cell->connections_.at(VID::Y));
+		f << " = ";
+		dump_const(f, cell->parameters.at(VID::LUT));
+		f << " >> ";
 		dump_attributes(f, "", cell->attributes, ' ');
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(";\n");
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << ";\n";
 		return true;
 	}
 
-	if (cell->type == "$dffsr")
+	if (cell->type == VID::$dffsr)
 	{
-		SigSpec sig_clk = cell->getPort("\\CLK");
-		SigSpec sig_set = cell->getPort("\\SET");
-		SigSpec sig_clr = cell->getPort("\\CLR");
-		SigSpec sig_d = cell->getPort("\\D");
-		SigSpec sig_q = cell->getPort("\\Q");
+		SigSpec sig_clk = cell->connections_.at(VID::CLK);
+		SigSpec sig_set = cell->connections_.at(VID::SET);
+		SigSpec sig_clr = cell->connections_.at(VID::CLR);
+		SigSpec sig_d = cell->connections_.at(VID::D);
+		SigSpec sig_q = cell->connections_.at(VID::Q);
 
-		int width = cell->parameters["\\WIDTH"].as_int();
-		bool pol_clk = cell->parameters["\\CLK_POLARITY"].as_bool();
-		bool pol_set = cell->parameters["\\SET_POLARITY"].as_bool();
-		bool pol_clr = cell->parameters["\\CLR_POLARITY"].as_bool();
+		int width = cell->parameters.at(VID::WIDTH).as_int();
+		bool pol_clk = cell->parameters.at(VID::CLK_POLARITY).as_bool();
+		bool pol_set = cell->parameters.at(VID::SET_POLARITY).as_bool();
+		bool pol_clr = cell->parameters.at(VID::CLR_POLARITY).as_bool();
 
 		std::string reg_name = cellname(cell);
 		bool out_is_reg_wire = is_reg_wire(sig_q, reg_name);
@@ -926,7 +1041,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			dump_sigspec(f, sig_set);
 			f << stringf(", %sedge ", pol_clr ? "pos" : "neg");
 			dump_sigspec(f, sig_clr);
-			f << stringf(")\n");
+			f << ")\n";
 
 			f << stringf("%s" "  if (%s", indent.c_str(), pol_clr ? "" : "!");
 			dump_sigspec(f, sig_clr);
@@ -938,11 +1053,11 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 			f << stringf("%s" "  else  %s[%d] <= ", indent.c_str(), reg_name.c_str(), i);
 			dump_sigspec(f, sig_d[i]);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
+			f << indent << "assign ";
 			dump_sigspec(f, sig_q);
 			f << stringf(" = %s;\n", reg_name.c_str());
 		}
@@ -950,116 +1065,115 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		return true;
 	}
 
-	if (cell->type.in("$dff", "$adff", "$dffe"))
+	if (type_in(cell, VID::$dff, VID::$adff, VID::$dffe))
 	{
 		RTLIL::SigSpec sig_clk, sig_arst, sig_en, val_arst;
 		bool pol_clk, pol_arst = false, pol_en = false;
 
-		sig_clk = cell->getPort("\\CLK");
-		pol_clk = cell->parameters["\\CLK_POLARITY"].as_bool();
+		sig_clk = cell->connections_.at(VID::CLK);
+		pol_clk = cell->parameters.at(VID::CLK_POLARITY).as_bool();
 
-		if (cell->type == "$adff") {
-			sig_arst = cell->getPort("\\ARST");
-			pol_arst = cell->parameters["\\ARST_POLARITY"].as_bool();
-			val_arst = RTLIL::SigSpec(cell->parameters["\\ARST_VALUE"]);
+		if (cell->type == VID::$adff) {
+			sig_arst = cell->connections_.at(VID::ARST);
+			pol_arst = cell->parameters.at(VID::ARST_POLARITY).as_bool();
+			val_arst = RTLIL::SigSpec(cell->parameters.at(VID::ARST_VALUE));
 		}
 
-		if (cell->type == "$dffe") {
-			sig_en = cell->getPort("\\EN");
-			pol_en = cell->parameters["\\EN_POLARITY"].as_bool();
+		if (cell->type == VID::$dffe) {
+			sig_en = cell->connections_.at(VID::EN);
+			pol_en = cell->parameters.at(VID::EN_POLARITY).as_bool();
 		}
 
 		std::string reg_name = cellname(cell);
-		bool out_is_reg_wire = is_reg_wire(cell->getPort("\\Q"), reg_name);
+		bool out_is_reg_wire = is_reg_wire(cell->connections_.at(VID::Q), reg_name);
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "reg [%d:0] %s", indent.c_str(), cell->parameters["\\WIDTH"].as_int()-1, reg_name.c_str());
-			dump_reg_init(f, cell->getPort("\\Q"));
+			f << stringf("%s" "reg [%d:0] %s", indent.c_str(), cell->parameters.at(VID::WIDTH).as_int()-1, reg_name.c_str());
+			dump_reg_init(f, cell->connections_.at(VID::Q));
 			f << ";\n";
 		}
 
 		f << stringf("%s" "always @(%sedge ", indent.c_str(), pol_clk ? "pos" : "neg");
 		dump_sigspec(f, sig_clk);
-		if (cell->type == "$adff") {
+		if (cell->type == VID::$adff) {
 			f << stringf(" or %sedge ", pol_arst ? "pos" : "neg");
 			dump_sigspec(f, sig_arst);
 		}
-		f << stringf(")\n");
+		f << ")\n";
 
-		if (cell->type == "$adff") {
+		if (cell->type == VID::$adff) {
 			f << stringf("%s" "  if (%s", indent.c_str(), pol_arst ? "" : "!");
 			dump_sigspec(f, sig_arst);
-			f << stringf(")\n");
+			f << ")\n";
 			f << stringf("%s" "    %s <= ", indent.c_str(), reg_name.c_str());
 			dump_sigspec(f, val_arst);
-			f << stringf(";\n");
-			f << stringf("%s" "  else\n", indent.c_str());
+			f << ";\n";
+			f << indent << "  else\n";
 		}
 
-		if (cell->type == "$dffe") {
+		if (cell->type == VID::$dffe) {
 			f << stringf("%s" "  if (%s", indent.c_str(), pol_en ? "" : "!");
 			dump_sigspec(f, sig_en);
-			f << stringf(")\n");
+			f << ")\n";
 		}
 
 		f << stringf("%s" "    %s <= ", indent.c_str(), reg_name.c_str());
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::D, false);
+		f << ";\n";
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
-			dump_sigspec(f, cell->getPort("\\Q"));
+			f << indent << "assign ";
+			dump_sigspec(f, cell->connections_.at(VID::Q));
 			f << stringf(" = %s;\n", reg_name.c_str());
 		}
 
 		return true;
 	}
 
-	if (cell->type == "$dlatch")
+	if (cell->type == VID::$dlatch)
 	{
 		RTLIL::SigSpec sig_en;
 		bool pol_en = false;
 
-		sig_en = cell->getPort("\\EN");
-		pol_en = cell->parameters["\\EN_POLARITY"].as_bool();
+		sig_en = cell->connections_.at(VID::EN);
+		pol_en = cell->parameters.at(VID::EN_POLARITY).as_bool();
 
 		std::string reg_name = cellname(cell);
-		bool out_is_reg_wire = is_reg_wire(cell->getPort("\\Q"), reg_name);
+		bool out_is_reg_wire = is_reg_wire(cell->connections_.at(VID::Q), reg_name);
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "reg [%d:0] %s", indent.c_str(), cell->parameters["\\WIDTH"].as_int()-1, reg_name.c_str());
-			dump_reg_init(f, cell->getPort("\\Q"));
+			f << stringf("%s" "reg [%d:0] %s", indent.c_str(), cell->parameters.at(VID::WIDTH).as_int()-1, reg_name.c_str());
+			dump_reg_init(f, cell->connections_.at(VID::Q));
 			f << ";\n";
 		}
 
-		f << stringf("%s" "always @*\n", indent.c_str());
+		f << indent << "always @*\n";
 
 		f << stringf("%s" "  if (%s", indent.c_str(), pol_en ? "" : "!");
 		dump_sigspec(f, sig_en);
-		f << stringf(")\n");
+		f << ")\n";
 
 		f << stringf("%s" "    %s = ", indent.c_str(), reg_name.c_str());
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, VID::D, false);
+		f << ";\n";
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
-			dump_sigspec(f, cell->getPort("\\Q"));
+			f << indent << "assign ";
+			dump_sigspec(f, cell->connections_.at(VID::Q));
 			f << stringf(" = %s;\n", reg_name.c_str());
 		}
 
 		return true;
 	}
 
-	if (cell->type == "$mem")
+	if (cell->type == VID::$mem)
 	{
-		RTLIL::IdString memid = cell->parameters["\\MEMID"].decode_string();
-		std::string mem_id = id(cell->parameters["\\MEMID"].decode_string());
-		int abits = cell->parameters["\\ABITS"].as_int();
-		int size = cell->parameters["\\SIZE"].as_int();
-		int offset = cell->parameters["\\OFFSET"].as_int();
-		int width = cell->parameters["\\WIDTH"].as_int();
-		bool use_init = !(RTLIL::SigSpec(cell->parameters["\\INIT"]).is_fully_undef());
+		std::string mem_id = id(mem_ids.at(cell));
+		int abits = cell->parameters.at(VID::ABITS).as_int();
+		int size = cell->parameters.at(VID::SIZE).as_int();
+		int offset = cell->parameters.at(VID::OFFSET).as_int();
+		int width = cell->parameters.at(VID::WIDTH).as_int();
+		bool use_init = !(RTLIL::SigSpec(cell->parameters.at(VID::INIT)).is_fully_undef());
 
 		// for memory block make something like:
 		//  reg [7:0] memid [3:0];
@@ -1099,7 +1213,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 				{
 					for (int i=0; i<size; i++)
 					{
-						RTLIL::Const element = cell->parameters["\\INIT"].extract(i*width, width);
+						RTLIL::Const element = cell->parameters.at(VID::INIT).extract(i*width, width);
 						for (int j=0; j<element.size(); j++)
 						{
 							switch (element[element.size()-j-1])
@@ -1119,14 +1233,14 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			}
 			else
 			{
-				f << stringf("%s" "initial begin\n", indent.c_str());
+				f << indent << "initial begin\n";
 				for (int i=0; i<size; i++)
 				{
 					f << stringf("%s" "  %s[%d] = ", indent.c_str(), mem_id.c_str(), i);
-					dump_const(f, cell->parameters["\\INIT"].extract(i*width, width));
-					f << stringf(";\n");
+					dump_const(f, cell->parameters.at(VID::INIT).extract(i*width, width));
+					f << ";\n";
 				}
-				f << stringf("%s" "end\n", indent.c_str());
+				f << indent << "end\n";
 			}
 		}
 
@@ -1137,19 +1251,19 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		// create a list of reg declarations
 		std::vector<std::string> lof_reg_declarations;
 
-		int nread_ports = cell->parameters["\\RD_PORTS"].as_int();
+		int nread_ports = cell->parameters.at(VID::RD_PORTS).as_int();
 		RTLIL::SigSpec sig_rd_clk, sig_rd_en, sig_rd_data, sig_rd_addr;
 		bool use_rd_clk, rd_clk_posedge, rd_transparent;
 		// read ports
 		for (int i=0; i < nread_ports; i++)
 		{
-			sig_rd_clk = cell->getPort("\\RD_CLK").extract(i);
-			sig_rd_en = cell->getPort("\\RD_EN").extract(i);
-			sig_rd_data = cell->getPort("\\RD_DATA").extract(i*width, width);
-			sig_rd_addr = cell->getPort("\\RD_ADDR").extract(i*abits, abits);
-			use_rd_clk = cell->parameters["\\RD_CLK_ENABLE"].extract(i).as_bool();
-			rd_clk_posedge = cell->parameters["\\RD_CLK_POLARITY"].extract(i).as_bool();
-			rd_transparent = cell->parameters["\\RD_TRANSPARENT"].extract(i).as_bool();
+			sig_rd_clk = cell->connections_.at(VID::RD_CLK).extract(i);
+			sig_rd_en = cell->connections_.at(VID::RD_EN).extract(i);
+			sig_rd_data = cell->connections_.at(VID::RD_DATA).extract(i*width, width);
+			sig_rd_addr = cell->connections_.at(VID::RD_ADDR).extract(i*abits, abits);
+			use_rd_clk = cell->parameters.at(VID::RD_CLK_ENABLE).extract(i).as_bool();
+			rd_clk_posedge = cell->parameters.at(VID::RD_CLK_POLARITY).extract(i).as_bool();
+			rd_transparent = cell->parameters.at(VID::RD_TRANSPARENT).extract(i).as_bool();
 			if (use_rd_clk)
 			{
 				{
@@ -1221,18 +1335,18 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			}
 		}
 
-		int nwrite_ports = cell->parameters["\\WR_PORTS"].as_int();
+		int nwrite_ports = cell->parameters.at(VID::WR_PORTS).as_int();
 		RTLIL::SigSpec sig_wr_clk, sig_wr_data, sig_wr_addr, sig_wr_en;
 		bool wr_clk_posedge;
 
 		// write ports
 		for (int i=0; i < nwrite_ports; i++)
 		{
-			sig_wr_clk = cell->getPort("\\WR_CLK").extract(i);
-			sig_wr_data = cell->getPort("\\WR_DATA").extract(i*width, width);
-			sig_wr_addr = cell->getPort("\\WR_ADDR").extract(i*abits, abits);
-			sig_wr_en = cell->getPort("\\WR_EN").extract(i*width, width);
-			wr_clk_posedge = cell->parameters["\\WR_CLK_POLARITY"].extract(i).as_bool();
+			sig_wr_clk = cell->connections_.at(VID::WR_CLK).extract(i);
+			sig_wr_data = cell->connections_.at(VID::WR_DATA).extract(i*width, width);
+			sig_wr_addr = cell->connections_.at(VID::WR_ADDR).extract(i*abits, abits);
+			sig_wr_en = cell->connections_.at(VID::WR_EN).extract(i*width, width);
+			wr_clk_posedge = cell->parameters.at(VID::WR_CLK_POLARITY).extract(i).as_bool();
 			{
 				std::ostringstream os;
 				dump_sigspec(os, sig_wr_clk);
@@ -1306,7 +1420,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 				f << stringf("%s" "always @(%s) begin\n", indent.c_str(), clk_domain.c_str());
 				for(auto &line : lof_lines)
 					f << stringf("%s%s" "%s", indent.c_str(), indent.c_str(), line.c_str());
-				f << stringf("%s" "end\n", indent.c_str());
+				f << indent << "end\n";
 			}
 			else
 			{
@@ -1319,123 +1433,123 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		return true;
 	}
 
-	if (cell->type.in("$assert", "$assume", "$cover"))
+	if (type_in(cell, VID::$assert, VID::$assume, VID::$cover))
 	{
-		f << stringf("%s" "always @* if (", indent.c_str());
-		dump_sigspec(f, cell->getPort("\\EN"));
+		f << indent << "always @* if (";
+		dump_sigspec(f, cell->connections_.at(VID::EN));
 		f << stringf(") %s(", cell->type.c_str()+1);
-		dump_sigspec(f, cell->getPort("\\A"));
-		f << stringf(");\n");
+		dump_sigspec(f, cell->connections_.at(VID::A));
+		f << ");\n";
 		return true;
 	}
 
-	if (cell->type.in("$specify2", "$specify3"))
+	if (type_in(cell, VID::$specify2, VID::$specify3))
 	{
 		f << stringf("%s" "specify\n%s  ", indent.c_str(), indent.c_str());
 
-		SigSpec en = cell->getPort("\\EN");
+		SigSpec en = cell->connections_.at(VID::EN);
 		if (en != State::S1) {
-			f << stringf("if (");
-			dump_sigspec(f, cell->getPort("\\EN"));
-			f << stringf(") ");
+			f << "if (";
+			dump_sigspec(f, cell->connections_.at(VID::EN));
+			f << ") ";
 		}
 
 		f << "(";
-		if (cell->type == "$specify3" && cell->getParam("\\EDGE_EN").as_bool())
-			f << (cell->getParam("\\EDGE_POL").as_bool() ? "posedge ": "negedge ");
+		if (cell->type == VID::$specify3 && cell->parameters.at(VID::EDGE_EN).as_bool())
+			f << (cell->parameters.at(VID::EDGE_POL).as_bool() ? "posedge ": "negedge ");
 
-		dump_sigspec(f, cell->getPort("\\SRC"));
+		dump_sigspec(f, cell->connections_.at(VID::SRC));
 
 		f << " ";
-		if (cell->getParam("\\SRC_DST_PEN").as_bool())
-			f << (cell->getParam("\\SRC_DST_POL").as_bool() ? "+": "-");
-		f << (cell->getParam("\\FULL").as_bool() ? "*> ": "=> ");
+		if (cell->parameters.at(VID::SRC_DST_PEN).as_bool())
+			f << (cell->parameters.at(VID::SRC_DST_POL).as_bool() ? "+": "-");
+		f << (cell->parameters.at(VID::FULL).as_bool() ? "*> ": "=> ");
 
-		if (cell->type == "$specify3") {
+		if (cell->type == VID::$specify3) {
 			f << "(";
-			dump_sigspec(f, cell->getPort("\\DST"));
+			dump_sigspec(f, cell->connections_.at(VID::DST));
 			f << " ";
-			if (cell->getParam("\\DAT_DST_PEN").as_bool())
-				f << (cell->getParam("\\DAT_DST_POL").as_bool() ? "+": "-");
+			if (cell->parameters.at(VID::DAT_DST_PEN).as_bool())
+				f << (cell->parameters.at(VID::DAT_DST_POL).as_bool() ? "+": "-");
 			f << ": ";
-			dump_sigspec(f, cell->getPort("\\DAT"));
+			dump_sigspec(f, cell->connections_.at(VID::DAT));
 			f << ")";
 		} else {
-			dump_sigspec(f, cell->getPort("\\DST"));
+			dump_sigspec(f, cell->connections_.at(VID::DST));
 		}
 
 		bool bak_decimal = decimal;
 		decimal = 1;
 
 		f << ") = (";
-		dump_const(f, cell->getParam("\\T_RISE_MIN"));
+		dump_const(f, cell->parameters.at(VID::T_RISE_MIN));
 		f << ":";
-		dump_const(f, cell->getParam("\\T_RISE_TYP"));
+		dump_const(f, cell->parameters.at(VID::T_RISE_TYP));
 		f << ":";
-		dump_const(f, cell->getParam("\\T_RISE_MAX"));
+		dump_const(f, cell->parameters.at(VID::T_RISE_MAX));
 		f << ", ";
-		dump_const(f, cell->getParam("\\T_FALL_MIN"));
+		dump_const(f, cell->parameters.at(VID::T_FALL_MIN));
 		f << ":";
-		dump_const(f, cell->getParam("\\T_FALL_TYP"));
+		dump_const(f, cell->parameters.at(VID::T_FALL_TYP));
 		f << ":";
-		dump_const(f, cell->getParam("\\T_FALL_MAX"));
+		dump_const(f, cell->parameters.at(VID::T_FALL_MAX));
 		f << ");\n";
 
 		decimal = bak_decimal;
 
-		f << stringf("%s" "endspecify\n", indent.c_str());
+		f << indent << "endspecify\n";
 		return true;
 	}
 
-	if (cell->type == "$specrule")
+	if (cell->type == VID::$specrule)
 	{
 		f << stringf("%s" "specify\n%s  ", indent.c_str(), indent.c_str());
 
-		string spec_type = cell->getParam("\\TYPE").decode_string();
+		string spec_type = cell->parameters.at(VID::TYPE).decode_string();
 		f << stringf("%s(", spec_type.c_str());
 
-		if (cell->getParam("\\SRC_PEN").as_bool())
-			f << (cell->getParam("\\SRC_POL").as_bool() ? "posedge ": "negedge ");
-		dump_sigspec(f, cell->getPort("\\SRC"));
+		if (cell->parameters.at(VID::SRC_PEN).as_bool())
+			f << (cell->parameters.at(VID::SRC_POL).as_bool() ? "posedge ": "negedge ");
+		dump_sigspec(f, cell->connections_.at(VID::SRC));
 
-		if (cell->getPort("\\SRC_EN") != State::S1) {
+		if (cell->connections_.at(VID::SRC_EN) != State::S1) {
 			f << " &&& ";
-			dump_sigspec(f, cell->getPort("\\SRC_EN"));
+			dump_sigspec(f, cell->connections_.at(VID::SRC_EN));
 		}
 
 		f << ", ";
-		if (cell->getParam("\\DST_PEN").as_bool())
-			f << (cell->getParam("\\DST_POL").as_bool() ? "posedge ": "negedge ");
-		dump_sigspec(f, cell->getPort("\\DST"));
+		if (cell->parameters.at(VID::DST_PEN).as_bool())
+			f << (cell->parameters.at(VID::DST_POL).as_bool() ? "posedge ": "negedge ");
+		dump_sigspec(f, cell->connections_.at(VID::DST));
 
-		if (cell->getPort("\\DST_EN") != State::S1) {
+		if (cell->connections_.at(VID::DST_EN) != State::S1) {
 			f << " &&& ";
-			dump_sigspec(f, cell->getPort("\\DST_EN"));
+			dump_sigspec(f, cell->connections_.at(VID::DST_EN));
 		}
 
 		bool bak_decimal = decimal;
 		decimal = 1;
 
 		f << ", ";
-		dump_const(f, cell->getParam("\\T_LIMIT_MIN"));
+		dump_const(f, cell->parameters.at(VID::T_LIMIT_MIN));
 		f << ": ";
-		dump_const(f, cell->getParam("\\T_LIMIT_TYP"));
+		dump_const(f, cell->parameters.at(VID::T_LIMIT_TYP));
 		f << ": ";
-		dump_const(f, cell->getParam("\\T_LIMIT_MAX"));
+		dump_const(f, cell->parameters.at(VID::T_LIMIT_MAX));
 
 		if (spec_type == "$setuphold" || spec_type == "$recrem" || spec_type == "$fullskew") {
 			f << ", ";
-			dump_const(f, cell->getParam("\\T_LIMIT2_MIN"));
+			dump_const(f, cell->parameters.at(VID::T_LIMIT2_MIN));
 			f << ": ";
-			dump_const(f, cell->getParam("\\T_LIMIT2_TYP"));
+			dump_const(f, cell->parameters.at(VID::T_LIMIT2_TYP));
 			f << ": ";
-			dump_const(f, cell->getParam("\\T_LIMIT2_MAX"));
+			dump_const(f, cell->parameters.at(VID::T_LIMIT2_MAX));
 		}
 
 		f << ");\n";
 		decimal = bak_decimal;
 
-		f << stringf("%s" "endspecify\n", indent.c_str());
+		f << indent << "endspecify\n";
 		return true;
 	}
 
@@ -1445,7 +1559,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	return false;
 }
 
-void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+void dump_cell(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
 	if (cell->type[0] == '$' && !noexpr) {
 		if (dump_cell_expr(f, indent, cell))
@@ -1453,28 +1567,31 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	}
 
 	dump_attributes(f, indent, cell->attributes);
-	f << stringf("%s" "%s", indent.c_str(), id(cell->type, false).c_str());
+	f << indent;
+	dump_id(f, cell->type, false);
 
 	if (!defparam && cell->parameters.size() > 0) {
-		f << stringf(" #(");
+		f << " #(";
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
 			if (it != cell->parameters.begin())
-				f << stringf(",");
-			f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
+				f << ",";
+			f << '\n' << indent << "  .";
+			dump_id(f, it->first);
+			f << '(';
 			dump_const(f, it->second);
-			f << stringf(")");
+			f << ")";
 		}
 		f << stringf("\n%s" ")", indent.c_str());
 	}
 
-	std::string cell_name = cellname(cell);
-	if (cell_name != id(cell->name))
-		f << stringf(" %s /* %s */ (", cell_name.c_str(), id(cell->name).c_str());
+	std::string cell_name = cellname(cell), cell_id = id(cell->name);
+	if (cell_name != cell_id)
+		f << ' ' << cell_name << " /* " << cell_id << " */ (";
 	else
-		f << stringf(" %s (", cell_name.c_str());
+		f << ' ' << cell_name << " (";
 
 	bool first_arg = true;
-	std::set<RTLIL::IdString> numbered_ports;
+	pool<const RTLIL::IdString*, hash_ptr_ops> numbered_ports;
 	for (int i = 1; true; i++) {
 		char str[16];
 		snprintf(str, 16, "$%d", i);
@@ -1482,40 +1599,42 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			if (it->first != str)
 				continue;
 			if (!first_arg)
-				f << stringf(",");
+				f << ",";
 			first_arg = false;
-			f << stringf("\n%s  ", indent.c_str());
+			f << '\n' << indent << "  ";
 			dump_sigspec(f, it->second);
-			numbered_ports.insert(it->first);
+			numbered_ports.insert(&it->first);
 			goto found_numbered_port;
 		}
 		break;
 	found_numbered_port:;
 	}
 	for (auto it = cell->connections().begin(); it != cell->connections().end(); ++it) {
-		if (numbered_ports.count(it->first))
+		if (numbered_ports.count(&it->first))
 			continue;
 		if (!first_arg)
-			f << stringf(",");
+			f << ",";
 		first_arg = false;
-		f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
+		f << '\n' << indent << "  .";
+		dump_id(f, it->first);
+		f << '(';
 		if (it->second.size() > 0)
 			dump_sigspec(f, it->second);
-		f << stringf(")");
+		f << ")";
 	}
-	f << stringf("\n%s" ");\n", indent.c_str());
+	f << '\n' << indent << ");\n";
 
 	if (defparam && cell->parameters.size() > 0) {
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
 			f << stringf("%sdefparam %s.%s = ", indent.c_str(), cell_name.c_str(), id(it->first).c_str());
 			dump_const(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 	}
 
-	if (siminit && reg_ct.count(cell->type) && cell->hasPort("\\Q")) {
+	if (siminit && reg_ct.count(cell->type) && cell->connections_.count(VID::Q)) {
 		std::stringstream ss;
-		dump_reg_init(ss, cell->getPort("\\Q"));
+		dump_reg_init(ss, cell->connections_.at(VID::Q));
 		if (!ss.str().empty()) {
 			f << stringf("%sinitial %s.Q", indent.c_str(), cell_name.c_str());
 			f << ss.str();
@@ -1524,32 +1643,32 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	}
 }
 
-void dump_conn(std::ostream &f, std::string indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
+void dump_conn(std::ostream &f, const std::string &indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
 {
-	f << stringf("%s" "assign ", indent.c_str());
+	f << indent << "assign ";
 	dump_sigspec(f, left);
-	f << stringf(" = ");
+	f << " = ";
 	dump_sigspec(f, right);
-	f << stringf(";\n");
+	f << ";\n";
 }
 
-void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw);
+void dump_proc_switch(std::ostream &f, const std::string &indent, RTLIL::SwitchRule *sw);
 
-void dump_case_body(std::ostream &f, std::string indent, RTLIL::CaseRule *cs, bool omit_trailing_begin = false)
+void dump_case_body(std::ostream &f, const std::string &indent, RTLIL::CaseRule *cs, bool omit_trailing_begin = false)
 {
 	int number_of_stmts = cs->switches.size() + cs->actions.size();
 
 	if (!omit_trailing_begin && number_of_stmts >= 2)
-		f << stringf("%s" "begin\n", indent.c_str());
+		f << indent << "begin\n";
 
 	for (auto it = cs->actions.begin(); it != cs->actions.end(); ++it) {
 		if (it->first.size() == 0)
 			continue;
 		f << stringf("%s  ", indent.c_str());
 		dump_sigspec(f, it->first);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, it->second);
-		f << stringf(";\n");
+		f << ";\n";
 	}
 
 	for (auto it = cs->switches.begin(); it != cs->switches.end(); ++it)
@@ -1559,25 +1678,25 @@ void dump_case_body(std::ostream &f, std::string indent, RTLIL::CaseRule *cs, bo
 		f << stringf("%s  /* empty */;\n", indent.c_str());
 
 	if (omit_trailing_begin || number_of_stmts >= 2)
-		f << stringf("%s" "end\n", indent.c_str());
+		f << indent << "end\n";
 }
 
-void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw)
+void dump_proc_switch(std::ostream &f, const std::string &indent, RTLIL::SwitchRule *sw)
 {
 	if (sw->signal.size() == 0) {
-		f << stringf("%s" "begin\n", indent.c_str());
+		f << indent << "begin\n";
 		for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
 			if ((*it)->compare.size() == 0)
 				dump_case_body(f, indent + "  ", *it);
 		}
-		f << stringf("%s" "end\n", indent.c_str());
+		f << indent << "end\n";
 		return;
 	}
 
 	dump_attributes(f, indent, sw->attributes);
-	f << stringf("%s" "casez (", indent.c_str());
+	f << indent << "casez (";
 	dump_sigspec(f, sw->signal);
-	f << stringf(")\n");
+	f << ")\n";
 
 	bool got_default = false;
 	for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
@@ -1591,15 +1710,15 @@ void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw
 			f << stringf("%s  ", indent.c_str());
 			for (size_t i = 0; i < (*it)->compare.size(); i++) {
 				if (i > 0)
-					f << stringf(", ");
+					f << ", ";
 				dump_sigspec(f, (*it)->compare[i]);
 			}
 		}
-		f << stringf(":\n");
+		f << ":\n";
 		dump_case_body(f, indent + "    ", *it);
 	}
 
-	f << stringf("%s" "endcase\n", indent.c_str());
+	f << indent << "endcase\n";
 }
 
 void case_body_find_regs(RTLIL::CaseRule *cs)
@@ -1611,7 +1730,7 @@ void case_body_find_regs(RTLIL::CaseRule *cs)
 	for (auto it = cs->actions.begin(); it != cs->actions.end(); ++it) {
 		for (auto &c : it->first.chunks())
 			if (c.wire != NULL)
-				reg_wires.insert(c.wire->name);
+				reg_wires.insert(c.wire);
 	}
 }
 
@@ -1623,12 +1742,12 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		for (auto it2 = (*it)->actions.begin(); it2 != (*it)->actions.end(); it2++) {
 			for (auto &c : it2->first.chunks())
 				if (c.wire != NULL)
-					reg_wires.insert(c.wire->name);
+					reg_wires.insert(c.wire);
 		}
 		return;
 	}
 
-	f << stringf("%s" "always @* begin\n", indent.c_str());
+	f << indent << "always @* begin\n";
 	dump_case_body(f, indent, &proc->root_case, true);
 
 	std::string backup_indent = indent;
@@ -1639,17 +1758,17 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		indent = backup_indent;
 
 		if (sync->type == RTLIL::STa) {
-			f << stringf("%s" "always @* begin\n", indent.c_str());
+			f << indent << "always @* begin\n";
 		} else if (sync->type == RTLIL::STi) {
-			f << stringf("%s" "initial begin\n", indent.c_str());
+			f << indent << "initial begin\n";
 		} else {
-			f << stringf("%s" "always @(", indent.c_str());
+			f << indent << "always @(";
 			if (sync->type == RTLIL::STp || sync->type == RTLIL::ST1)
-				f << stringf("posedge ");
+				f << "posedge ";
 			if (sync->type == RTLIL::STn || sync->type == RTLIL::ST0)
-				f << stringf("negedge ");
+				f << "negedge ";
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 		}
 		std::string ends = indent + "end\n";
 		indent += "  ";
@@ -1657,7 +1776,7 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		if (sync->type == RTLIL::ST0 || sync->type == RTLIL::ST1) {
 			f << stringf("%s" "if (%s", indent.c_str(), sync->type == RTLIL::ST0 ? "!" : "");
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 			ends = indent + "end\n" + ends;
 			indent += "  ";
 		}
@@ -1668,7 +1787,7 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 				if (sync2->type == RTLIL::ST0 || sync2->type == RTLIL::ST1) {
 					f << stringf("%s" "if (%s", indent.c_str(), sync2->type == RTLIL::ST1 ? "!" : "");
 					dump_sigspec(f, sync2->signal);
-					f << stringf(") begin\n");
+					f << ") begin\n";
 					ends = indent + "end\n" + ends;
 					indent += "  ";
 				}
@@ -1680,16 +1799,16 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 				continue;
 			f << stringf("%s  ", indent.c_str());
 			dump_sigspec(f, it->first);
-			f << stringf(" <= ");
+			f << " <= ";
 			dump_sigspec(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 
 		f << stringf("%s", ends.c_str());
 	}
 }
 
-void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
+void dump_module(std::ostream &f, const std::string &indent, RTLIL::Module *module)
 {
 	reg_wires.clear();
 	reset_auto_counter(module);
@@ -1698,21 +1817,15 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 	active_initdata.clear();
 
 	for (auto wire : module->wires())
-		if (wire->attributes.count("\\init")) {
+		if (wire->attributes.count(VID::init)) {
 			SigSpec sig = active_sigmap(wire);
-			Const val = wire->attributes.at("\\init");
+			Const val = wire->attributes.at(VID::init);
 			for (int i = 0; i < GetSize(sig) && i < GetSize(val); i++)
 				if (val[i] == State::S0 || val[i] == State::S1)
 					active_initdata[sig[i]] = val[i];
 		}
 
-	if (!module->processes.empty())
-		log_warning("Module %s contains unmapped RTLIL processes. RTLIL processes\n"
-				"can't always be mapped directly to Verilog always blocks. Unintended\n"
-				"changes in simulation behavior are possible! Use \"proc\" to convert\n"
-				"processes to logic networks and registers.\n", log_id(module));
-
-	f << stringf("\n");
+	f << "\n";
 	for (auto it = module->processes.begin(); it != module->processes.end(); ++it)
 		dump_process(f, indent + "  ", it->second, true);
 
@@ -1722,10 +1835,10 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 		for (auto &it : module->cells_)
 		{
 			RTLIL::Cell *cell = it.second;
-			if (!reg_ct.count(cell->type) || !cell->hasPort("\\Q"))
+			if (!reg_ct.count(cell->type) || !cell->connections_.count(VID::Q))
 				continue;
 
-			RTLIL::SigSpec sig = cell->getPort("\\Q");
+			RTLIL::SigSpec sig = cell->connections_.at(VID::Q);
 
 			if (sig.is_chunk()) {
 				RTLIL::SigChunk chunk = sig.as_chunk();
@@ -1741,28 +1854,29 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 				if (reg_bits.count(std::pair<RTLIL::Wire*,int>(wire, i)) == 0)
 					goto this_wire_aint_reg;
 			if (wire->width)
-				reg_wires.insert(wire->name);
+				reg_wires.insert(wire);
 		this_wire_aint_reg:;
 		}
 	}
 
 	dump_attributes(f, indent, module->attributes, '\n', /*modattr=*/true);
-	f << stringf("%s" "module %s(", indent.c_str(), id(module->name, false).c_str());
-	bool keep_running = true;
-	for (int port_id = 1; keep_running; port_id++) {
-		keep_running = false;
-		for (auto it = module->wires_.begin(); it != module->wires_.end(); ++it) {
-			RTLIL::Wire *wire = it->second;
-			if (wire->port_id == port_id) {
-				if (port_id != 1)
-					f << stringf(", ");
-				f << stringf("%s", id(wire->name).c_str());
-				keep_running = true;
-				continue;
-			}
-		}
+	f << indent << "module ";
+	dump_id(f, module->name, false);
+	f << '(';
+	std::vector<RTLIL::Wire*> port_wires;
+	for (auto it = module->wires_.begin(); it != module->wires_.end(); ++it) {
+		RTLIL::Wire *wire = it->second;
+		if (wire->port_id > GetSize(port_wires))
+			port_wires.resize(wire->port_id);
+		if (wire->port_id > 0)
+			port_wires[wire->port_id-1] = wire;
+	}
+	for (int i = 0; i < GetSize(port_wires) && port_wires[i] != nullptr; i++) {
+		if (i != 0)
+			f << ", ";
+		dump_id(f, port_wires[i]->name);
 	}
-	f << stringf(");\n");
+	f << ");\n";
 
 	for (auto it = module->wires_.begin(); it != module->wires_.end(); ++it)
 		dump_wire(f, indent + "  ", it->second);
@@ -1779,10 +1893,54 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 	for (auto it = module->connections().begin(); it != module->connections().end(); ++it)
 		dump_conn(f, indent + "  ", it->first, it->second);
 
-	f << stringf("%s" "endmodule\n", indent.c_str());
+	f << indent << "endmodule\n";
 	active_module = NULL;
 	active_sigmap.clear();
 	active_initdata.clear();
+	auto_name_map.clear();
+	auto_name_ids.clear();
+	auto_names.clear();
+	reg_wires.clear();
+}
+
+void log_dump_module(RTLIL::Module *module)
+{
+	log("Dumping module `%s'.\n", module->name.c_str());
+	if (!module->processes.empty())
+		log_warning("Module %s contains unmapped RTLIL processes. RTLIL processes\n"
+				"can't always be mapped directly to Verilog always blocks. Unintended\n"
+				"changes in simulation behavior are possible! Use \"proc\" to convert\n"
+				"processes to logic networks and registers.\n", log_id(module));
+}
+
+// Creates the names that dump_module() looks up in mem_ids and reg_cell_names.
+void prepare_module(RTLIL::Module *module)
+{
+	for (auto cell : module->cells()) {
+		if (cell->type == VID::$mem)
+			mem_ids[cell] = cell->parameters.at(VID::MEMID).decode_string();
+		std::string name = reg_cell_name(module, cell);
+		if (!name.empty())
+			reg_cell_names[cell] = name;
+	}
+}
+
+// Lookups in hashlib containers may rehash them, so all containers that are
+// looked up while dumping a module must be settled before using threads.
+void settle_module(RTLIL::Module *module)
+{
+	settle_for_concurrent_reads(module->attributes);
+	settle_for_concurrent_reads(module->wires_);
+	settle_for_concurrent_reads(module->cells_);
+	settle_for_concurrent_reads(module->memories);
+	settle_for_concurrent_reads(module->processes);
+	for (auto wire : module->wires())
+		settle_for_concurrent_reads(wire->attributes);
+	for (auto cell : module->cells()) {
+		settle_for_concurrent_reads(cell->attributes);
+		settle_for_concurrent_reads(cell->parameters);
+		settle_for_concurrent_reads(cell->connections_);
+	}
 }
 
 struct VerilogBackend : public Backend {
@@ -1860,6 +2018,11 @@ struct VerilogBackend : public Backend {
 		log("    -v\n");
 		log("        verbose output (print new names of all renamed wires and cells)\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        generate the Verilog code for N modules at once on separate threads.\n");
+		log("        N may be zero to use all available cores. (default = 1)\n");
+		log("        -v and -extmem always use a single thread.\n");
+		log("\n");
 		log("Note that RTLIL processes can't always be mapped directly to Verilog\n");
 		log("always blocks. This frontend should only be used to export an RTLIL\n");
 		log("netlist, i.e. after the \"proc\" pass has been used to convert all\n");
@@ -1887,36 +2050,39 @@ struct VerilogBackend : public Backend {
 
 		bool blackboxes = false;
 		bool selected = false;
+		int num_threads = 1;
+
+		setup_verilog_ids();
 
 		auto_name_map.clear();
 		reg_wires.clear();
 		reg_ct.clear();
 
-		reg_ct.insert("$dff");
-		reg_ct.insert("$adff");
-		reg_ct.insert("$dffe");
-		reg_ct.insert("$dlatch");
-
-		reg_ct.insert("$_DFF_N_");
-		reg_ct.insert("$_DFF_P_");
-
-		reg_ct.insert("$_DFF_NN0_");
-		reg_ct.insert("$_DFF_NN1_");
-		reg_ct.insert("$_DFF_NP0_");
-		reg_ct.insert("$_DFF_NP1_");
-		reg_ct.insert("$_DFF_PN0_");
-		reg_ct.insert("$_DFF_PN1_");
-		reg_ct.insert("$_DFF_PP0_");
-		reg_ct.insert("$_DFF_PP1_");
-
-		reg_ct.insert("$_DFFSR_NNN_");
-		reg_ct.insert("$_DFFSR_NNP_");
-		reg_ct.insert("$_DFFSR_NPN_");
-		reg_ct.insert("$_DFFSR_NPP_");
-		reg_ct.insert("$_DFFSR_PNN_");
-		reg_ct.insert("$_DFFSR_PNP_");
-		reg_ct.insert("$_DFFSR_PPN_");
-		reg_ct.insert("$_DFFSR_PPP_");
+		reg_ct.insert(VID::$dff);
+		reg_ct.insert(VID::$adff);
+		reg_ct.insert(VID::$dffe);
+		reg_ct.insert(VID::$dlatch);
+
+		reg_ct.insert(VID::$_DFF_N_);
+		reg_ct.insert(VID::$_DFF_P_);
+
+		reg_ct.insert(VID::$_DFF_NN0_);
+		reg_ct.insert(VID::$_DFF_NN1_);
+		reg_ct.insert(VID::$_DFF_NP0_);
+		reg_ct.insert(VID::$_DFF_NP1_);
+		reg_ct.insert(VID::$_DFF_PN0_);
+		reg_ct.insert(VID::$_DFF_PN1_);
+		reg_ct.insert(VID::$_DFF_PP0_);
+		reg_ct.insert(VID::$_DFF_PP1_);
+
+		reg_ct.insert(VID::$_DFFSR_NNN_);
+		reg_ct.insert(VID::$_DFFSR_NNP_);
+		reg_ct.insert(VID::$_DFFSR_NPN_);
+		reg_ct.insert(VID::$_DFFSR_NPP_);
+		reg_ct.insert(VID::$_DFFSR_PNN_);
+		reg_ct.insert(VID::$_DFFSR_PNP_);
+		reg_ct.insert(VID::$_DFFSR_PPN_);
+		reg_ct.insert(VID::$_DFFSR_PPP_);
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -1982,6 +2148,10 @@ struct VerilogBackend : public Backend {
 				verbose = true;
 				continue;
 			}
+			if (arg == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -1994,7 +2164,7 @@ struct VerilogBackend : public Backend {
 
 		design->sort();
 
-		*f << stringf("/* Generated by %s */\n", yosys_version_str);
+		std::vector<RTLIL::Module*> modules;
 		for (auto it = design->modules_.begin(); it != design->modules_.end(); ++it) {
 			if (it->second->get_blackbox_attribute() != blackboxes)
 				continue;
@@ -2003,13 +2173,61 @@ struct VerilogBackend : public Backend {
 					log_cmd_error("Can't handle partially selected module %s!\n", RTLIL::id2cstr(it->first));
 				continue;
 			}
-			log("Dumping module `%s'.\n", it->first.c_str());
-			dump_module(*f, "", it->second);
+			modules.push_back(it->second);
+		}
+
+		if (verbose || extmem)
+			num_threads = 1;
+
+		*f << stringf("/* Generated by %s */\n", yosys_version_str);
+		for (auto module : modules)
+			prepare_module(module);
+
+		if (num_threads > 1 && GetSize(modules) > 1)
+		{
+			for (auto module : modules) {
+				log_dump_module(module);
+				settle_module(module);
+			}
+			settle_for_concurrent_reads(mem_ids);
+			settle_for_concurrent_reads(reg_cell_names);
+
+			// Every module is dumped into its own buffer. The modules are
+			// handled in batches of a few modules per thread, and the buffers
+			// of a batch are written in the original order before the next
+			// batch starts.
+			int batch_size = 4 * num_threads;
+			std::vector<std::string> buffers;
+			for (int begin = 0; begin < GetSize(modules); begin += batch_size)
+			{
+				int count = std::min(batch_size, GetSize(modules) - begin);
+				buffers.clear();
+				buffers.resize(count);
+				parallel_for(num_threads, count, [&](int i) {
+					std::ostringstream buf;
+					dump_module(buf, "", modules[begin + i]);
+					buffers[i] = buf.str();
+				});
+
+				for (auto &buf : buffers) {
+					*f << buf;
+					std::string().swap(buf);
+				}
+			}
+		}
+		else
+		{
+			for (auto module : modules) {
+				log_dump_module(module);
+				dump_module(*f, "", module);
+			}
 		}
 
 		auto_name_map.clear();
 		reg_wires.clear();
 		reg_ct.clear();
+		mem_ids.clear();
+		reg_cell_names.clear();
 	}
 } VerilogBackend;
 
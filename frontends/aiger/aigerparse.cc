@@ -784,8 +784,14 @@ void AigerReader::post_process()
 
 	dict<RTLIL::IdString, int> wideports_cache;
 
-	if (!map_filename.empty()) {
-		std::ifstream mf(map_filename);
+	if (!map_filename.empty() || !map_scratchpad.empty()) {
+		std::ifstream mff;
+		std::istringstream mfs;
+		if (!map_filename.empty())
+			mff.open(map_filename);
+		else
+			mfs.str(design->scratchpad_get_string(map_scratchpad));
+		std::istream &mf = map_filename.empty() ? static_cast<std::istream&>(mfs) : mff;
 		std::string type, symbol;
 		int variable, index;
 		while (mf >> type >> variable >> index >> symbol) {
@@ -958,6 +964,10 @@ struct AigerFrontend : public Frontend {
 		log("    -map <filename>\n");
 		log("        read file with port and latch symbols\n");
 		log("\n");
+		log("    -map_scratchpad <varname>\n");
+		log("        read port and latch symbols from the given scratchpad variable of the\n");
+		log("        design (see 'write_xaiger -map_scratchpad')\n");
+		log("\n");
 		log("    -wideports\n");
 		log("        merge ports that match the pattern 'name[int]' into a single\n");
 		log("        multi-bit port 'name'\n");
@@ -972,7 +982,7 @@ struct AigerFrontend : public Frontend {
 
 		RTLIL::IdString clk_name;
 		RTLIL::IdString module_name;
-		std::string map_filename;
+		std::string map_filename, map_scratchpad;
 		bool wideports = false, xaiger = false;
 
 		size_t argidx;
@@ -990,6 +1000,10 @@ struct AigerFrontend : public Frontend {
 				map_filename = args[++argidx];
 				continue;
 			}
+			if (map_scratchpad.empty() && arg == "-map_scratchpad" && argidx+1 < args.size()) {
+				map_scratchpad = args[++argidx];
+				continue;
+			}
 			if (arg == "-wideports") {
 				wideports = true;
 				continue;
@@ -1017,6 +1031,7 @@ struct AigerFrontend : public Frontend {
 		}
 
 		AigerReader reader(design, *f, module_name, clk_name, map_filename, wideports);
+		reader.map_scratchpad = map_scratchpad;
 		if (xaiger)
 			reader.parse_xaiger();
 		else
@@ -32,6 +32,7 @@ struct AigerReader
     RTLIL::IdString clk_name;
     RTLIL::Module *module;
     std::string map_filename;
+    std::string map_scratchpad;
     bool wideports;
     const int aiger_autoidx;
 
@@ -33,6 +33,114 @@ void rtlil_frontend_ilang_yyerror(char const *s)
 
 YOSYS_NAMESPACE_BEGIN
 
+// Finds the module boundaries in an ilang file without parsing it, so that
+// 'read_ilang -module' only needs to run the parser on the modules it loads.
+struct IlangModuleIndex
+{
+	struct ModuleText {
+		size_t begin, end;
+		std::vector<std::string> cell_types;
+	};
+
+	std::string text, header;
+	dict<std::string, ModuleText> modules;
+	std::vector<std::string> module_order;
+
+	// Returns the first two whitespace separated tokens of a line
+	static void line_tokens(const char *p, const char *line_end, std::string &tok1, std::string &tok2)
+	{
+		auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+		tok1.clear(), tok2.clear();
+		while (p < line_end && is_space(*p)) p++;
+		while (p < line_end && !is_space(*p)) tok1 += *p++;
+		while (p < line_end && is_space(*p)) p++;
+		while (p < line_end && !is_space(*p)) tok2 += *p++;
+	}
+
+	// Blocks that are closed with 'end' are modules, cells, processes and
+	// switches. Module attributes are on the lines right before the module.
+	void build(std::istream &f)
+	{
+		text.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+		std::string tok1, tok2, module_name;
+		ModuleText *module = nullptr;
+		size_t attr_begin = std::string::npos;
+		int depth = 0;
+
+		for (size_t pos = 0; pos < text.size();)
+		{
+			size_t line_end = text.find('\n', pos);
+			line_end = line_end == std::string::npos ? text.size() : line_end + 1;
+			line_tokens(text.data() + pos, text.data() + line_end, tok1, tok2);
+
+			if (depth == 0)
+			{
+				if (tok1 == "attribute") {
+					if (attr_begin == std::string::npos)
+						attr_begin = pos;
+				} else if (tok1 == "module") {
+					if (modules.count(tok2))
+						log_error("Module %s is defined twice in the input file.\n", tok2.c_str());
+					module_name = tok2;
+					module_order.push_back(module_name);
+					module = &modules[module_name];
+					module->begin = attr_begin != std::string::npos ? attr_begin : pos;
+					attr_begin = std::string::npos;
+					depth = 1;
+				} else if (tok1 == "autoidx") {
+					header.append(text, pos, line_end - pos);
+				}
+			}
+			else if (tok1 == "module" || tok1 == "cell" || tok1 == "process" || tok1 == "switch")
+			{
+				if (tok1 == "cell")
+					module->cell_types.push_back(tok2);
+				depth++;
+			}
+			else if (tok1 == "end")
+			{
+				if (--depth == 0)
+					module->end = line_end;
+			}
+
+			pos = line_end;
+		}
+
+		if (depth != 0)
+			log_error("Module %s is not terminated with 'end'.\n", module_name.c_str());
+	}
+
+	// Returns the text of the given modules and all modules instantiated by
+	// them, in the order of the input file.
+	std::string extract(const std::vector<std::string> &names, int &count)
+	{
+		pool<std::string> loaded;
+		std::vector<std::string> queue = names;
+
+		while (!queue.empty()) {
+			std::string name = queue.back();
+			queue.pop_back();
+			if (loaded.count(name))
+				continue;
+			loaded.insert(name);
+			for (auto &type : modules.at(name).cell_types)
+				if (modules.count(type) && !loaded.count(type))
+					queue.push_back(type);
+		}
+
+		std::string result = header;
+		count = 0;
+		for (auto &name : module_order)
+			if (loaded.count(name)) {
+				const ModuleText &module = modules.at(name);
+				result.append(text, module.begin, module.end - module.begin);
+				count++;
+			}
+		return result;
+	}
+};
+
 struct IlangFrontend : public Frontend {
 	IlangFrontend() : Frontend("ilang", "read modules from ilang file") { }
 	void help() YS_OVERRIDE
@@ -55,12 +163,19 @@ struct IlangFrontend : public Frontend {
 		log("    -lib\n");
 		log("        only create empty blackbox modules\n");
 		log("\n");
+		log("    -module <name>\n");
+		log("        only load the specified module and the modules instantiated in it,\n");
+		log("        directly or indirectly. the file is scanned for module boundaries\n");
+		log("        first, so that all other modules are skipped without parsing them.\n");
+		log("        this option can be used multiple times.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		ILANG_FRONTEND::flag_nooverwrite = false;
 		ILANG_FRONTEND::flag_overwrite = false;
 		ILANG_FRONTEND::flag_lib = false;
+		std::vector<std::string> module_names;
 
 		log_header(design, "Executing ILANG frontend.\n");
 
@@ -81,13 +196,32 @@ struct IlangFrontend : public Frontend {
 				ILANG_FRONTEND::flag_lib = true;
 				continue;
 			}
+			if (arg == "-module" && argidx+1 < args.size()) {
+				module_names.push_back(RTLIL::escape_id(args[++argidx]));
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
 		log("Input filename: %s\n", filename.c_str());
 
-		ILANG_FRONTEND::lexin = f;
+		std::istringstream module_text;
+		if (!module_names.empty())
+		{
+			IlangModuleIndex index;
+			index.build(*f);
+
+			for (auto &name : module_names)
+				if (!index.modules.count(name))
+					log_cmd_error("Module %s not found in %s.\n", name.c_str(), filename.c_str());
+
+			int count;
+			module_text.str(index.extract(module_names, count));
+			log("Loading %d of %d modules.\n", count, GetSize(index.modules));
+		}
+
+		ILANG_FRONTEND::lexin = module_names.empty() ? f : &module_text;
 		ILANG_FRONTEND::current_design = design;
 		rtlil_frontend_ilang_yydebug = false;
 		rtlil_frontend_ilang_yyrestart(NULL);
@@ -0,0 +1,386 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  The frontend for the binary RTLIL format (as generated by the
+ *  'rtlil_bin' backend).
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "backends/rtlil_bin/rtlil_bin.h"
+
+YOSYS_NAMESPACE_BEGIN
+using namespace RTLIL_BIN;
+
+struct RtlilBinReader
+{
+	std::istream *f;
+	RTLIL::Design *design;
+	bool flag_nooverwrite, flag_overwrite, flag_lib;
+
+	std::vector<std::string> strings;
+	std::vector<RTLIL::IdString> ids;
+
+	RTLIL::Module *module;
+	std::vector<RTLIL::Wire*> wires;
+	Decoder *dec;
+
+	RtlilBinReader(std::istream *f, RTLIL::Design *design) : f(f), design(design),
+			flag_nooverwrite(false), flag_overwrite(false), flag_lib(false), module(nullptr), dec(nullptr) { }
+
+	uint64_t read_u()
+	{
+		uint64_t v = 0;
+		for (int shift = 0;; shift += 7) {
+			int byte = f->get();
+			if (byte == EOF)
+				log_error("Unexpected end of binary RTLIL file.\n");
+			if (shift < 64)
+				v |= uint64_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return v;
+		}
+	}
+
+	std::string read_bytes(size_t n)
+	{
+		std::string str(n, 0);
+		f->read(&str[0], n);
+		if (size_t(f->gcount()) != n)
+			log_error("Unexpected end of binary RTLIL file.\n");
+		return str;
+	}
+
+	// IdStrings are only created for the strings that are actually used.
+	RTLIL::IdString id()
+	{
+		uint64_t idx = dec->u();
+		if (idx >= strings.size())
+			log_error("Invalid string index in binary RTLIL data.\n");
+		if (ids[idx].empty())
+			ids[idx] = strings[idx];
+		return ids[idx];
+	}
+
+	RTLIL::Const read_const()
+	{
+		RTLIL::Const data;
+		data.flags = dec->i();
+		dec->const_bits(data.bits);
+		return data;
+	}
+
+	void read_attributes(dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::IdString name = id();
+			attributes[name] = read_const();
+		}
+	}
+
+	RTLIL::SigSpec read_sigspec()
+	{
+		RTLIL::SigSpec sig;
+		for (int n = dec->i(); n > 0; n--)
+		{
+			uint64_t code = dec->u();
+			if (code == 0) {
+				RTLIL::Const data;
+				dec->const_bits(data.bits);
+				sig.append(data);
+				continue;
+			}
+
+			uint64_t idx = (code >> 1) - 1;
+			if (idx >= wires.size())
+				log_error("Invalid wire index in binary RTLIL data.\n");
+			RTLIL::Wire *wire = wires[idx];
+
+			if ((code & 1) == 0) {
+				sig.append(wire);
+			} else {
+				int offset = dec->i();
+				int width = dec->i();
+				if (offset < 0 || width < 0 || offset + width > wire->width)
+					log_error("Invalid slice of wire %s in binary RTLIL data.\n", log_id(wire));
+				sig.append(RTLIL::SigSpec(wire, offset, width));
+			}
+		}
+		return sig;
+	}
+
+	void read_sigsigs(std::vector<RTLIL::SigSig> &sigsigs)
+	{
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::SigSpec first = read_sigspec();
+			RTLIL::SigSpec second = read_sigspec();
+			sigsigs.push_back(RTLIL::SigSig(first, second));
+		}
+	}
+
+	void read_case(RTLIL::CaseRule *cs)
+	{
+		read_attributes(cs->attributes);
+		for (int n = dec->i(); n > 0; n--)
+			cs->compare.push_back(read_sigspec());
+		read_sigsigs(cs->actions);
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			read_attributes(sw->attributes);
+			sw->signal = read_sigspec();
+			for (int k = dec->i(); k > 0; k--) {
+				RTLIL::CaseRule *child = new RTLIL::CaseRule;
+				sw->cases.push_back(child);
+				read_case(child);
+			}
+		}
+	}
+
+	void read_module(RTLIL::IdString name, const std::string &data)
+	{
+		Decoder section_dec(data);
+		dec = &section_dec;
+		wires.clear();
+
+		module = new RTLIL::Module;
+		module->name = name;
+		read_attributes(module->attributes);
+
+		bool delete_module = false;
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!flag_overwrite && (flag_lib || module->get_bool_attribute("\\blackbox"))) {
+				log("Ignoring blackbox re-definition of module %s.\n", log_id(name));
+				delete_module = true;
+			} else if (!flag_nooverwrite && !flag_overwrite && !existing_mod->get_bool_attribute("\\blackbox")) {
+				log_error("Redefinition of module %s.\n", log_id(name));
+			} else if (flag_nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", log_id(name));
+				delete_module = true;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute("\\blackbox") ? " blackbox" : "", log_id(name));
+				design->remove(existing_mod);
+			}
+		}
+
+		if (delete_module) {
+			delete module;
+			module = nullptr;
+			return;
+		}
+		design->add(module);
+
+		for (int n = dec->i(); n > 0; n--)
+			module->avail_parameters.insert(id());
+
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::IdString wire_name = id();
+			RTLIL::Wire *wire = module->addWire(wire_name, dec->i());
+			wire->start_offset = dec->s();
+			wire->port_id = dec->i();
+			int flags = dec->i();
+			wire->port_input = (flags & WIRE_INPUT) != 0;
+			wire->port_output = (flags & WIRE_OUTPUT) != 0;
+			wire->upto = (flags & WIRE_UPTO) != 0;
+			read_attributes(wire->attributes);
+			wires.push_back(wire);
+		}
+
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = id();
+			memory->width = dec->i();
+			memory->start_offset = dec->s();
+			memory->size = dec->i();
+			read_attributes(memory->attributes);
+			module->memories[memory->name] = memory;
+		}
+
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::IdString cell_name = id();
+			RTLIL::Cell *cell = module->addCell(cell_name, id());
+			for (int k = dec->i(); k > 0; k--) {
+				RTLIL::IdString param = id();
+				cell->setParam(param, read_const());
+			}
+			for (int k = dec->i(); k > 0; k--) {
+				RTLIL::IdString port = id();
+				cell->setPort(port, read_sigspec());
+			}
+			read_attributes(cell->attributes);
+		}
+
+		for (int n = dec->i(); n > 0; n--) {
+			RTLIL::Process *proc = new RTLIL::Process;
+			proc->name = id();
+			module->processes[proc->name] = proc;
+			read_attributes(proc->attributes);
+			read_case(&proc->root_case);
+			for (int k = dec->i(); k > 0; k--) {
+				RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+				proc->syncs.push_back(sync);
+				int type = dec->i();
+				if (type > RTLIL::STi)
+					log_error("Invalid sync rule type in binary RTLIL data.\n");
+				sync->type = RTLIL::SyncType(type);
+				sync->signal = read_sigspec();
+				read_sigsigs(sync->actions);
+			}
+		}
+
+		std::vector<RTLIL::SigSig> connections;
+		read_sigsigs(connections);
+		for (auto &it : connections)
+			module->connect(it);
+
+		if (dec->ptr != dec->end)
+			log_error("Trailing data in section of module %s.\n", log_id(name));
+
+		module->fixup_ports();
+		if (flag_lib)
+			module->makeblackbox();
+		module = nullptr;
+		dec = nullptr;
+	}
+
+	void read_design(const pool<RTLIL::IdString> &only_modules)
+	{
+		std::string file_magic = read_bytes(magic_size);
+		if (file_magic != std::string(magic, magic_size))
+			log_error("Input is not a binary RTLIL file.\n");
+
+		int version = read_u();
+		if (version != format_version)
+			log_error("Unsupported binary RTLIL format version %d (expected %d).\n", version, format_version);
+
+		autoidx = max(autoidx, int(read_u()));
+
+		strings.resize(read_u());
+		ids.resize(strings.size());
+		for (auto &str : strings)
+			str = read_bytes(read_u());
+
+		struct section_t {
+			uint64_t name, offset, size;
+		};
+		std::vector<section_t> sections(read_u());
+		for (auto &sec : sections) {
+			sec.name = read_u();
+			sec.offset = read_u();
+			sec.size = read_u();
+			if (sec.name >= strings.size())
+				log_error("Invalid string index in binary RTLIL module index.\n");
+		}
+
+		// Sections are stored in the order of the index. The sections of
+		// modules that were not asked for are skipped without decoding them.
+		uint64_t pos = 0;
+		pool<RTLIL::IdString> found_modules;
+		for (auto &sec : sections)
+		{
+			if (sec.offset != pos)
+				log_error("Invalid offset in binary RTLIL module index.\n");
+			pos += sec.size;
+
+			RTLIL::IdString name = strings[sec.name];
+			if (!only_modules.empty() && !only_modules.count(name)) {
+				f->ignore(sec.size);
+				continue;
+			}
+
+			read_module(name, read_bytes(sec.size));
+			found_modules.insert(name);
+		}
+
+		for (auto &name : only_modules)
+			if (!found_modules.count(name))
+				log_error("Module %s not found in binary RTLIL file.\n", log_id(name));
+
+		log("Read %d of %d modules.\n", GetSize(found_modules), GetSize(sections));
+	}
+};
+
+struct RtlilBinFrontend : public Frontend {
+	RtlilBinFrontend() : Frontend("rtlil_bin", "read modules from binary RTLIL file") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_rtlil_bin [options] [filename]\n");
+		log("\n");
+		log("Load modules from a binary RTLIL file (as written by 'write_rtlil_bin') to the\n");
+		log("current design.\n");
+		log("\n");
+		log("    -module <name>\n");
+		log("        only load the given module. the other modules in the file are skipped\n");
+		log("        without decoding them. this option can be used multiple times.\n");
+		log("\n");
+		log("    -nooverwrite\n");
+		log("        ignore re-definitions of modules. (the default behavior is to\n");
+		log("        create an error message if the existing module is not a blackbox\n");
+		log("        module, and overwrite the existing module if it is a blackbox module.)\n");
+		log("\n");
+		log("    -overwrite\n");
+		log("        overwrite existing modules with the same name\n");
+		log("\n");
+		log("    -lib\n");
+		log("        only create empty blackbox modules\n");
+		log("\n");
+	}
+	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
+	{
+		RtlilBinReader reader(f, design);
+		pool<RTLIL::IdString> only_modules;
+
+		log_header(design, "Executing RTLIL_BIN frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-module" && argidx+1 < args.size()) {
+				only_modules.insert(RTLIL::escape_id(args[++argidx]));
+				continue;
+			}
+			if (arg == "-nooverwrite") {
+				reader.flag_nooverwrite = true;
+				reader.flag_overwrite = false;
+				continue;
+			}
+			if (arg == "-overwrite") {
+				reader.flag_nooverwrite = false;
+				reader.flag_overwrite = true;
+				continue;
+			}
+			if (arg == "-lib") {
+				reader.flag_lib = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx, true);
+
+		log("Input filename: %s\n", filename.c_str());
+
+		reader.f = f;
+		reader.read_design(only_modules);
+	}
+} RtlilBinFrontend;
+
+YOSYS_NAMESPACE_END
@@ -264,6 +264,10 @@ int main(int argc, char **argv)
 		printf("    -m module_file\n");
 		printf("        load the specified module (aka plugin)\n");
 		printf("\n");
+		printf("    -z <threads>\n");
+		printf("        number of threads for reading and writing '.gz' files. the default\n");
+		printf("        is to use all hardware threads.\n");
+		printf("\n");
 		printf("    -X\n");
 		printf("        enable tracing of core data structure changes. for debugging\n");
 		printf("\n");
@@ -327,7 +331,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:D:P:E:x:")) != -1)
+	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:D:P:E:x:z:")) != -1)
 	{
 		switch (opt)
 		{
@@ -452,6 +456,9 @@ int main(int argc, char **argv)
 		case 'x':
 			log_experimentals_ignored.insert(optarg);
 			break;
+		case 'z':
+			yosys_gzip_threads = atoi(optarg);
+			break;
 		default:
 			fprintf(stderr, "Run '%s -h' for help.\n", argv[0]);
 			exit(1);
@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -28,23 +29,139 @@
 #ifdef YOSYS_ENABLE_ZLIB
 #include <zlib.h>
 
+#ifdef YOSYS_ENABLE_THREADS
+#include <condition_variable>
+#include <deque>
+#endif
+
+USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
-#define GZ_BUFFER_SIZE 8192
-void decompress_gzip(const std::string &filename, std::stringstream &out)
-{
-	char buffer[GZ_BUFFER_SIZE];
-	int bytes_read;
-	gzFile gzf = gzopen(filename.c_str(), "rb");
-	while(!gzeof(gzf)) {
-		bytes_read = gzread(gzf, reinterpret_cast<void *>(buffer), GZ_BUFFER_SIZE);
-		out.write(buffer, bytes_read);
-	}
-	gzclose(gzf);
+
+#define GZ_CHUNK_SIZE (256*1024)
+#define GZ_READ_AHEAD 4
+#define GZ_BLOCK_SIZE (128*1024)
+#define GZ_WINDOW_SIZE 32768
+
+// Threads used for gzip files: all hardware threads, unless set with the
+// '-z' command line option.
+static int gzip_thread_count()
+{
+	return yosys_thread_count(yosys_gzip_threads);
 }
 
 /*
-An output stream that uses a stringbuf to buffer data internally,
-using zlib to write gzip-compressed data every time the stream is flushed.
+An input stream that decompresses a gzip file while it is being read, so that
+the frontend can start parsing before the whole file is inflated. With thread
+support a reader thread inflates up to GZ_READ_AHEAD chunks ahead of the
+parser.
+*/
+class gzip_istream : public std::istream {
+public:
+	gzip_istream() : std::istream(nullptr)
+	{
+		rdbuf(&inbuf);
+	}
+	bool open(const std::string &filename)
+	{
+		return inbuf.open(filename);
+	}
+private:
+	class gzip_streambuf : public std::streambuf {
+	public:
+		gzip_streambuf() { };
+		bool open(const std::string &filename)
+		{
+			gzf = gzopen(filename.c_str(), "rb");
+			if (gzf == nullptr)
+				return false;
+			gzbuffer(gzf, GZ_CHUNK_SIZE);
+#ifdef YOSYS_ENABLE_THREADS
+			if (gzip_thread_count() > 1)
+				reader = std::thread([this]() { read_ahead(); });
+#endif
+			return true;
+		}
+		virtual int_type underflow() override
+		{
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+#ifdef YOSYS_ENABLE_THREADS
+			if (reader.joinable()) {
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [this]() { return !chunks.empty() || done; });
+				if (chunks.empty())
+					return traits_type::eof();
+				chunk.swap(chunks.front());
+				chunks.pop_front();
+				cond.notify_all();
+			} else
+#endif
+			if (!read_chunk(chunk))
+				return traits_type::eof();
+			setg(chunk.data(), chunk.data(), chunk.data() + chunk.size());
+			return traits_type::to_int_type(*gptr());
+		}
+		virtual ~gzip_streambuf()
+		{
+#ifdef YOSYS_ENABLE_THREADS
+			if (reader.joinable()) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stop = true;
+				}
+				cond.notify_all();
+				reader.join();
+			}
+#endif
+			if (gzf != nullptr)
+				gzclose(gzf);
+		}
+	private:
+		gzFile gzf = nullptr;
+		std::vector<char> chunk;
+
+		bool read_chunk(std::vector<char> &buffer)
+		{
+			buffer.resize(GZ_CHUNK_SIZE);
+			int n = gzread(gzf, buffer.data(), GZ_CHUNK_SIZE);
+			buffer.resize(std::max(n, 0));
+			return n > 0;
+		}
+
+#ifdef YOSYS_ENABLE_THREADS
+		std::thread reader;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<std::vector<char>> chunks;
+		bool done = false, stop = false;
+
+		void read_ahead()
+		{
+			std::vector<char> buffer;
+			while (read_chunk(buffer)) {
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [this]() { return GetSize(chunks) < GZ_READ_AHEAD || stop; });
+				if (stop)
+					break;
+				chunks.push_back(std::move(buffer));
+				buffer = std::vector<char>();
+				cond.notify_all();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			cond.notify_all();
+		}
+#endif
+	} inbuf;
+};
+
+/*
+An output stream that writes a gzip file in the style of pigz: the data is cut
+into blocks of GZ_BLOCK_SIZE bytes that are deflated independently on
+gzip_thread_count() threads, each primed with the last 32 kB of the preceding
+data as dictionary and ended on a byte boundary with a sync flush, so that the
+blocks concatenate to a single deflate stream. The block boundaries do not
+depend on the number of threads, so neither does the output.
 */
 class gzip_ostream : public std::ostream  {
 public:
@@ -57,27 +174,137 @@ public:
 		return outbuf.open(filename);
 	}
 private:
-	class gzip_streambuf : public std::stringbuf {
+	class gzip_streambuf : public std::streambuf {
 	public:
 		gzip_streambuf() { };
 		bool open(const std::string &filename)
 		{
-			gzf = gzopen(filename.c_str(), "wb");
-			return gzf != nullptr;
+			out.open(filename.c_str(), std::ofstream::trunc | std::ofstream::binary);
+			if (out.fail())
+				return false;
+			this->filename = filename;
+			static const char header[10] = { 0x1f, char(0x8b), 8, 0, 0, 0, 0, 0, 0, 3 };
+			out.write(header, sizeof(header));
+			num_threads = gzip_thread_count();
+			buffer.resize(size_t(2 * num_threads) * GZ_BLOCK_SIZE);
+			setp(buffer.data(), buffer.data() + buffer.size());
+			crc = crc32(0, Z_NULL, 0);
+			return true;
 		}
+		virtual int_type overflow(int_type c) override
+		{
+			compress_buffer(false);
+			if (!traits_type::eq_int_type(c, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+		// Flushing would end the current block early and make the output depend on
+		// when the backend flushes, so the data is only written when the buffer
+		// is full and when the stream is closed.
 		virtual int sync() override
 		{
-			gzwrite(gzf, reinterpret_cast<const void *>(str().c_str()), unsigned(str().size()));
-			str("");
 			return 0;
 		}
 		virtual ~gzip_streambuf()
 		{
-			sync();
-			gzclose(gzf);
+			if (!out.is_open())
+				return;
+			compress_buffer(true);
+			char trailer[8];
+			for (int i = 0; i < 4; i++) {
+				trailer[i] = char(crc >> (8*i));
+				trailer[4+i] = char(total_size >> (8*i));
+			}
+			out.write(trailer, sizeof(trailer));
+			out.close();
+			if (out.fail())
+				log_error("Failed to write gzip file `%s'.\n", filename.c_str());
 		}
 	private:
-		gzFile gzf = nullptr;
+		std::ofstream out;
+		std::string filename;
+		std::vector<char> buffer;
+		std::string window;
+		int num_threads = 1;
+		uLong crc = 0;
+		uint64_t total_size = 0;
+
+		void compress_buffer(bool finish)
+		{
+			const char *data = pbase();
+			size_t len = pptr() - pbase();
+			int num_blocks = (len + GZ_BLOCK_SIZE - 1) / GZ_BLOCK_SIZE;
+			if (finish && num_blocks == 0)
+				num_blocks = 1;
+
+			std::vector<std::string> blocks(num_blocks);
+			std::vector<uLong> block_crcs(num_blocks);
+			// log_error() must not be called on the worker threads, so the
+			// zlib errors are reported after all blocks are done
+			std::vector<int> block_errors(num_blocks, Z_OK);
+
+			parallel_for(num_threads, num_blocks, [&](int i) {
+				size_t begin = size_t(i) * GZ_BLOCK_SIZE;
+				size_t end = std::min(len, begin + GZ_BLOCK_SIZE);
+				const char *dict = i == 0 ? window.data() : data + begin - GZ_WINDOW_SIZE;
+				size_t dict_len = i == 0 ? window.size() : GZ_WINDOW_SIZE;
+
+				z_stream zs;
+				memset(&zs, 0, sizeof(zs));
+				int ret = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+				if (ret != Z_OK) {
+					block_errors[i] = ret;
+					return;
+				}
+				if (dict_len > 0)
+					ret = deflateSetDictionary(&zs, reinterpret_cast<const Bytef*>(dict), dict_len);
+
+				std::string &block = blocks[i];
+				block.resize(deflateBound(&zs, end - begin) + 16);
+				zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + begin));
+				zs.avail_in = end - begin;
+				int flush = finish && i == num_blocks-1 ? Z_FINISH : Z_SYNC_FLUSH;
+				size_t pos = 0;
+				while (ret == Z_OK) {
+					zs.next_out = reinterpret_cast<Bytef*>(&block[pos]);
+					zs.avail_out = block.size() - pos;
+					ret = deflate(&zs, flush);
+					pos = block.size() - zs.avail_out;
+					if (ret != Z_OK || zs.avail_out != 0)
+						break;
+					block.resize(2 * block.size());
+				}
+				// Z_BUF_ERROR only means that no progress was possible
+				block_errors[i] = ret == Z_STREAM_ERROR ? ret : Z_OK;
+				block.resize(pos);
+				deflateEnd(&zs);
+
+				block_crcs[i] = crc32(0, reinterpret_cast<const Bytef*>(data + begin), end - begin);
+			});
+
+			for (int i = 0; i < num_blocks; i++) {
+				if (block_errors[i] != Z_OK)
+					log_error("Failed to compress gzip file `%s': %s\n", filename.c_str(), zError(block_errors[i]));
+				size_t begin = size_t(i) * GZ_BLOCK_SIZE;
+				size_t end = std::min(len, begin + GZ_BLOCK_SIZE);
+				out.write(blocks[i].data(), blocks[i].size());
+				crc = crc32_combine(crc, block_crcs[i], end - begin);
+			}
+			if (out.fail())
+				log_error("Failed to write gzip file `%s'.\n", filename.c_str());
+			total_size += len;
+
+			if (len >= GZ_WINDOW_SIZE) {
+				window.assign(data + len - GZ_WINDOW_SIZE, GZ_WINDOW_SIZE);
+			} else {
+				window.append(data, len);
+				if (window.size() > GZ_WINDOW_SIZE)
+					window.erase(0, window.size() - GZ_WINDOW_SIZE);
+			}
+			setp(buffer.data(), buffer.data() + buffer.size());
+		}
 	} outbuf;
 };
 PRIVATE_NAMESPACE_END
@@ -544,9 +771,12 @@ void Frontend::extra_args(std::istream *&f, std::string &filename, std::vector<s
 						log_cmd_error("gzip file `%s' uses unsupported compression type %02x\n",
 							filename.c_str(), unsigned(magic[2]));
 					delete ff;
-					std::stringstream *df = new std::stringstream();
-					decompress_gzip(filename, *df);
-					f = df;
+					gzip_istream *gf = new gzip_istream;
+					if (!gf->open(filename)) {
+						delete gf;
+						log_cmd_error("Can't open input file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+					}
+					f = gf;
 	#else
 					log_cmd_error("File `%s' is a gzip file, but Yosys is compiled without zlib.\n", filename.c_str());
 	#endif
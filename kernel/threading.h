@@ -0,0 +1,145 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file contains small helpers for running independent pieces of work on
+// multiple threads. Nothing in the Yosys kernel is thread safe: code running on
+// a worker thread must not call log_*(), must not create or copy IdStrings (their
+// reference counts are not atomic) and must not modify the design. Workers should
+// only read shared data structures and write to per-task result slots that are
+// merged on the main thread afterwards.
+//
+// When Yosys is built without YOSYS_ENABLE_THREADS everything in here degrades
+// to plain sequential execution on the calling thread.
+
+#include "kernel/yosys.h"
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <atomic>
+#  include <thread>
+#  include <mutex>
+#  include <exception>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+// Returns the number of threads to use. A positive request is honored as is,
+// zero (or a negative value) selects the number of hardware threads.
+static inline int yosys_thread_count(int requested = 0)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (requested > 0)
+		return requested;
+	int hw = std::thread::hardware_concurrency();
+	return hw > 0 ? hw : 1;
+#else
+	(void)requested;
+	return 1;
+#endif
+}
+
+// Parses the argument of a "-threads N" style option. N=0 means "all cores".
+static inline int yosys_parse_thread_count(const std::string &arg)
+{
+	int n = atoi(arg.c_str());
+	return yosys_thread_count(n);
+}
+
+// hashlib containers rehash lazily on the first lookup after an insertion, which
+// makes an unsettled container unsafe to look up from several threads at once.
+// Call this on every dict/pool that workers will look up in, after the last
+// insertion and before starting the workers.
+template<typename K, typename T, typename OPS>
+void settle_for_concurrent_reads(const hashlib::dict<K, T, OPS> &container)
+{
+	container.count(K());
+}
+
+template<typename K, typename OPS>
+void settle_for_concurrent_reads(const hashlib::pool<K, OPS> &container)
+{
+	container.count(K());
+}
+
+// Calls fn(i) for every i in [0, count) using up to num_threads threads
+// (including the calling thread). Indices are handed out dynamically in chunks
+// of chunk_size so that unevenly sized tasks are balanced. If a task throws,
+// the remaining tasks are skipped and the first exception is rethrown on the
+// calling thread.
+template<typename F>
+void parallel_for(int num_threads, int count, F fn, int chunk_size = 1)
+{
+	if (chunk_size < 1)
+		chunk_size = 1;
+
+#ifdef YOSYS_ENABLE_THREADS
+	int num_chunks = (count + chunk_size - 1) / chunk_size;
+	num_threads = std::min(num_threads, num_chunks);
+
+	if (num_threads > 1)
+	{
+		std::atomic<int> next_index(0);
+		std::atomic<bool> aborted(false);
+		std::exception_ptr first_exception;
+		std::mutex exception_mutex;
+
+		auto worker = [&]() {
+			while (!aborted.load(std::memory_order_relaxed))
+			{
+				int begin = next_index.fetch_add(chunk_size);
+				if (begin >= count)
+					break;
+				int end = std::min(begin + chunk_size, count);
+				try {
+					for (int i = begin; i < end; i++)
+						fn(i);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(exception_mutex);
+					if (!first_exception)
+						first_exception = std::current_exception();
+					aborted = true;
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads - 1);
+		for (int i = 1; i < num_threads; i++)
+			threads.emplace_back(worker);
+		worker();
+		for (auto &t : threads)
+			t.join();
+
+		if (first_exception)
+			std::rethrow_exception(first_exception);
+		return;
+	}
+#else
+	(void)num_threads;
+#endif
+
+	for (int i = 0; i < count; i++)
+		fn(i);
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
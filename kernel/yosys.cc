@@ -74,6 +74,7 @@ YOSYS_NAMESPACE_BEGIN
 
 int autoidx = 1;
 int yosys_xtrace = 0;
+int yosys_gzip_threads = 0;
 RTLIL::Design *yosys_design = NULL;
 CellTypes yosys_celltypes;
 
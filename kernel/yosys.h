@@ -270,6 +270,7 @@ int GetSize(RTLIL::Wire *wire);
 
 extern int autoidx;
 extern int yosys_xtrace;
+extern int yosys_gzip_threads;
 
 YOSYS_NAMESPACE_END
 
@@ -0,0 +1,158 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "ezipasir.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#endif
+
+ezIpasir::ezIpasir(const std::vector<const ezIpasirApi*> &apis) : apis(apis), solverVariables(0), winner(-1), timedOut(false), lastWinner(-1)
+{
+#ifndef YOSYS_ENABLE_THREADS
+	this->apis.resize(1);
+#endif
+}
+
+ezIpasir::~ezIpasir()
+{
+	release();
+}
+
+void ezIpasir::release()
+{
+	for (size_t i = 0; i < solvers.size(); i++)
+		apis[i]->release(solvers[i]);
+	solvers.clear();
+	solverVariables = 0;
+}
+
+void ezIpasir::clear()
+{
+	release();
+	ezSAT::clear();
+}
+
+int ezIpasir::terminateCallback(void *data)
+{
+	ezIpasir *that = static_cast<ezIpasir*>(data);
+	if (that->winner.load() >= 0)
+		return 1;
+	if (that->solverTimeout > 0 && std::chrono::steady_clock::now() > that->deadline) {
+		that->timedOut = true;
+		return 1;
+	}
+	return 0;
+}
+
+bool ezIpasir::solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions)
+{
+	preSolverCallback();
+
+	solverTimoutStatus = false;
+
+	std::vector<int> assumps, modelIdx;
+
+	for (auto id : assumptions)
+		assumps.push_back(bind(id));
+	for (auto id : modelExpressions)
+		modelIdx.push_back(bind(id));
+
+	if (solvers.empty())
+		for (auto api : apis) {
+			solvers.push_back(api->init());
+			api->set_terminate(solvers.back(), this, terminateCallback);
+		}
+
+	std::vector<std::vector<int>> cnf;
+	consumeCnf(cnf);
+
+	for (auto &clause : cnf)
+		for (auto lit : clause)
+			solverVariables = std::max(solverVariables, abs(lit));
+	for (auto lit : assumps)
+		solverVariables = std::max(solverVariables, abs(lit));
+
+	winner = -1;
+	timedOut = false;
+	deadline = std::chrono::steady_clock::now() + std::chrono::seconds(solverTimeout);
+	std::vector<int> results(solvers.size());
+
+	auto run = [&](int i) {
+		const ezIpasirApi *api = apis[i];
+		for (auto &clause : cnf) {
+			for (auto lit : clause)
+				api->add(solvers[i], lit);
+			api->add(solvers[i], 0);
+		}
+		for (auto lit : assumps)
+			api->assume(solvers[i], lit);
+		results[i] = api->solve(solvers[i]);
+		if (results[i] != 0) {
+			int expected = -1;
+			winner.compare_exchange_strong(expected, i);
+		}
+	};
+
+#ifdef YOSYS_ENABLE_THREADS
+	std::vector<std::thread> threads;
+	for (int i = 1; i < int(solvers.size()); i++)
+		threads.emplace_back(run, i);
+	run(0);
+	for (auto &t : threads)
+		t.join();
+#else
+	run(0);
+#endif
+
+	lastWinner = winner;
+
+	if (lastWinner < 0) {
+		if (timedOut)
+			solverTimoutStatus = true;
+		return false;
+	}
+
+	if (results[lastWinner] != 10)
+		return false;
+
+	const ezIpasirApi *api = apis[lastWinner];
+	void *solver = solvers[lastWinner];
+
+	modelValues.clear();
+	modelValues.resize(modelIdx.size());
+
+	for (size_t i = 0; i < modelIdx.size(); i++)
+	{
+		int idx = modelIdx[i];
+		bool refvalue = true;
+
+		if (idx < 0)
+			idx = -idx, refvalue = false;
+
+		// variables that are not used in any clause have no value
+		bool value = idx <= solverVariables && api->val(solver, idx) > 0;
+		modelValues[i] = (value == refvalue);
+	}
+
+	return true;
+}
@@ -0,0 +1,74 @@
+/*
+ *  ezSAT -- A simple and easy to use CNF generator for SAT solvers
+ *
+ *  Copyright (C) 2013  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EZIPASIR_H
+#define EZIPASIR_H
+
+#include "ezsat.h"
+#include <atomic>
+#include <chrono>
+
+// The function table of a solver implementing the IPASIR interface for
+// incremental SAT solvers (see https://github.com/biotomas/ipasir). The
+// functions are usually looked up in a shared library with dlsym().
+struct ezIpasirApi
+{
+	const char *(*signature)();
+	void *(*init)();
+	void (*release)(void *solver);
+	void (*add)(void *solver, int lit_or_zero);
+	void (*assume)(void *solver, int lit);
+	int (*solve)(void *solver);
+	int (*val)(void *solver, int lit);
+	void (*set_terminate)(void *solver, void *data, int (*terminate)(void *data));
+};
+
+// An ezSAT backend for one or more IPASIR solvers. With more than one solver
+// every clause is added to all of them and each call to solve() runs them
+// concurrently on separate threads (portfolio mode). The first solver to find
+// an answer wins and the others are terminated. Without thread support only
+// the first solver is used.
+//
+// The solver timeout is implemented with the IPASIR terminate callback and
+// is measured in wall clock time.
+class ezIpasir : public ezSAT
+{
+private:
+	std::vector<const ezIpasirApi*> apis;
+	std::vector<void*> solvers;
+	int solverVariables;
+
+	std::atomic<int> winner;
+	std::atomic<bool> timedOut;
+	std::chrono::steady_clock::time_point deadline;
+
+	static int terminateCallback(void *data);
+	void release();
+
+public:
+	ezIpasir(const std::vector<const ezIpasirApi*> &apis);
+	virtual ~ezIpasir();
+	virtual void clear();
+	virtual bool solver(const std::vector<int> &modelExpressions, std::vector<bool> &modelValues, const std::vector<int> &assumptions);
+
+	// index of the solver that answered the last query (for statistics)
+	int lastWinner;
+};
+
+#endif
@@ -32,7 +32,12 @@
 #include <csignal>
 #include <cinttypes>
 
-#ifndef _WIN32
+#if defined(YOSYS_ENABLE_THREADS)
+#  include <chrono>
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#elif !defined(_WIN32)
 #  include <unistd.h>
 #endif
 
@@ -84,7 +89,7 @@ bool ezMiniSAT::eliminated(int idx)
 }
 #endif
 
-#ifndef _WIN32
+#if !defined(_WIN32) && !defined(YOSYS_ENABLE_THREADS)
 ezMiniSAT *ezMiniSAT::alarmHandlerThis = NULL;
 clock_t ezMiniSAT::alarmHandlerTimeout = 0;
 
@@ -183,7 +188,22 @@ contradiction:
 #endif
 	}
 
-#ifndef _WIN32
+#if defined(YOSYS_ENABLE_THREADS)
+	// With thread support the timeout is enforced by a watchdog thread that
+	// interrupts the solver. Unlike SIGALRM this works with several solvers
+	// running concurrently, but it measures wall clock time, not CPU time.
+	std::mutex watchdog_mutex;
+	std::condition_variable watchdog_cv;
+	bool watchdog_done = false;
+	std::thread watchdog;
+
+	if (solverTimeout > 0)
+		watchdog = std::thread([&]() {
+			std::unique_lock<std::mutex> lock(watchdog_mutex);
+			if (!watchdog_cv.wait_for(lock, std::chrono::seconds(solverTimeout), [&]() { return watchdog_done; }))
+				minisatSolver->interrupt();
+		});
+#elif !defined(_WIN32)
 	struct sigaction sig_action;
 	struct sigaction old_sig_action;
 	int old_alarm_timeout = 0;
@@ -200,9 +220,26 @@ contradiction:
 	}
 #endif
 
+#if defined(YOSYS_ENABLE_THREADS)
+	Minisat::lbool result = minisatSolver->solveLimited(assumps);
+	bool foundSolution = result == Minisat::lbool(true);
+
+	if (watchdog.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(watchdog_mutex);
+			watchdog_done = true;
+		}
+		watchdog_cv.notify_all();
+		watchdog.join();
+		minisatSolver->clearInterrupt();
+		// The watchdog may fire after the solver has already returned an
+		// answer, so only an interrupted search counts as a timeout.
+		solverTimoutStatus = !foundSolution && result != Minisat::lbool(false);
+	}
+#else
 	bool foundSolution = minisatSolver->solve(assumps);
 
-#ifndef _WIN32
+#  if !defined(_WIN32)
 	if (solverTimeout > 0) {
 		if (alarmHandlerTimeout == 0)
 			solverTimoutStatus = true;
@@ -210,6 +247,7 @@ contradiction:
 		sigaction(SIGALRM, &old_sig_action, NULL);
 		alarm(old_alarm_timeout);
 	}
+#  endif
 #endif
 
 	if (!foundSolution) {
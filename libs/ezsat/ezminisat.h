@@ -51,7 +51,7 @@ private:
 	std::set<int> cnfFrozenVars;
 #endif
 
-#ifndef _WIN32
+#if !defined(_WIN32) && !defined(YOSYS_ENABLE_THREADS)
 	static ezMiniSAT *alarmHandlerThis;
 	static clock_t alarmHandlerTimeout;
 	static void alarmHandler(int);
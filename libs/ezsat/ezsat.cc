@@ -138,6 +138,12 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 			xorRemovedOddTrues = !xorRemovedOddTrues;
 			continue;
 		}
+		// xor(not(a), b) = not(xor(a, b)): strip the inversions, so that
+		// both forms share the same expression
+		if (op == OpXor && is_not(arg)) {
+			xorRemovedOddTrues = !xorRemovedOddTrues;
+			arg = not_arg(arg);
+		}
 		myArgs.push_back(arg);
 	}
 
@@ -152,6 +158,14 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 		myArgs.resize(j+1);
 	}
 
+	// an argument that is the inversion of another argument (args are sorted)
+	auto has_complement = [&]() {
+		for (auto arg : myArgs)
+			if (is_not(arg) && std::binary_search(myArgs.begin(), myArgs.end(), not_arg(arg)))
+				return true;
+		return false;
+	};
+
 	switch (op)
 	{
 	case OpNot:
@@ -160,6 +174,8 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 			return CONST_FALSE;
 		if (myArgs[0] == CONST_FALSE)
 			return CONST_TRUE;
+		if (is_not(myArgs[0]))
+			return not_arg(myArgs[0]);
 		break;
 
 	case OpAnd:
@@ -167,6 +183,8 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 			return CONST_TRUE;
 		if (myArgs.size() == 1)
 			return myArgs[0];
+		if (std::binary_search(myArgs.begin(), myArgs.end(), CONST_FALSE) || has_complement())
+			return CONST_FALSE;
 		break;
 
 	case OpOr:
@@ -174,6 +192,8 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 			return CONST_FALSE;
 		if (myArgs.size() == 1)
 			return myArgs[0];
+		if (std::binary_search(myArgs.begin(), myArgs.end(), CONST_TRUE) || has_complement())
+			return CONST_TRUE;
 		break;
 
 	case OpXor:
@@ -187,15 +207,33 @@ int ezSAT::expression(OpId op, const std::vector<int> &args)
 		assert(myArgs.size() >= 1);
 		if (myArgs.size() == 1)
 			return CONST_TRUE;
-		// FIXME: Add proper const folding
+		if (has_complement())
+			return CONST_FALSE;
+		if (std::binary_search(myArgs.begin(), myArgs.end(), CONST_TRUE)) {
+			if (std::binary_search(myArgs.begin(), myArgs.end(), CONST_FALSE))
+				return CONST_FALSE;
+			return expression(OpAnd, myArgs);
+		}
+		if (std::binary_search(myArgs.begin(), myArgs.end(), CONST_FALSE))
+			return NOT(expression(OpOr, myArgs));
 		break;
 
 	case OpITE:
 		assert(myArgs.size() == 3);
-		if (myArgs[0] == CONST_TRUE)
+		if (myArgs[0] == CONST_TRUE || myArgs[1] == myArgs[2])
 			return myArgs[1];
 		if (myArgs[0] == CONST_FALSE)
 			return myArgs[2];
+		if (is_not(myArgs[0]))
+			return ITE(not_arg(myArgs[0]), myArgs[2], myArgs[1]);
+		if (myArgs[1] == CONST_TRUE || myArgs[1] == myArgs[0])
+			return OR(myArgs[0], myArgs[2]);
+		if (myArgs[1] == CONST_FALSE)
+			return AND(NOT(myArgs[0]), myArgs[2]);
+		if (myArgs[2] == CONST_TRUE)
+			return OR(NOT(myArgs[0]), myArgs[1]);
+		if (myArgs[2] == CONST_FALSE || myArgs[2] == myArgs[0])
+			return AND(myArgs[0], myArgs[1]);
 		break;
 
 	default:
@@ -517,6 +555,31 @@ int ezSAT::bind_cnf_or(const std::vector<int> &args)
 	return idx;
 }
 
+// A two-input xor or a mux needs only one variable and four clauses when
+// encoded directly, instead of three variables for the and/or form.
+int ezSAT::bind_cnf_xor(int a, int b)
+{
+	int idx = ++cnfVariableCount;
+	add_clause(-idx, a, b);
+	add_clause(-idx, -a, -b);
+	add_clause(idx, -a, b);
+	add_clause(idx, a, -b);
+	return idx;
+}
+
+int ezSAT::bind_cnf_ite(int c, int t, int e)
+{
+	int idx = ++cnfVariableCount;
+	add_clause(-c, -t, idx);
+	add_clause(-c, t, -idx);
+	add_clause(c, -e, idx);
+	add_clause(c, e, -idx);
+	// redundant, but lets unit propagation find the output when t == e
+	add_clause(-t, -e, idx);
+	add_clause(t, e, -idx);
+	return idx;
+}
+
 int ezSAT::bound(int id) const
 {
 	if (id > 0 && id <= int(cnfLiteralVariables.size()))
@@ -588,19 +651,18 @@ int ezSAT::bind(int id, bool auto_freeze)
 		int idx = 0;
 
 		if (op == OpXor) {
+			for (int i = 0; i < int(args.size()); i++)
+				args[i] = bind(args[i], false);
 			while (args.size() > 1) {
 				std::vector<int> newArgs;
 				for (int i = 0; i < int(args.size()); i += 2)
-					if (i+1 == int(args.size())) {
+					if (i+1 == int(args.size()))
 						newArgs.push_back(args[i]);
-					} else {
-						int sub1 = AND(args[i], NOT(args[i+1]));
-						int sub2 = AND(NOT(args[i]), args[i+1]);
-						newArgs.push_back(OR(sub1, sub2));
-					}
+					else
+						newArgs.push_back(bind_cnf_xor(args[i], args[i+1]));
 				args.swap(newArgs);
 			}
-			idx = bind(args.at(0), false);
+			idx = args.at(0);
 			goto assign_idx;
 		}
 
@@ -615,9 +677,9 @@ int ezSAT::bind(int id, bool auto_freeze)
 		}
 
 		if (op == OpITE) {
-			int sub1 = AND(args[0], args[1]);
-			int sub2 = AND(NOT(args[0]), args[2]);
-			idx = bind(OR(sub1, sub2), false);
+			for (int i = 0; i < int(args.size()); i++)
+				args[i] = bind(args[i], false);
+			idx = bind_cnf_ite(args[0], args[1], args[2]);
 			goto assign_idx;
 		}
 
@@ -72,6 +72,11 @@ private:
 	int bind_cnf_not(const std::vector<int> &args);
 	int bind_cnf_and(const std::vector<int> &args);
 	int bind_cnf_or(const std::vector<int> &args);
+	int bind_cnf_xor(int a, int b);
+	int bind_cnf_ite(int c, int t, int e);
+
+	bool is_not(int id) const { return id < 0 && expressions[-id-1].first == OpNot; }
+	int not_arg(int id) const { return expressions[-id-1].second[0]; }
 
 protected:
 	void preSolverCallback();
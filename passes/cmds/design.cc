@@ -70,6 +70,11 @@ struct DesignPass : public Pass {
 		log("name.\n");
 		log("\n");
 		log("\n");
+		log("    design -delete <name>\n");
+		log("\n");
+		log("Delete the design previously saved under the given name.\n");
+		log("\n");
+		log("\n");
 		log("    design -copy-from <name> [-as <new_mod_name>] <selection>\n");
 		log("\n");
 		log("Copy modules from the specified design into the current one. The selection is\n");
@@ -103,7 +108,7 @@ struct DesignPass : public Pass {
 		bool pop_mode = false;
 		bool import_mode = false;
 		RTLIL::Design *copy_from_design = NULL, *copy_to_design = NULL;
-		std::string save_name, load_name, as_name;
+		std::string save_name, load_name, as_name, delete_name;
 		std::vector<RTLIL::Module*> copy_src_modules;
 
 		size_t argidx;
@@ -148,6 +153,13 @@ struct DesignPass : public Pass {
 					log_cmd_error("No saved design '%s' found!\n", load_name.c_str());
 				continue;
 			}
+			if (!got_mode && args[argidx] == "-delete" && argidx+1 < args.size()) {
+				got_mode = true;
+				delete_name = args[++argidx];
+				if (saved_designs.count(delete_name) == 0)
+					log_cmd_error("No saved design '%s' found!\n", delete_name.c_str());
+				continue;
+			}
 			if (!got_mode && args[argidx] == "-copy-from" && argidx+1 < args.size()) {
 				got_mode = true;
 				if (saved_designs.count(args[++argidx]) == 0)
@@ -307,8 +319,16 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
-			for (auto &it : design->modules_)
-				design_copy->add(it.second->clone());
+			// -stash and -push reset the current design right after saving it, so
+			// its modules are moved to the saved design instead of being copied.
+			if (reset_mode || push_mode) {
+				for (auto &it : design->modules_)
+					design_copy->add(it.second);
+				design->modules_.clear();
+			} else {
+				for (auto &it : design->modules_)
+					design_copy->add(it.second->clone());
+			}
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -353,8 +373,15 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
-			for (auto &it : saved_design->modules_)
-				design->add(it.second->clone());
+			// A popped design is deleted afterwards, so its modules can be moved.
+			if (pop_mode) {
+				for (auto &it : saved_design->modules_)
+					design->add(it.second);
+				saved_design->modules_.clear();
+			} else {
+				for (auto &it : saved_design->modules_)
+					design->add(it.second->clone());
+			}
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
@@ -365,6 +392,12 @@ struct DesignPass : public Pass {
 				pushed_designs.pop_back();
 			}
 		}
+
+		if (!delete_name.empty())
+		{
+			delete saved_designs.at(delete_name);
+			saved_designs.erase(delete_name);
+		}
 	}
 } DesignPass;
 
@@ -0,0 +1,168 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2014  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/satgen.h"
+#include "libs/ezsat/ezipasir.h"
+
+#ifdef YOSYS_ENABLE_PLUGINS
+#  include <dlfcn.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct IpasirSatSolver : public SatSolver
+{
+	std::vector<const ezIpasirApi*> apis;
+
+	IpasirSatSolver(string name, const std::vector<const ezIpasirApi*> &apis) : SatSolver(name), apis(apis) { }
+
+	ezSAT *create() YS_OVERRIDE {
+		return new ezIpasir(apis);
+	}
+};
+
+SatSolver *find_satsolver(const string &name)
+{
+	for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+		if (solver->name == name)
+			return solver;
+	return nullptr;
+}
+
+#ifdef YOSYS_ENABLE_PLUGINS
+template<typename T>
+void load_ipasir_symbol(void *hdl, const std::string &filename, const char *name, T &ptr)
+{
+	ptr = reinterpret_cast<T>(dlsym(hdl, name));
+	if (ptr == nullptr)
+		log_cmd_error("Library `%s' does not implement IPASIR: symbol `%s' not found.\n", filename.c_str(), name);
+}
+
+const ezIpasirApi *load_ipasir(const std::string &filename)
+{
+	// Each library is opened with RTLD_LOCAL, so that several solvers
+	// exporting the same ipasir_* symbols can be loaded at the same time.
+	void *hdl = dlopen(filename.c_str(), RTLD_NOW|RTLD_LOCAL);
+	if (hdl == nullptr)
+		log_cmd_error("Can't load IPASIR library `%s': %s\n", filename.c_str(), dlerror());
+
+	ezIpasirApi *api = new ezIpasirApi;
+	load_ipasir_symbol(hdl, filename, "ipasir_signature", api->signature);
+	load_ipasir_symbol(hdl, filename, "ipasir_init", api->init);
+	load_ipasir_symbol(hdl, filename, "ipasir_release", api->release);
+	load_ipasir_symbol(hdl, filename, "ipasir_add", api->add);
+	load_ipasir_symbol(hdl, filename, "ipasir_assume", api->assume);
+	load_ipasir_symbol(hdl, filename, "ipasir_solve", api->solve);
+	load_ipasir_symbol(hdl, filename, "ipasir_val", api->val);
+	load_ipasir_symbol(hdl, filename, "ipasir_set_terminate", api->set_terminate);
+	return api;
+}
+#else
+const ezIpasirApi *load_ipasir(const std::string &)
+{
+	log_cmd_error("This version of yosys is built without plugin support.\n");
+}
+#endif
+
+struct SatSolverPass : public Pass {
+	SatSolverPass() : Pass("satsolver", "select and load SAT solvers") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    satsolver [<name>]\n");
+		log("\n");
+		log("Without arguments, list the available SAT solvers. Otherwise select the SAT\n");
+		log("solver used by all following commands that use a SAT solver (e.g. sat,\n");
+		log("equiv_simple, equiv_induct, freduce). The default is the built-in 'minisat'.\n");
+		log("\n");
+		log("\n");
+		log("    satsolver -load <name> <library>\n");
+		log("\n");
+		log("Load a shared library implementing the IPASIR interface for incremental SAT\n");
+		log("solvers (e.g. CaDiCaL, Glucose or Kissat built with IPASIR support) and make\n");
+		log("it available as solver <name>. Timeouts (e.g. 'sat -timeout') are handled\n");
+		log("by the solver itself using the IPASIR terminate callback.\n");
+		log("\n");
+		log("\n");
+		log("    satsolver -portfolio <name> <solver1> <solver2> ...\n");
+		log("\n");
+		log("Make a portfolio of previously loaded IPASIR solvers available as solver\n");
+		log("<name>. All solvers of the portfolio are given the same problems and run\n");
+		log("concurrently on separate threads. The first answer is used, the other\n");
+		log("solvers are interrupted.\n");
+		log("\n");
+		log("Solvers can be selected for individual commands by calling 'satsolver <name>'\n");
+		log("before them.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *) YS_OVERRIDE
+	{
+		if (args.size() >= 4 && args[1] == "-load")
+		{
+			if (args.size() != 4)
+				cmd_error(args, 4, "Unexpected argument.");
+			if (find_satsolver(args[2]) != nullptr)
+				log_cmd_error("A SAT solver with the name `%s' already exists.\n", args[2].c_str());
+
+			const ezIpasirApi *api = load_ipasir(args[3]);
+			new IpasirSatSolver(args[2], std::vector<const ezIpasirApi*>{api});
+			log("Loaded SAT solver `%s' (%s) from `%s'.\n", args[2].c_str(), api->signature(), args[3].c_str());
+			return;
+		}
+
+		if (args.size() >= 4 && args[1] == "-portfolio")
+		{
+			if (find_satsolver(args[2]) != nullptr)
+				log_cmd_error("A SAT solver with the name `%s' already exists.\n", args[2].c_str());
+
+			std::vector<const ezIpasirApi*> apis;
+			for (size_t argidx = 3; argidx < args.size(); argidx++) {
+				IpasirSatSolver *solver = dynamic_cast<IpasirSatSolver*>(find_satsolver(args[argidx]));
+				if (solver == nullptr)
+					log_cmd_error("`%s' is not a loaded IPASIR solver.\n", args[argidx].c_str());
+				apis.insert(apis.end(), solver->apis.begin(), solver->apis.end());
+			}
+
+			new IpasirSatSolver(args[2], apis);
+			log("Created portfolio SAT solver `%s' with %d solvers.\n", args[2].c_str(), GetSize(apis));
+			return;
+		}
+
+		if (args.size() == 2 && args[1][0] != '-')
+		{
+			SatSolver *solver = find_satsolver(args[1]);
+			if (solver == nullptr)
+				log_cmd_error("No SAT solver with the name `%s'. Use 'satsolver' to list them.\n", args[1].c_str());
+			yosys_satsolver = solver;
+			log("Selected SAT solver `%s'.\n", solver->name.c_str());
+			return;
+		}
+
+		if (args.size() != 1)
+			cmd_error(args, 1, "Unexpected argument.");
+
+		for (auto solver = yosys_satsolver_list; solver != nullptr; solver = solver->next)
+			log("%s %s\n", solver == yosys_satsolver ? "*" : " ", solver->name.c_str());
+	}
+} SatSolverPass;
+
+PRIVATE_NAMESPACE_END
@@ -0,0 +1,285 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "passes/cmds/synth_cache.h"
+#include "backends/ilang/ilang_backend.h"
+#include "libs/sha1/sha1.h"
+#include <sys/stat.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#  include <direct.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct SynthCacheWorker
+{
+	RTLIL::Design *design;
+	std::string key;
+	dict<RTLIL::IdString, std::string> module_hashes;
+
+	SynthCacheWorker(RTLIL::Design *design, std::string key) : design(design), key(key) { }
+
+	// Auto-generated names carry a global autoidx suffix ("$and$foo.v:12$42")
+	// that shifts whenever anything that was read earlier changes. Number
+	// them by order of appearance instead, so that such unrelated edits do
+	// not invalidate the hash.
+	static std::string normalize_dump(const std::string &dump)
+	{
+		dict<std::string, int> auto_names;
+		std::string result, token;
+		result.reserve(dump.size());
+
+		auto flush_token = [&]() {
+			size_t pos = token.rfind('$');
+			if (token.size() > 1 && token[0] == '$' && pos != 0 && pos+1 < token.size() &&
+					token.find_first_not_of("0123456789", pos+1) == std::string::npos) {
+				auto it = auto_names.find(token);
+				int idx = it == auto_names.end() ? (auto_names[token] = GetSize(auto_names)) : it->second;
+				result += stringf("$auto$%d", idx);
+			} else
+				result += token;
+			token.clear();
+		};
+
+		for (char ch : dump) {
+			if (ch == ' ' || ch == '\t' || ch == '\n') {
+				flush_token();
+				result += ch;
+			} else
+				token += ch;
+		}
+		flush_token();
+
+		return result;
+	}
+
+	// The hash covers the module itself, the hashes of all non-blackbox
+	// modules it instantiates and the cache key (Yosys version and script).
+	std::string module_hash(RTLIL::Module *module)
+	{
+		auto it = module_hashes.find(module->name);
+		if (it != module_hashes.end())
+			return it->second;
+
+		std::stringstream buf;
+		ILANG_BACKEND::dump_module(buf, "", module, design, false);
+
+		SHA1 hasher;
+		hasher.update(key);
+		hasher.update(std::string("\n"));
+		hasher.update(normalize_dump(buf.str()));
+
+		std::set<RTLIL::IdString> child_types;
+		for (auto cell : module->cells()) {
+			RTLIL::Module *child = design->module(cell->type);
+			if (child != nullptr && !child->get_blackbox_attribute())
+				child_types.insert(cell->type);
+		}
+		for (auto type : child_types)
+			hasher.update(stringf("\n%s %s", log_id(type), module_hash(design->module(type)).c_str()));
+
+		std::string hash = hasher.final();
+		module_hashes[module->name] = hash;
+		return hash;
+	}
+};
+
+// Each scratchpad entry is a list of "<hash> <module>" lines.
+std::vector<std::pair<std::string, RTLIL::IdString>> scratchpad_get_list(RTLIL::Design *design, std::string varname)
+{
+	std::vector<std::pair<std::string, RTLIL::IdString>> result;
+	std::istringstream iss(design->scratchpad_get_string(varname));
+	std::string hash, name;
+	while (iss >> hash >> name)
+		result.push_back(std::make_pair(hash, RTLIL::IdString(name)));
+	return result;
+}
+
+struct SynthCachePass : public Pass {
+	SynthCachePass() : Pass("synth_cache", "reuse synthesis results of unchanged modules") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    synth_cache -lookup <dir> [-key <string>]\n");
+		log("    synth_cache -restore <dir>\n");
+		log("\n");
+		log("This command is used by the synthesis scripts to implement incremental\n");
+		log("synthesis (see for example 'synth -incremental').\n");
+		log("\n");
+		log("'synth_cache -lookup' hashes the contents of every module, together with the\n");
+		log("hashes of the modules it instantiates, the Yosys version and the given key\n");
+		log("(usually the synthesis command line). Modules for which <dir> contains a\n");
+		log("netlist under that hash are turned into blackboxes, so that the rest of the\n");
+		log("synthesis script skips them.\n");
+		log("\n");
+		log("'synth_cache -restore' replaces these blackboxes with the cached netlists and\n");
+		log("writes the synthesized netlists of all other modules hashed by the last\n");
+		log("'synth_cache -lookup' to <dir>.\n");
+		log("\n");
+		log("The cached netlists are RTLIL files and may be deleted at any time.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
+	{
+		std::string lookup_dir, restore_dir, key;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-lookup" && argidx+1 < args.size()) {
+				lookup_dir = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-restore" && argidx+1 < args.size()) {
+				restore_dir = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-key" && argidx+1 < args.size()) {
+				key = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design, false);
+
+		if (lookup_dir.empty() == restore_dir.empty())
+			log_cmd_error("Exactly one of -lookup and -restore must be given.\n");
+
+		if (!lookup_dir.empty())
+		{
+			log_header(design, "Executing SYNTH_CACHE pass (looking up modules in `%s').\n", lookup_dir.c_str());
+
+			SynthCacheWorker worker(design, stringf("%s\n%s", yosys_version_str, key.c_str()));
+			std::string pending, cached;
+			std::vector<RTLIL::Module*> cached_modules;
+			int total_count = 0;
+
+			// Hash all modules before turning any of them into blackboxes.
+			for (auto module : design->modules())
+			{
+				if (module->get_blackbox_attribute())
+					continue;
+
+				std::string hash = worker.module_hash(module);
+				std::string filename = stringf("%s/%s.il", lookup_dir.c_str(), hash.c_str());
+				total_count++;
+
+				if (check_file_exists(filename)) {
+					log("Module %s is in the cache (%s).\n", log_id(module), hash.c_str());
+					cached += stringf("%s %s\n", hash.c_str(), module->name.c_str());
+					cached_modules.push_back(module);
+				} else {
+					log("Module %s is not in the cache (%s).\n", log_id(module), hash.c_str());
+					pending += stringf("%s %s\n", hash.c_str(), module->name.c_str());
+				}
+			}
+
+			for (auto module : cached_modules)
+				Pass::call_on_module(design, module, "blackbox");
+
+			design->scratchpad_set_string("synth_cache.pending", pending);
+			design->scratchpad_set_string("synth_cache.cached", cached);
+
+			log("Found %d of %d modules in the cache.\n", GetSize(cached_modules), total_count);
+		}
+
+		if (!restore_dir.empty())
+		{
+			log_header(design, "Executing SYNTH_CACHE pass (restoring and storing modules in `%s').\n", restore_dir.c_str());
+
+			for (auto &it : scratchpad_get_list(design, "synth_cache.cached"))
+			{
+				RTLIL::Module *module = design->module(it.second);
+				if (module == nullptr)
+					continue;
+
+				std::string filename = stringf("%s/%s.il", restore_dir.c_str(), it.first.c_str());
+				RTLIL::Design *cache_design = new RTLIL::Design;
+				log_push();
+				run_frontend(filename, "ilang", cache_design);
+				log_pop();
+
+				RTLIL::Module *cached = cache_design->module(it.second);
+				if (cached == nullptr)
+					log_error("Cache file %s does not contain module %s.\n", filename.c_str(), log_id(it.second));
+
+				log("Restoring module %s from the cache (%s).\n", log_id(module), it.first.c_str());
+				design->remove(module);
+				design->add(cached->clone());
+				delete cache_design;
+			}
+
+#ifdef _WIN32
+			_mkdir(restore_dir.c_str());
+#else
+			mkdir(restore_dir.c_str(), 0777);
+#endif
+
+			for (auto &it : scratchpad_get_list(design, "synth_cache.pending"))
+			{
+				RTLIL::Module *module = design->module(it.second);
+				if (module == nullptr)
+					continue;
+
+				// Write to a temp file first, so that concurrent runs sharing
+				// the same cache never see partially written netlists.
+				std::string filename = stringf("%s/%s.il", restore_dir.c_str(), it.first.c_str());
+				std::string temp_filename = make_temp_file(restore_dir + "/.synth_cache_XXXXXX");
+
+				std::ofstream f(temp_filename);
+				if (f.fail())
+					log_error("Can't open file `%s' for writing: %s\n", temp_filename.c_str(), strerror(errno));
+				f << stringf("# Synthesized netlist of module %s, cached by 'synth_cache'.\n", log_id(module));
+				ILANG_BACKEND::dump_module(f, "", module, design, false);
+				f.close();
+
+				if (rename(temp_filename.c_str(), filename.c_str()) != 0) {
+					remove(temp_filename.c_str());
+					log_error("Can't rename `%s' to `%s': %s\n", temp_filename.c_str(), filename.c_str(), strerror(errno));
+				}
+				log("Stored module %s in the cache (%s).\n", log_id(module), it.first.c_str());
+			}
+
+			design->scratchpad_unset("synth_cache.pending");
+			design->scratchpad_unset("synth_cache.cached");
+		}
+	}
+} SynthCachePass;
+
+PRIVATE_NAMESPACE_END
+
+YOSYS_NAMESPACE_BEGIN
+
+std::string synth_cache_key(const std::vector<std::string> &args)
+{
+	SHA1 hasher;
+	for (size_t i = 0; i < args.size(); i++)
+		if (args[i] == "-incremental")
+			i++;
+		else
+			hasher.update(args[i] + "\n");
+	return hasher.final();
+}
+
+YOSYS_NAMESPACE_END
@@ -20,10 +20,31 @@
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
 #include "kernel/sigtools.h"
+#include "kernel/threading.h"
+#include "passes/equiv/equiv_sim.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// One unrolling of the circuit in its own SAT solver. The base case and the
+// induction step use separate instances when running on several threads, and
+// every thread that proves individual $equiv cells has an instance of its own.
+struct EquivInductSolver
+{
+	ezSatPtr ez;
+	SatGen satgen;
+	dict<int, int> ez_step_is_consistent;
+	int num_steps, num_consistent_steps;
+
+	// the condition "A != B" at the last step for every cell of the workset
+	vector<int> ez_equiv_failed;
+
+	EquivInductSolver(SigMap *sigmap, bool model_undef) : satgen(ez.get(), sigmap), num_steps(0), num_consistent_steps(0)
+	{
+		satgen.model_undef = model_undef;
+	}
+};
+
 struct EquivInductWorker
 {
 	Module *module;
@@ -32,25 +53,32 @@ struct EquivInductWorker
 	vector<Cell*> cells;
 	pool<Cell*> workset;
 
-	ezSatPtr ez;
-	SatGen satgen;
-
-	int max_seq;
+	int max_seq, num_threads;
+	bool model_undef;
 	int success_counter;
+	int skipped_sat_calls;
+
+	// Witnesses found by simulation: the longest run of consistent steps, the
+	// longest run of consistent steps followed by an inconsistent step, and
+	// the cells that differ after at least max_seq consistent steps.
+	int sim_base_witness;
+	int sim_induct_witness;
+	pool<Cell*> sim_refuted;
 
-	dict<int, int> ez_step_is_consistent;
 	pool<Cell*> cell_warn_cache;
 	SigPool undriven_signals;
 
-	EquivInductWorker(Module *module, const pool<Cell*> &unproven_equiv_cells, bool model_undef, int max_seq) : module(module), sigmap(module),
-			cells(module->selected_cells()), workset(unproven_equiv_cells),
-			satgen(ez.get(), &sigmap), max_seq(max_seq), success_counter(0)
+	EquivInductWorker(Module *module, const pool<Cell*> &unproven_equiv_cells, bool model_undef, int max_seq, int num_threads) : module(module), sigmap(module),
+			cells(module->selected_cells()), workset(unproven_equiv_cells), max_seq(max_seq), num_threads(num_threads),
+			model_undef(model_undef), success_counter(0), skipped_sat_calls(0), sim_base_witness(0), sim_induct_witness(0)
 	{
-		satgen.model_undef = model_undef;
 	}
 
-	void create_timestep(int step)
+	void create_timestep(EquivInductSolver *solver)
 	{
+		ezSatPtr &ez = solver->ez;
+		SatGen &satgen = solver->satgen;
+		int step = ++solver->num_steps;
 		vector<int> ez_equal_terms;
 
 		for (auto cell : cells) {
@@ -77,15 +105,115 @@ struct EquivInductWorker
 				ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step)));
 		}
 
-		log_assert(!ez_step_is_consistent.count(step));
-		ez_step_is_consistent[step] = ez->expression(ez->OpAnd, ez_equal_terms);
+		if (step == 1 && satgen.model_undef) {
+			for (auto bit : satgen.initial_state.export_all())
+				ez->assume(ez->NOT(satgen.importUndefSigBit(bit, 1)));
+		}
+
+		log_assert(!solver->ez_step_is_consistent.count(step));
+		solver->ez_step_is_consistent[step] = ez->expression(ez->OpAnd, ez_equal_terms);
+	}
+
+	void assume_consistent(EquivInductSolver *solver, int step)
+	{
+		while (solver->num_steps < step)
+			create_timestep(solver);
+		while (solver->num_consistent_steps < step)
+			solver->ez->assume(solver->ez_step_is_consistent[++solver->num_consistent_steps]);
+	}
+
+	// Creates the proof obligations for the individual $equiv cells, in the
+	// order of the sorted workset.
+	void create_equiv_conditions(EquivInductSolver *solver)
+	{
+		assume_consistent(solver, max_seq);
+		while (solver->num_steps < max_seq+1)
+			create_timestep(solver);
+
+		for (auto cell : workset)
+		{
+			SigBit bit_a = sigmap(cell->getPort("\\A")).as_bit();
+			SigBit bit_b = sigmap(cell->getPort("\\B")).as_bit();
+
+			int ez_a = solver->satgen.importSigBit(bit_a, max_seq+1);
+			int ez_b = solver->satgen.importSigBit(bit_b, max_seq+1);
+			int cond = solver->ez->XOR(ez_a, ez_b);
+
+			if (model_undef)
+				cond = solver->ez->AND(cond, solver->ez->NOT(solver->satgen.importUndefSigBit(bit_a, max_seq+1)));
+
+			solver->ez_equiv_failed.push_back(cond);
+		}
+	}
+
+	// Simulates the circuit from its initial state with random inputs. Any
+	// window of the simulated trace is a model for the SAT problems below,
+	// because the state in the first step of these problems is unconstrained.
+	void simulate(int num_patterns)
+	{
+		EquivSimulator sim(module, sigmap, cells, num_patterns);
+		if (!sim.usable) {
+			log("  Skipping simulation: module has combinational loops or conflicting drivers.\n");
+			return;
+		}
+
+		vector<pair<SigBit, SigBit>> terms;
+		for (auto cell : cells)
+			if (cell->type == "$equiv") {
+				SigBit bit_a = sigmap(cell->getPort("\\A")).as_bit();
+				SigBit bit_b = sigmap(cell->getPort("\\B")).as_bit();
+				if (bit_a != bit_b)
+					terms.push_back(make_pair(bit_a, bit_b));
+			}
+
+		int num_cycles = std::max(32, 4*(max_seq+1));
+		vector<int> run_length(64*sim.num_words);
+		sim.init_state();
+
+		for (int t = 0; t < num_cycles; t++)
+		{
+			if (t > 0)
+				sim.step();
+			sim.eval();
+
+			for (int w = 0; w < sim.num_words; w++)
+			{
+				uint64_t consistent = ~uint64_t(0), inconsistent = 0;
+				for (auto &term : terms) {
+					consistent &= sim.agree(term.first, term.second, w);
+					inconsistent |= sim.differ(term.first, term.second, w);
+				}
+
+				for (int i = 0; i < 64; i++)
+				{
+					uint64_t mask = uint64_t(1) << i;
+					int &run = run_length[64*w + i];
+
+					if (consistent & mask)
+						sim_base_witness = std::max(sim_base_witness, run+1);
+
+					if (inconsistent & mask) {
+						sim_induct_witness = std::max(sim_induct_witness, run);
+						if (run >= max_seq)
+							for (auto cell : workset)
+								if (!sim_refuted.count(cell) && (sim.differ(cell->getPort("\\A").as_bit(), cell->getPort("\\B").as_bit(), w) & mask))
+									sim_refuted.insert(cell);
+					}
+
+					run = (consistent & mask) ? run+1 : 0;
+				}
+			}
+		}
+
+		log("  Simulated %d cycles with %d patterns: %d $equiv cells diverge after %d or more consistent steps.\n",
+				num_cycles, 64*sim.num_words, GetSize(sim_refuted), max_seq);
 	}
 
 	void run()
 	{
 		log("Found %d unproven $equiv cells in module %s:\n", GetSize(workset), log_id(module));
 
-		if (satgen.model_undef) {
+		if (model_undef) {
 			for (auto cell : cells)
 				if (yosys_celltypes.cell_known(cell->type))
 					for (auto &conn : cell->connections())
@@ -98,63 +226,152 @@ struct EquivInductWorker
 							undriven_signals.del(sigmap(conn.second));
 		}
 
-		create_timestep(1);
+		// With a single thread the base case and the induction step share one
+		// solver. Otherwise both are solved in parallel on their own solvers.
+		vector<std::unique_ptr<EquivInductSolver>> solvers;
+		solvers.emplace_back(new EquivInductSolver(&sigmap, model_undef));
+		if (num_threads > 1)
+			solvers.emplace_back(new EquivInductSolver(&sigmap, model_undef));
 
-		if (satgen.model_undef) {
-			for (auto bit : satgen.initial_state.export_all())
-				ez->assume(ez->NOT(satgen.importUndefSigBit(bit, 1)));
+		EquivInductSolver *induct = solvers.front().get();
+		EquivInductSolver *base = solvers.back().get();
+
+		for (auto &solver : solvers)
+			create_timestep(solver.get());
+
+		if (model_undef)
 			log("  Undef modelling: force def on %d initial reg values and %d inputs.\n",
-				GetSize(satgen.initial_state), GetSize(undriven_signals));
-		}
+				GetSize(induct->satgen.initial_state), GetSize(undriven_signals));
 
 		for (int step = 1; step <= max_seq; step++)
 		{
-			ez->assume(ez_step_is_consistent[step]);
+			bool base_solve = step > sim_base_witness;
+			bool induct_solve = step > sim_induct_witness;
+			bool base_result = true, induct_result = true;
+
+			assume_consistent(base, step);
+			assume_consistent(induct, step);
+			create_timestep(induct);
+			int new_step_not_consistent = induct->ez->NOT(induct->ez_step_is_consistent[step+1]);
+
+			if (!base_solve) {
+				log("  Base case for step %d exists in simulation.\n", step);
+				skipped_sat_calls++;
+			} else
+				log("  Proving existence of base case for step %d. (%d clauses over %d variables)\n", step,
+						base->ez->numCnfClauses(), base->ez->numCnfVariables());
+
+			if (base_solve && induct_solve && base != induct)
+			{
+				log("  Proving induction step %d. (%d clauses over %d variables)\n", step,
+						induct->ez->numCnfClauses(), induct->ez->numCnfVariables());
+				log_flush();
+
+				parallel_for(2, 2, [&](int i) {
+					if (i == 0)
+						base_result = base->ez->solve();
+					else
+						induct_result = induct->ez->solve(new_step_not_consistent);
+				});
+			}
+			else
+			{
+				if (base_solve)
+					base_result = base->ez->solve();
+				if (induct_solve && base_result)
+					log("  Proving induction step %d. (%d clauses over %d variables)\n", step,
+							induct->ez->numCnfClauses(), induct->ez->numCnfVariables());
+			}
 
-			log("  Proving existence of base case for step %d. (%d clauses over %d variables)\n", step, ez->numCnfClauses(), ez->numCnfVariables());
-			if (!ez->solve()) {
+			if (!base_result) {
 				log("  Proof for base case failed. Circuit inherently diverges!\n");
 				return;
 			}
 
-			create_timestep(step+1);
-			int new_step_not_consistent = ez->NOT(ez_step_is_consistent[step+1]);
-			ez->bind(new_step_not_consistent);
-
-			log("  Proving induction step %d. (%d clauses over %d variables)\n", step, ez->numCnfClauses(), ez->numCnfVariables());
-			if (!ez->solve(new_step_not_consistent)) {
-				log("  Proof for induction step holds. Entire workset of %d cells proven!\n", GetSize(workset));
-				for (auto cell : workset)
-					cell->setPort("\\B", cell->getPort("\\A"));
-				success_counter += GetSize(workset);
-				return;
+			if (!induct_solve) {
+				log("  Induction step %d fails in simulation.\n", step);
+				skipped_sat_calls++;
+			} else {
+				if (base == induct || !base_solve)
+					induct_result = induct->ez->solve(new_step_not_consistent);
+				if (!induct_result) {
+					log("  Proof for induction step holds. Entire workset of %d cells proven!\n", GetSize(workset));
+					for (auto cell : workset)
+						cell->setPort("\\B", cell->getPort("\\A"));
+					success_counter += GetSize(workset);
+					return;
+				}
 			}
 
 			log("  Proof for induction step failed. %s\n", step != max_seq ? "Extending to next time step." : "Trying to prove individual $equiv from workset.");
 		}
 
+		prove_individual(solvers);
+	}
+
+	// The $equiv cells are split into rounds, and the cells of a round are
+	// distributed over the solvers. Every proven cell is added as a lemma to
+	// all solvers before the next round. The lemmas are implied by the problem
+	// itself, so they only speed up the solvers and the result does not depend
+	// on the number of threads.
+	void prove_individual(vector<std::unique_ptr<EquivInductSolver>> &solvers)
+	{
 		workset.sort();
+		vector<Cell*> workset_cells(workset.begin(), workset.end());
 
-		for (auto cell : workset)
-		{
-			SigBit bit_a = sigmap(cell->getPort("\\A")).as_bit();
-			SigBit bit_b = sigmap(cell->getPort("\\B")).as_bit();
+		while (GetSize(solvers) < std::min(num_threads, GetSize(workset_cells)))
+			solvers.emplace_back(new EquivInductSolver(&sigmap, model_undef));
+
+		for (auto &solver : solvers)
+			create_equiv_conditions(solver.get());
 
-			log("  Trying to prove $equiv for %s:", log_signal(sigmap(cell->getPort("\\Y"))));
+		int num_solvers = GetSize(solvers);
+		int round_size = num_solvers == 1 ? 1 : 4*num_solvers;
+		// Set by the workers, so not a vector<bool>, which packs its elements into
+		// shared words.
+		vector<char> proven(GetSize(workset_cells));
 
-			int ez_a = satgen.importSigBit(bit_a, max_seq+1);
-			int ez_b = satgen.importSigBit(bit_b, max_seq+1);
-			int cond = ez->XOR(ez_a, ez_b);
+		for (int round_begin = 0; round_begin < GetSize(workset_cells); round_begin += round_size)
+		{
+			int round_end = std::min(round_begin + round_size, GetSize(workset_cells));
+			vector<vector<int>> solver_queue(num_solvers);
+
+			for (int i = round_begin, k = 0; i < round_end; i++)
+				if (!sim_refuted.count(workset_cells[i]))
+					solver_queue[k++ % num_solvers].push_back(i);
+
+			parallel_for(num_solvers, num_solvers, [&](int k) {
+				EquivInductSolver *solver = solvers[k].get();
+				for (int i : solver_queue[k])
+					if (!solver->ez->solve(solver->ez_equiv_failed[i])) {
+						solver->ez->assume(solver->ez->NOT(solver->ez_equiv_failed[i]));
+						proven[i] = true;
+					}
+			});
+
+			for (int i = round_begin; i < round_end; i++)
+			{
+				Cell *cell = workset_cells[i];
+				log("  Trying to prove $equiv for %s:", log_signal(sigmap(cell->getPort("\\Y"))));
+
+				if (sim_refuted.count(cell)) {
+					log(" failed in simulation.\n");
+					skipped_sat_calls++;
+					continue;
+				}
 
-			if (satgen.model_undef)
-				cond = ez->AND(cond, ez->NOT(satgen.importUndefSigBit(bit_a, max_seq+1)));
+				if (!proven[i]) {
+					log(" failed.\n");
+					continue;
+				}
 
-			if (!ez->solve(cond)) {
 				log(" success!\n");
 				cell->setPort("\\B", cell->getPort("\\A"));
 				success_counter++;
-			} else {
-				log(" failed.\n");
+
+				for (int k = 0; k < num_solvers; k++)
+					if (std::find(solver_queue[k].begin(), solver_queue[k].end(), i) == solver_queue[k].end())
+						solvers[k]->ez->assume(solvers[k]->ez->NOT(solvers[k]->ez_equiv_failed[i]));
 			}
 		}
 	}
@@ -179,6 +396,17 @@ struct EquivInductPass : public Pass {
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 4)\n");
 		log("\n");
+		log("    -sim <N>\n");
+		log("        simulate the circuit from its initial state with N random input\n");
+		log("        patterns first, and skip the SAT calls whose outcome is already\n");
+		log("        shown by the simulation. this does not change the result.\n");
+		log("\n");
+		log("    -threads <N>\n");
+		log("        solve the base case and the induction step in parallel, and prove the\n");
+		log("        individual $equiv cells on N threads, each with its own SAT solver.\n");
+		log("        N may be zero to use all available cores. (default = 1) the result\n");
+		log("        does not depend on the number of threads.\n");
+		log("\n");
 		log("This command is very effective in proving complex sequential circuits, when\n");
 		log("the internal state of the circuit quickly propagates to $equiv cells.\n");
 		log("\n");
@@ -194,9 +422,9 @@ struct EquivInductPass : public Pass {
 	}
 	void execute(std::vector<std::string> args, Design *design) YS_OVERRIDE
 	{
-		int success_counter = 0;
+		int success_counter = 0, skipped_sat_calls = 0;
 		bool model_undef = false;
-		int max_seq = 4;
+		int max_seq = 4, sim_patterns = 0, num_threads = 1;
 
 		log_header(design, "Executing EQUIV_INDUCT pass.\n");
 
@@ -210,6 +438,14 @@ struct EquivInductPass : public Pass {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_patterns = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -229,11 +465,16 @@ struct EquivInductPass : public Pass {
 				continue;
 			}
 
-			EquivInductWorker worker(module, unproven_equiv_cells, model_undef, max_seq);
+			EquivInductWorker worker(module, unproven_equiv_cells, model_undef, max_seq, num_threads);
+			if (sim_patterns > 0)
+				worker.simulate(sim_patterns);
 			worker.run();
 			success_counter += worker.success_counter;
+			skipped_sat_calls += worker.skipped_sat_calls;
 		}
 
+		if (sim_patterns > 0)
+			log("Simulation saved %d SAT calls.\n", skipped_sat_calls);
 		log("Proved %d previously unproven $equiv cells.\n", success_counter);
 	}
 } EquivInductPass;
@@ -0,0 +1,440 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef EQUIV_SIM_H
+#define EQUIV_SIM_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include "kernel/consteval.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Bit-parallel random simulation of a set of cells, used by the equiv_* passes
+// to find counterexamples before calling the SAT solver. Every net holds 64
+// patterns per machine word, plus a mask of the patterns in which its value
+// is known. The simulation uses the same cell semantics as the SAT models in
+// kernel/satgen.h: $equiv drives Y from A, and the flip-flop types modelled
+// there ($ff, $dff, $_FF_, $_DFF_[NP]_) copy D to Q in every step.
+//
+// Nets that are not driven by any of the given cells are free and get new
+// random values in every cycle. Simple gates are evaluated with bitwise
+// operations, all other evaluable cells pattern by pattern with ConstEval.
+// Values are only known when they are known for every possible value of the
+// unknown nets (x constants and the outputs of cells that cannot be
+// simulated), so a counterexample found by the simulation is always a valid
+// model for the SAT problem.
+struct EquivSimulator
+{
+	enum sim_op_t {
+		OP_BUF, OP_NOT, OP_AND, OP_NAND, OP_OR, OP_NOR, OP_XOR, OP_XNOR,
+		OP_ANDNOT, OP_ORNOT, OP_MUX, OP_NMUX, OP_EVAL
+	};
+
+	struct sim_task_t
+	{
+		sim_op_t op;
+		int a, b, s, y;
+		RTLIL::Cell *cell;
+	};
+
+	// slots 0 and 1 are the constants, slot 2 is unknown and slot 3 is a sink
+	// for the outputs of cells whose results are not used
+	static const int slot_unknown = 2;
+	static const int slot_sink = 3;
+
+	RTLIL::Module *module;
+	SigMap &sigmap;
+	ConstEval ce;
+	int num_words;
+	uint64_t rng_state;
+
+	// false if the cells contain combinational loops or nets with several
+	// drivers; no counterexamples can be trusted then
+	bool usable = true;
+
+	dict<RTLIL::SigBit, int> slot_index;
+	std::vector<uint64_t> value, known;
+	std::vector<sim_task_t> tasks;
+	std::vector<int> free_slots, ff_d, ff_q;
+
+	EquivSimulator(RTLIL::Module *module, SigMap &sigmap, const std::vector<RTLIL::Cell*> &cells, int num_patterns, uint64_t seed = 1) :
+			module(module), sigmap(sigmap), ce(module), num_words(std::max(1, (num_patterns + 63) / 64)), rng_state(seed)
+	{
+		value.resize(4 * num_words);
+		known.resize(4 * num_words);
+		for (int w = 0; w < num_words; w++) {
+			value[1*num_words + w] = ~uint64_t(0);
+			known[0*num_words + w] = ~uint64_t(0);
+			known[1*num_words + w] = ~uint64_t(0);
+		}
+
+		CellTypes ct;
+		ct.setup_internals();
+		ct.setup_stdcells();
+
+		dict<RTLIL::SigBit, RTLIL::Cell*> bit2driver;
+		pool<RTLIL::SigBit> ff_bits;
+		std::vector<RTLIL::Cell*> comb_cells;
+
+		auto add_driver = [&](RTLIL::SigBit bit) {
+			if (bit.wire == nullptr)
+				return;
+			if (bit2driver.count(bit) || ff_bits.count(bit))
+				usable = false;
+			slot(bit, true);
+		};
+
+		for (auto cell : cells)
+		{
+			if (cell->type.in("$ff", "$dff", "$_FF_", "$_DFF_N_", "$_DFF_P_")) {
+				RTLIL::SigSpec sig_d = sigmap(cell->getPort("\\D"));
+				RTLIL::SigSpec sig_q = sigmap(cell->getPort("\\Q"));
+				for (int i = 0; i < GetSize(sig_q); i++) {
+					add_driver(sig_q[i]);
+					if (sig_q[i].wire == nullptr)
+						continue;
+					ff_bits.insert(sig_q[i]);
+					ff_d.push_back(slot(sig_d[i], true));
+					ff_q.push_back(slot(sig_q[i]));
+				}
+				continue;
+			}
+
+			if (!ct.cell_known(cell->type))
+				continue;
+
+			for (auto &conn : cell->connections())
+				if (ct.cell_output(cell->type, conn.first))
+					for (auto bit : sigmap(conn.second)) {
+						add_driver(bit);
+						if (bit.wire != nullptr)
+							bit2driver[bit] = cell;
+					}
+			comb_cells.push_back(cell);
+		}
+
+		// levelize the combinational cells
+		dict<RTLIL::Cell*, pool<RTLIL::Cell*>> cell_users;
+		dict<RTLIL::Cell*, int> indegree;
+		for (auto cell : comb_cells) {
+			pool<RTLIL::Cell*> drivers;
+			for (auto &conn : cell->connections())
+				if (ct.cell_input(cell->type, conn.first))
+					for (auto bit : sigmap(conn.second)) {
+						slot(bit, true);
+						auto it = bit2driver.find(bit);
+						if (it != bit2driver.end())
+							drivers.insert(it->second);
+					}
+			indegree[cell] = GetSize(drivers);
+			for (auto driver : drivers)
+				cell_users[driver].insert(cell);
+		}
+
+		std::vector<RTLIL::Cell*> queue;
+		for (auto cell : comb_cells)
+			if (indegree.at(cell) == 0)
+				queue.push_back(cell);
+
+		for (int i = 0; i < GetSize(queue); i++) {
+			add_tasks(ct, queue[i]);
+			for (auto user : cell_users[queue[i]])
+				if (--indegree.at(user) == 0)
+					queue.push_back(user);
+		}
+
+		if (GetSize(queue) != GetSize(comb_cells))
+			usable = false;
+
+		for (auto &it : slot_index)
+			if (it.first.wire != nullptr && !bit2driver.count(it.first) && !ff_bits.count(it.first))
+				free_slots.push_back(it.second);
+	}
+
+	int slot(RTLIL::SigBit bit, bool create = false)
+	{
+		if (bit.wire == nullptr)
+			return bit.data == RTLIL::State::S0 ? 0 : bit.data == RTLIL::State::S1 ? 1 : slot_unknown;
+
+		auto it = slot_index.find(bit);
+		if (it != slot_index.end())
+			return it->second;
+		if (!create)
+			return slot_unknown;
+
+		int index = GetSize(value) / num_words;
+		slot_index[bit] = index;
+		value.resize(value.size() + num_words);
+		known.resize(known.size() + num_words);
+		return index;
+	}
+
+	void add_tasks(const CellTypes &ct, RTLIL::Cell *cell)
+	{
+		static const dict<RTLIL::IdString, sim_op_t> gate_ops = {
+			{"$_BUF_", OP_BUF}, {"$_NOT_", OP_NOT}, {"$_AND_", OP_AND}, {"$_NAND_", OP_NAND},
+			{"$_OR_", OP_OR}, {"$_NOR_", OP_NOR}, {"$_XOR_", OP_XOR}, {"$_XNOR_", OP_XNOR},
+			{"$_ANDNOT_", OP_ANDNOT}, {"$_ORNOT_", OP_ORNOT}, {"$_MUX_", OP_MUX}, {"$_NMUX_", OP_NMUX},
+			{"$equiv", OP_BUF}, {"$pos", OP_BUF}, {"$not", OP_NOT}, {"$and", OP_AND}, {"$or", OP_OR},
+			{"$xor", OP_XOR}, {"$xnor", OP_XNOR}, {"$mux", OP_MUX}
+		};
+
+		auto it = gate_ops.find(cell->type);
+		if (it != gate_ops.end())
+		{
+			RTLIL::SigSpec sig_a = sigmap(cell->getPort("\\A"));
+			RTLIL::SigSpec sig_b = cell->hasPort("\\B") ? sigmap(cell->getPort("\\B")) : RTLIL::SigSpec();
+			RTLIL::SigSpec sig_s = cell->hasPort("\\S") ? sigmap(cell->getPort("\\S")) : RTLIL::SigSpec();
+			RTLIL::SigSpec sig_y = sigmap(cell->getPort("\\Y"));
+
+			// coarse cells are only simulated bitwise when no extension is involved
+			bool bitwise = GetSize(sig_a) == GetSize(sig_y) && (sig_b.empty() || GetSize(sig_b) == GetSize(sig_y));
+			if (it->second == OP_MUX && cell->type == "$mux")
+				bitwise = GetSize(sig_s) == 1;
+
+			if (bitwise) {
+				for (int i = 0; i < GetSize(sig_y); i++) {
+					sim_task_t task;
+					task.op = it->second;
+					task.a = slot(sig_a[i]);
+					task.b = sig_b.empty() ? 0 : slot(sig_b[i]);
+					task.s = sig_s.empty() ? 0 : slot(sig_s[0]);
+					task.y = sig_y[i].wire ? slot(sig_y[i]) : slot_sink;
+					task.cell = cell;
+					tasks.push_back(task);
+				}
+				return;
+			}
+		}
+
+		if (!ct.cell_evaluable(cell->type) || cell->type.in("$initstate", "$anyconst", "$anyseq", "$allconst", "$allseq",
+				"$tribuf", "$_TBUF_"))
+			return;
+
+		sim_task_t task;
+		task.op = OP_EVAL;
+		task.a = task.b = task.s = task.y = 0;
+		task.cell = cell;
+		tasks.push_back(task);
+	}
+
+	uint64_t rng()
+	{
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 7;
+		rng_state ^= rng_state << 17;
+		return rng_state;
+	}
+
+	void randomize(int slot)
+	{
+		for (int w = 0; w < num_words; w++) {
+			value[slot*num_words + w] = rng();
+			known[slot*num_words + w] = ~uint64_t(0);
+		}
+	}
+
+	// Random values for all flip-flops. Like in the SAT models, the state is
+	// taken from random values on the D inputs, so that flip-flops that share
+	// a D input (or have a constant one) start with the same value.
+	void random_state()
+	{
+		pool<int> d_slots;
+		for (int d : ff_d)
+			if (d > slot_sink && d_slots.insert(d).second)
+				randomize(d);
+		step();
+	}
+
+	// Initial values from the init attributes, random values where there
+	// is no (or an undefined) init value.
+	void init_state()
+	{
+		for (int q : ff_q)
+			randomize(q);
+		for (auto wire : module->wires()) {
+			auto it = wire->attributes.find("\\init");
+			if (it == wire->attributes.end())
+				continue;
+			RTLIL::SigSpec sig = sigmap(wire);
+			for (int i = 0; i < GetSize(sig) && i < GetSize(it->second); i++) {
+				RTLIL::State init = it->second.bits[i];
+				if (init != RTLIL::State::S0 && init != RTLIL::State::S1)
+					continue;
+				int s = slot(sig[i]);
+				if (s <= slot_sink)
+					continue;
+				for (int w = 0; w < num_words; w++)
+					value[s*num_words + w] = init == RTLIL::State::S1 ? ~uint64_t(0) : 0;
+			}
+		}
+	}
+
+	// Evaluates the combinational cells with new random values on all free nets
+	// (or with the values that are already there).
+	void eval(bool randomize_free = true)
+	{
+		if (randomize_free)
+			for (int s : free_slots)
+				randomize(s);
+
+		for (auto &task : tasks)
+		{
+			if (task.op == OP_EVAL) {
+				eval_cell(task.cell);
+				continue;
+			}
+
+			uint64_t *va = &value[task.a*num_words], *ka = &known[task.a*num_words];
+			uint64_t *vb = &value[task.b*num_words], *kb = &known[task.b*num_words];
+			uint64_t *vs = &value[task.s*num_words], *ks = &known[task.s*num_words];
+			uint64_t *vy = &value[task.y*num_words], *ky = &known[task.y*num_words];
+
+			for (int w = 0; w < num_words; w++)
+			{
+				switch (task.op) {
+					case OP_BUF:    vy[w] = va[w];            ky[w] = ka[w]; break;
+					case OP_NOT:    vy[w] = ~va[w];           ky[w] = ka[w]; break;
+					case OP_AND:    vy[w] = va[w] & vb[w];    ky[w] = ka[w] & kb[w]; break;
+					case OP_NAND:   vy[w] = ~(va[w] & vb[w]); ky[w] = ka[w] & kb[w]; break;
+					case OP_OR:     vy[w] = va[w] | vb[w];    ky[w] = ka[w] & kb[w]; break;
+					case OP_NOR:    vy[w] = ~(va[w] | vb[w]); ky[w] = ka[w] & kb[w]; break;
+					case OP_XOR:    vy[w] = va[w] ^ vb[w];    ky[w] = ka[w] & kb[w]; break;
+					case OP_XNOR:   vy[w] = ~(va[w] ^ vb[w]); ky[w] = ka[w] & kb[w]; break;
+					case OP_ANDNOT: vy[w] = va[w] & ~vb[w];   ky[w] = ka[w] & kb[w]; break;
+					case OP_ORNOT:  vy[w] = va[w] | ~vb[w];   ky[w] = ka[w] & kb[w]; break;
+					case OP_MUX:    vy[w] = (vs[w] & vb[w]) | (~vs[w] & va[w]);    ky[w] = ka[w] & kb[w] & ks[w]; break;
+					case OP_NMUX:   vy[w] = ~((vs[w] & vb[w]) | (~vs[w] & va[w])); ky[w] = ka[w] & kb[w] & ks[w]; break;
+					default: log_abort();
+				}
+			}
+		}
+	}
+
+	// Evaluates a cell pattern by pattern. Outputs are unknown in every pattern
+	// in which an input is unknown.
+	void eval_cell(RTLIL::Cell *cell)
+	{
+		std::vector<RTLIL::SigSpec> inputs, outputs;
+		std::vector<std::vector<int>> input_slots, output_slots;
+
+		for (auto &conn : cell->connections()) {
+			if (!yosys_celltypes.cell_output(cell->type, conn.first)) {
+				RTLIL::SigSpec sig;
+				std::vector<int> slots;
+				for (auto bit : sigmap(conn.second))
+					if (bit.wire != nullptr) {
+						sig.append(bit);
+						slots.push_back(slot(bit));
+					}
+				inputs.push_back(sig);
+				input_slots.push_back(slots);
+			} else {
+				RTLIL::SigSpec sig = sigmap(conn.second);
+				std::vector<int> slots;
+				for (auto bit : sig)
+					slots.push_back(bit.wire ? slot(bit) : slot_sink);
+				outputs.push_back(sig);
+				output_slots.push_back(slots);
+			}
+		}
+
+		for (auto &slots : output_slots)
+			for (int s : slots)
+				for (int w = 0; w < num_words; w++)
+					known[s*num_words + w] = 0;
+
+		for (int p = 0; p < 64*num_words; p++)
+		{
+			int w = p / 64;
+			uint64_t mask = uint64_t(1) << (p % 64);
+
+			bool inputs_known = true;
+			for (auto &slots : input_slots)
+				for (int s : slots)
+					if ((known[s*num_words + w] & mask) == 0)
+						inputs_known = false;
+			if (!inputs_known)
+				continue;
+
+			ce.push();
+			for (int i = 0; i < GetSize(inputs); i++) {
+				RTLIL::Const val;
+				for (int s : input_slots[i])
+					val.bits.push_back((value[s*num_words + w] & mask) ? RTLIL::State::S1 : RTLIL::State::S0);
+				if (!inputs[i].empty())
+					ce.set(inputs[i], val);
+			}
+
+			RTLIL::SigSpec undef;
+			if (ce.eval(cell, undef))
+				for (int i = 0; i < GetSize(outputs); i++) {
+					RTLIL::SigSpec sig = outputs[i];
+					ce.values_map.apply(sig);
+					for (int j = 0; j < GetSize(sig); j++) {
+						int s = output_slots[i][j];
+						if (sig[j] == RTLIL::State::S0 || sig[j] == RTLIL::State::S1) {
+							known[s*num_words + w] |= mask;
+							if (sig[j] == RTLIL::State::S1)
+								value[s*num_words + w] |= mask;
+							else
+								value[s*num_words + w] &= ~mask;
+						}
+					}
+				}
+			ce.pop();
+		}
+	}
+
+	// Advances the flip-flops to the next cycle.
+	void step()
+	{
+		std::vector<uint64_t> next_value, next_known;
+		for (int d : ff_d)
+			for (int w = 0; w < num_words; w++) {
+				next_value.push_back(value[d*num_words + w]);
+				next_known.push_back(known[d*num_words + w]);
+			}
+		for (int i = 0; i < GetSize(ff_q); i++)
+			for (int w = 0; w < num_words; w++) {
+				value[ff_q[i]*num_words + w] = next_value[i*num_words + w];
+				known[ff_q[i]*num_words + w] = next_known[i*num_words + w];
+			}
+	}
+
+	// Patterns in which both bits are known and different.
+	uint64_t differ(RTLIL::SigBit a, RTLIL::SigBit b, int word)
+	{
+		int sa = slot(sigmap(a)), sb = slot(sigmap(b));
+		return known[sa*num_words + word] & known[sb*num_words + word] & (value[sa*num_words + word] ^ value[sb*num_words + word]);
+	}
+
+	// Patterns in which both bits are known and equal.
+	uint64_t agree(RTLIL::SigBit a, RTLIL::SigBit b, int word)
+	{
+		int sa = slot(sigmap(a)), sb = slot(sigmap(b));
+		return known[sa*num_words + word] & known[sb*num_words + word] & ~(value[sa*num_words + word] ^ value[sb*num_words + word]);
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
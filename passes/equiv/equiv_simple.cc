@@ -19,33 +19,19 @@
 
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
+#include "passes/equiv/equiv_sim.h"
+#include <chrono>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-struct EquivSimpleWorker
+struct EquivSimpleCones
 {
-	Module *module;
-	const vector<Cell*> &equiv_cells;
-	Cell *equiv_cell;
-
 	SigMap &sigmap;
 	dict<SigBit, Cell*> &bit2driver;
 
-	ezSatPtr ez;
-	SatGen satgen;
-	int max_seq;
-	bool short_cones;
-	bool verbose;
-
-	pool<pair<Cell*, int>> imported_cells_cache;
-
-	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
-			module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
-			sigmap(sigmap), bit2driver(bit2driver), satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
-	{
-		satgen.model_undef = model_undef;
-	}
+	EquivSimpleCones(SigMap &sigmap, dict<SigBit, Cell*> &bit2driver) : sigmap(sigmap), bit2driver(bit2driver) { }
 
 	bool find_input_cone(pool<SigBit> &next_seed, pool<Cell*> &cells_cone, pool<SigBit> &bits_cone, const pool<Cell*> &cells_stop, const pool<SigBit> &bits_stop, pool<SigBit> *input_bits, Cell *cell)
 	{
@@ -87,12 +73,66 @@ struct EquivSimpleWorker
 		if (find_input_cone(next_seed, cells_cone, bits_cone, cells_stop, bits_stop, input_bits, bit2driver.at(bit)))
 			if (input_bits != nullptr) input_bits->insert(bit);
 	}
+};
+
+// Proves the $equiv cells of one group, one cell after the other, on a single
+// incremental SAT instance. Each cell is a sequence of SAT problems with growing
+// sequence length. prepare() and finish() run on the main thread and do all the
+// work that touches the design, solve() only uses the private SAT instance and
+// can run on a worker thread. Proven cells are only marked as proven after all
+// groups are done and the log output of each group is printed in group order,
+// so that neither depends on the order in which the groups are processed.
+struct EquivSimpleWorker : EquivSimpleCones
+{
+	Module *module;
+	const vector<Cell*> &equiv_cells;
+	Cell *equiv_cell;
+
+	ezSatPtr ez;
+	SatGen satgen;
+	int max_seq;
+	bool short_cones;
+	bool verbose;
+
+	pool<pair<Cell*, int>> imported_cells_cache;
+
+	std::string log_buffer;
+	int cell_index = 0;
+	bool cell_started = false;
+	SigBit bit_a, bit_b;
+	pool<SigBit> seed_a, seed_b;
+	int ez_context = 0;
+	int step = 0;
+	bool last_result = false;
+	bool skip_solve = false;
+
+	// sequence length of the longest counterexample found by simulation
+	const dict<Cell*, int> *sim_cex_depth = nullptr;
+
+	vector<Cell*> proven_cells;
+	int sat_calls = 0;
+	int skipped_sat_calls = 0;
+	double solver_time = 0;
+
+	EquivSimpleWorker(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_seq, bool short_cones, bool verbose, bool model_undef) :
+			EquivSimpleCones(sigmap, bit2driver), module(equiv_cells.front()->module), equiv_cells(equiv_cells), equiv_cell(nullptr),
+			satgen(ez.get(), &sigmap), max_seq(max_seq), short_cones(short_cones), verbose(verbose)
+	{
+		satgen.model_undef = model_undef;
+
+		if (GetSize(equiv_cells) > 1) {
+			SigSpec sig;
+			for (auto c : equiv_cells)
+				sig.append(sigmap(c->getPort("\\Y")));
+			log_buffer += stringf(" Grouping SAT models for %s:\n", log_signal(sig));
+		}
+	}
 
-	bool run_cell()
+	void start_cell()
 	{
-		SigBit bit_a = sigmap(equiv_cell->getPort("\\A")).as_bit();
-		SigBit bit_b = sigmap(equiv_cell->getPort("\\B")).as_bit();
-		int ez_context = ez->frozen_literal();
+		bit_a = sigmap(equiv_cell->getPort("\\A")).as_bit();
+		bit_b = sigmap(equiv_cell->getPort("\\B")).as_bit();
+		ez_context = ez->frozen_literal();
 
 		if (satgen.model_undef)
 		{
@@ -110,166 +150,251 @@ struct EquivSimpleWorker
 			ez->assume(ez->XOR(ez_a, ez_b), ez_context);
 		}
 
-		pool<SigBit> seed_a = { bit_a };
-		pool<SigBit> seed_b = { bit_b };
+		seed_a = { bit_a };
+		seed_b = { bit_b };
 
 		if (verbose) {
-			log("  Trying to prove $equiv cell %s:\n", log_id(equiv_cell));
-			log("    A = %s, B = %s, Y = %s\n", log_signal(bit_a), log_signal(bit_b), log_signal(equiv_cell->getPort("\\Y")));
+			log_buffer += stringf("  Trying to prove $equiv cell %s:\n", log_id(equiv_cell));
+			log_buffer += stringf("    A = %s, B = %s, Y = %s\n", log_signal(bit_a), log_signal(bit_b), log_signal(equiv_cell->getPort("\\Y")));
 		} else {
-			log("  Trying to prove $equiv for %s:", log_signal(equiv_cell->getPort("\\Y")));
+			log_buffer += stringf("  Trying to prove $equiv for %s:", log_signal(equiv_cell->getPort("\\Y")));
 		}
 
-		int step = max_seq;
-		while (1)
-		{
-			pool<Cell*> no_stop_cells;
-			pool<SigBit> no_stop_bits;
+		step = max_seq;
+	}
+
+	// Adds the cones for the current time step to the problem.
+	void prepare_step()
+	{
+		pool<Cell*> no_stop_cells;
+		pool<SigBit> no_stop_bits;
+
+		pool<Cell*> full_cells_cone_a, full_cells_cone_b;
+		pool<SigBit> full_bits_cone_a, full_bits_cone_b;
 
-			pool<Cell*> full_cells_cone_a, full_cells_cone_b;
-			pool<SigBit> full_bits_cone_a, full_bits_cone_b;
+		pool<SigBit> next_seed_a, next_seed_b;
 
-			pool<SigBit> next_seed_a, next_seed_b;
+		for (auto bit_a : seed_a)
+			find_input_cone(next_seed_a, full_cells_cone_a, full_bits_cone_a, no_stop_cells, no_stop_bits, nullptr, bit_a);
+		next_seed_a.clear();
 
+		for (auto bit_b : seed_b)
+			find_input_cone(next_seed_b, full_cells_cone_b, full_bits_cone_b, no_stop_cells, no_stop_bits, nullptr, bit_b);
+		next_seed_b.clear();
+
+		pool<Cell*> short_cells_cone_a, short_cells_cone_b;
+		pool<SigBit> short_bits_cone_a, short_bits_cone_b;
+		pool<SigBit> input_bits;
+
+		if (short_cones)
+		{
 			for (auto bit_a : seed_a)
-				find_input_cone(next_seed_a, full_cells_cone_a, full_bits_cone_a, no_stop_cells, no_stop_bits, nullptr, bit_a);
-			next_seed_a.clear();
+				find_input_cone(next_seed_a, short_cells_cone_a, short_bits_cone_a, full_cells_cone_b, full_bits_cone_b, &input_bits, bit_a);
+			next_seed_a.swap(seed_a);
 
 			for (auto bit_b : seed_b)
-				find_input_cone(next_seed_b, full_cells_cone_b, full_bits_cone_b, no_stop_cells, no_stop_bits, nullptr, bit_b);
-			next_seed_b.clear();
-
-			pool<Cell*> short_cells_cone_a, short_cells_cone_b;
-			pool<SigBit> short_bits_cone_a, short_bits_cone_b;
-			pool<SigBit> input_bits;
+				find_input_cone(next_seed_b, short_cells_cone_b, short_bits_cone_b, full_cells_cone_a, full_bits_cone_a, &input_bits, bit_b);
+			next_seed_b.swap(seed_b);
+		}
+		else
+		{
+			short_cells_cone_a = full_cells_cone_a;
+			short_bits_cone_a = full_bits_cone_a;
+			next_seed_a.swap(seed_a);
 
-			if (short_cones)
-			{
-				for (auto bit_a : seed_a)
-					find_input_cone(next_seed_a, short_cells_cone_a, short_bits_cone_a, full_cells_cone_b, full_bits_cone_b, &input_bits, bit_a);
-				next_seed_a.swap(seed_a);
+			short_cells_cone_b = full_cells_cone_b;
+			short_bits_cone_b = full_bits_cone_b;
+			next_seed_b.swap(seed_b);
+		}
 
-				for (auto bit_b : seed_b)
-					find_input_cone(next_seed_b, short_cells_cone_b, short_bits_cone_b, full_cells_cone_a, full_bits_cone_a, &input_bits, bit_b);
-				next_seed_b.swap(seed_b);
-			}
-			else
-			{
-				short_cells_cone_a = full_cells_cone_a;
-				short_bits_cone_a = full_bits_cone_a;
-				next_seed_a.swap(seed_a);
+		pool<Cell*> problem_cells;
+		problem_cells.insert(short_cells_cone_a.begin(), short_cells_cone_a.end());
+		problem_cells.insert(short_cells_cone_b.begin(), short_cells_cone_b.end());
 
-				short_cells_cone_b = full_cells_cone_b;
-				short_bits_cone_b = full_bits_cone_b;
-				next_seed_b.swap(seed_b);
-			}
+		if (verbose)
+		{
+			log_buffer += stringf("    Adding %d new cells to the problem (%d A, %d B, %d shared).\n",
+					GetSize(problem_cells), GetSize(short_cells_cone_a), GetSize(short_cells_cone_b),
+					(GetSize(short_cells_cone_a) + GetSize(short_cells_cone_b)) - GetSize(problem_cells));
+		#if 0
+			for (auto cell : short_cells_cone_a)
+				log_buffer += stringf("      A-side cell: %s\n", log_id(cell));
+
+			for (auto cell : short_cells_cone_b)
+				log_buffer += stringf("      B-side cell: %s\n", log_id(cell));
+		#endif
+		}
 
-			pool<Cell*> problem_cells;
-			problem_cells.insert(short_cells_cone_a.begin(), short_cells_cone_a.end());
-			problem_cells.insert(short_cells_cone_b.begin(), short_cells_cone_b.end());
+		for (auto cell : problem_cells) {
+			auto key = pair<Cell*, int>(cell, step+1);
+			if (!imported_cells_cache.count(key) && !satgen.importCell(cell, step+1))
+				log_cmd_error("No SAT model available for cell %s (%s).\n", log_id(cell), log_id(cell->type));
+			imported_cells_cache.insert(key);
+		}
 
-			if (verbose)
-			{
-				log("    Adding %d new cells to the problem (%d A, %d B, %d shared).\n",
-						GetSize(problem_cells), GetSize(short_cells_cone_a), GetSize(short_cells_cone_b),
-						(GetSize(short_cells_cone_a) + GetSize(short_cells_cone_b)) - GetSize(problem_cells));
-			#if 0
-				for (auto cell : short_cells_cone_a)
-					log("      A-side cell: %s\n", log_id(cell));
-
-				for (auto cell : short_cells_cone_b)
-					log("      B-side cell: %s\n", log_id(cell));
-			#endif
-			}
+		if (satgen.model_undef) {
+			for (auto bit : input_bits)
+				ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step+1)));
+		}
 
-			for (auto cell : problem_cells) {
-				auto key = pair<Cell*, int>(cell, step+1);
-				if (!imported_cells_cache.count(key) && !satgen.importCell(cell, step+1))
-					log_cmd_error("No SAT model available for cell %s (%s).\n", log_id(cell), log_id(cell->type));
-				imported_cells_cache.insert(key);
-			}
+		if (verbose)
+			log_buffer += stringf("    Problem size at t=%d: %d literals, %d clauses\n", step, ez->numCnfVariables(), ez->numCnfClauses());
+	}
 
-			if (satgen.model_undef) {
-				for (auto bit : input_bits)
-					ez->assume(ez->NOT(satgen.importUndefSigBit(bit, step+1)));
-			}
+	// Returns true when the current cell is done, either proven or failed.
+	bool finish_step()
+	{
+		if (!last_result) {
+			log_buffer += verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n";
+			ez->assume(ez->NOT(ez_context));
+			proven_cells.push_back(equiv_cell);
+			return true;
+		}
 
-			if (verbose)
-				log("    Problem size at t=%d: %d literals, %d clauses\n", step, ez->numCnfVariables(), ez->numCnfClauses());
+		if (verbose)
+			log_buffer += stringf("    Failed to prove equivalence with sequence length %d.\n", max_seq - step);
 
-			if (!ez->solve(ez_context)) {
-				log(verbose ? "    Proved equivalence! Marking $equiv cell as proven.\n" : " success!\n");
-				equiv_cell->setPort("\\B", equiv_cell->getPort("\\A"));
-				ez->assume(ez->NOT(ez_context));
-				return true;
-			}
+		bool failed = false;
 
+		if (--step < 0) {
+			if (verbose)
+				log_buffer += "    Reached sequence limit.\n";
+			failed = true;
+		} else if (seed_a.empty() && seed_b.empty()) {
+			if (verbose)
+				log_buffer += "    No nets to continue in previous time step.\n";
+			failed = true;
+		} else if (seed_a.empty()) {
+			if (verbose)
+				log_buffer += "    No nets on A-side to continue in previous time step.\n";
+			failed = true;
+		} else if (seed_b.empty()) {
 			if (verbose)
-				log("    Failed to prove equivalence with sequence length %d.\n", max_seq - step);
+				log_buffer += "    No nets on B-side to continue in previous time step.\n";
+			failed = true;
+		}
 
-			if (--step < 0) {
-				if (verbose)
-					log("    Reached sequence limit.\n");
-				break;
-			}
+		if (failed) {
+			if (!verbose)
+				log_buffer += " failed.\n";
+			ez->assume(ez->NOT(ez_context));
+			return true;
+		}
 
-			if (seed_a.empty() && seed_b.empty()) {
-				if (verbose)
-					log("    No nets to continue in previous time step.\n");
-				break;
-			}
+		if (verbose) {
+		#if 0
+			log_buffer += "    Continuing analysis in previous time step with the following nets:\n";
+			for (auto bit : seed_a)
+				log_buffer += stringf("      A: %s\n", log_signal(bit));
+			for (auto bit : seed_b)
+				log_buffer += stringf("      B: %s\n", log_signal(bit));
+		#else
+			log_buffer += stringf("    Continuing analysis in previous time step with %d A- and %d B-nets.\n", GetSize(seed_a), GetSize(seed_b));
+		#endif
+		}
 
-			if (seed_a.empty()) {
-				if (verbose)
-					log("    No nets on A-side to continue in previous time step.\n");
-				break;
-			}
+		return false;
+	}
 
-			if (seed_b.empty()) {
+	// Sets up the next SAT problem. Returns false when all cells are done.
+	bool prepare()
+	{
+		if (!cell_started) {
+			if (cell_index == GetSize(equiv_cells)) {
+				if (GetSize(equiv_cells) > 1 || verbose)
+					log_buffer += stringf("  Proved %d of %d $equiv cells in this group (%d SAT calls, %.3f seconds).\n",
+							GetSize(proven_cells), GetSize(equiv_cells), sat_calls, solver_time);
+				return false;
+			}
+			equiv_cell = equiv_cells[cell_index];
+			cell_started = true;
+			start_cell();
+		}
+		prepare_step();
+
+		// A counterexample of the same or a greater sequence length is also a
+		// model for this SAT problem.
+		skip_solve = false;
+		if (sim_cex_depth != nullptr) {
+			auto it = sim_cex_depth->find(equiv_cell);
+			if (it != sim_cex_depth->end() && it->second >= max_seq - step) {
 				if (verbose)
-					log("    No nets on B-side to continue in previous time step.\n");
-				break;
+					log_buffer += "    Skipping SAT call, simulation found a counterexample.\n";
+				skip_solve = true;
 			}
+		}
+		return true;
+	}
 
-			if (verbose) {
-			#if 0
-				log("    Continuing analysis in previous time step with the following nets:\n");
-				for (auto bit : seed_a)
-					log("      A: %s\n", log_signal(bit));
-				for (auto bit : seed_b)
-					log("      B: %s\n", log_signal(bit));
-			#else
-				log("    Continuing analysis in previous time step with %d A- and %d B-nets.\n", GetSize(seed_a), GetSize(seed_b));
-			#endif
-			}
+	// Must not touch anything but the SAT instance, may run on a worker thread.
+	void solve()
+	{
+		if (skip_solve) {
+			last_result = true;
+			skipped_sat_calls++;
+			return;
 		}
 
-		if (!verbose)
-			log(" failed.\n");
+		auto start_time = std::chrono::steady_clock::now();
+		last_result = ez->solve(ez_context);
+		solver_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		sat_calls++;
+	}
 
-		ez->assume(ez->NOT(ez_context));
-		return false;
+	void finish()
+	{
+		if (finish_step()) {
+			cell_started = false;
+			cell_index++;
+		}
 	}
+};
 
-	int run()
+// Groups $equiv cells with overlapping input cones, so that the logic they
+// share is only encoded once. Every cell joins the group that already covers
+// most of its combinational input cone, if that is at least half of the cone.
+vector<vector<Cell*>> group_equiv_cells(const vector<Cell*> &equiv_cells, SigMap &sigmap, dict<SigBit, Cell*> &bit2driver, int max_group_size)
+{
+	EquivSimpleCones cones(sigmap, bit2driver);
+	vector<vector<Cell*>> groups;
+	dict<Cell*, int> cone_owner;
+
+	for (auto cell : equiv_cells)
 	{
-		if (GetSize(equiv_cells) > 1) {
-			SigSpec sig;
-			for (auto c : equiv_cells)
-				sig.append(sigmap(c->getPort("\\Y")));
-			log(" Grouping SAT models for %s:\n", log_signal(sig));
+		pool<SigBit> next_seed, bits_cone, no_stop_bits;
+		pool<Cell*> cells_cone, no_stop_cells;
+
+		cones.find_input_cone(next_seed, cells_cone, bits_cone, no_stop_cells, no_stop_bits, nullptr, sigmap(cell->getPort("\\A")).as_bit());
+		cones.find_input_cone(next_seed, cells_cone, bits_cone, no_stop_cells, no_stop_bits, nullptr, sigmap(cell->getPort("\\B")).as_bit());
+
+		dict<int, int> overlap;
+		for (auto c : cells_cone) {
+			auto it = cone_owner.find(c);
+			if (it != cone_owner.end())
+				overlap[it->second]++;
 		}
 
-		int counter = 0;
-		for (auto c : equiv_cells) {
-			equiv_cell = c;
-			if (run_cell())
-				counter++;
+		int best_group = -1, best_overlap = 0;
+		for (auto &it : overlap)
+			if (GetSize(groups[it.first]) < max_group_size && (it.second > best_overlap ||
+					(it.second == best_overlap && it.first < best_group))) {
+				best_group = it.first;
+				best_overlap = it.second;
+			}
+
+		if (best_group < 0 || 2*best_overlap < GetSize(cells_cone)) {
+			best_group = GetSize(groups);
+			groups.push_back(vector<Cell*>());
 		}
-		return counter;
+
+		groups[best_group].push_back(cell);
+		for (auto c : cells_cone)
+			if (!cone_owner.count(c))
+				cone_owner[c] = best_group;
 	}
 
-};
+	return groups;
+}
 
 struct EquivSimplePass : public Pass {
 	EquivSimplePass() : Pass("equiv_simple", "try proving simple $equiv instances") { }
@@ -292,17 +417,29 @@ struct EquivSimplePass : public Pass {
 		log("        simpler SAT problems but sometimes fails to prove equivalence.\n");
 		log("\n");
 		log("    -nogroup\n");
-		log("        disabling grouping of $equiv cells by output wire\n");
+		log("        disable grouping of $equiv cells. by default $equiv cells with\n");
+		log("        overlapping input cones share one incremental SAT instance.\n");
+		log("\n");
+		log("    -threads <N>\n");
+		log("        prove independent groups of $equiv cells on N threads. N may be zero\n");
+		log("        to use all available cores. (default = 1) the result does not depend\n");
+		log("        on the number of threads.\n");
 		log("\n");
 		log("    -seq <N>\n");
 		log("        the max. number of time steps to be considered (default = 1)\n");
 		log("\n");
+		log("    -sim <N>\n");
+		log("        simulate the module with N random input patterns before calling the\n");
+		log("        SAT solver, and skip the SAT calls for which the simulation already\n");
+		log("        found a counterexample. this does not change the result.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, Design *design) YS_OVERRIDE
 	{
 		bool verbose = false, short_cones = false, model_undef = false, nogroup = false;
-		int success_counter = 0;
-		int max_seq = 1;
+		int success_counter = 0, sat_calls = 0, skipped_sat_calls = 0;
+		int max_seq = 1, num_threads = 1, sim_patterns = 0;
+		double solver_time = 0;
 
 		log_header(design, "Executing EQUIV_SIMPLE pass.\n");
 
@@ -328,6 +465,14 @@ struct EquivSimplePass : public Pass {
 				max_seq = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_patterns = atoi(args[++argidx].c_str());
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -340,25 +485,16 @@ struct EquivSimplePass : public Pass {
 		{
 			SigMap sigmap(module);
 			dict<SigBit, Cell*> bit2driver;
-			dict<SigBit, dict<SigBit, Cell*>> unproven_equiv_cells;
-			int unproven_cells_counter = 0;
+			dict<SigBit, Cell*> unproven_equiv_cells;
 
 			for (auto cell : module->selected_cells())
-				if (cell->type == "$equiv" && cell->getPort("\\A") != cell->getPort("\\B")) {
-					auto bit = sigmap(cell->getPort("\\Y").as_bit());
-					auto bit_group = bit;
-					if (!nogroup && bit_group.wire)
-						bit_group.offset = 0;
-					unproven_equiv_cells[bit_group][bit] = cell;
-					unproven_cells_counter++;
-				}
+				if (cell->type == "$equiv" && cell->getPort("\\A") != cell->getPort("\\B"))
+					unproven_equiv_cells[sigmap(cell->getPort("\\Y").as_bit())] = cell;
 
 			if (unproven_equiv_cells.empty())
 				continue;
 
-			log("Found %d unproven $equiv cells (%d groups) in %s:\n",
-					unproven_cells_counter, GetSize(unproven_equiv_cells), log_id(module));
-
+			vector<Cell*> model_cells;
 			for (auto cell : module->cells()) {
 				if (!ct.cell_known(cell->type) && !cell->type.in("$dff", "$_DFF_P_", "$_DFF_N_", "$ff", "$_FF_"))
 					continue;
@@ -366,22 +502,107 @@ struct EquivSimplePass : public Pass {
 					if (yosys_celltypes.cell_output(cell->type, conn.first))
 						for (auto bit : sigmap(conn.second))
 							bit2driver[bit] = cell;
+				model_cells.push_back(cell);
 			}
 
 			unproven_equiv_cells.sort();
+			vector<Cell*> equiv_cells;
 			for (auto it : unproven_equiv_cells)
+				equiv_cells.push_back(it.second);
+
+			vector<vector<Cell*>> groups;
+			if (nogroup) {
+				for (auto cell : equiv_cells)
+					groups.push_back(vector<Cell*>{cell});
+			} else
+				groups = group_equiv_cells(equiv_cells, sigmap, bit2driver, 64);
+
+			log("Found %d unproven $equiv cells (%d groups) in %s:\n",
+					GetSize(equiv_cells), GetSize(groups), log_id(module));
+
+			// Simulate max_seq+1 cycles from a random state. A difference in cycle
+			// t is a counterexample for all SAT problems with up to t time steps.
+			dict<Cell*, int> sim_cex_depth;
+			if (sim_patterns > 0)
 			{
-				it.second.sort();
+				EquivSimulator sim(module, sigmap, model_cells, sim_patterns);
+				if (sim.usable) {
+					sim.random_state();
+					for (int t = 0; t <= max_seq; t++) {
+						if (t > 0)
+							sim.step();
+						sim.eval();
+						for (auto cell : equiv_cells)
+							for (int w = 0; w < sim.num_words; w++)
+								if (sim.differ(cell->getPort("\\A").as_bit(), cell->getPort("\\B").as_bit(), w)) {
+									sim_cex_depth[cell] = t;
+									break;
+								}
+					}
+					log("Simulation of %d patterns found counterexamples for %d $equiv cells.\n",
+							64*sim.num_words, GetSize(sim_cex_depth));
+				} else
+					log("Skipping simulation: %s has combinational loops or conflicting drivers.\n", log_id(module));
+			}
 
-				vector<Cell*> cells;
-				for (auto it2 : it.second)
-					cells.push_back(it2.second);
+			// Groups advance in lockstep: the next SAT problem of every active
+			// group is set up on the main thread, then all of them are solved in
+			// parallel. Only a few groups are active at a time to limit the number
+			// of SAT instances in memory.
+			vector<std::string> group_logs(GetSize(groups));
+			vector<Cell*> proven_cells;
+			vector<pair<int, std::unique_ptr<EquivSimpleWorker>>> active;
+			int next_group = 0;
 
-				EquivSimpleWorker worker(cells, sigmap, bit2driver, max_seq, short_cones, verbose, model_undef);
-				success_counter += worker.run();
+			while (1)
+			{
+				while (GetSize(active) < 2*num_threads && next_group < GetSize(groups)) {
+					active.emplace_back(next_group, std::unique_ptr<EquivSimpleWorker>(new EquivSimpleWorker(groups[next_group],
+							sigmap, bit2driver, max_seq, short_cones, verbose, model_undef)));
+					active.back().second->sim_cex_depth = sim_patterns > 0 ? &sim_cex_depth : nullptr;
+					next_group++;
+				}
+
+				if (active.empty())
+					break;
+
+				vector<EquivSimpleWorker*> pending;
+				vector<pair<int, std::unique_ptr<EquivSimpleWorker>>> still_active;
+
+				for (auto &it : active) {
+					EquivSimpleWorker *worker = it.second.get();
+					if (worker->prepare()) {
+						pending.push_back(worker);
+						still_active.push_back(std::move(it));
+						continue;
+					}
+					group_logs[it.first] = worker->log_buffer;
+					proven_cells.insert(proven_cells.end(), worker->proven_cells.begin(), worker->proven_cells.end());
+					sat_calls += worker->sat_calls;
+					skipped_sat_calls += worker->skipped_sat_calls;
+					solver_time += worker->solver_time;
+				}
+
+				parallel_for(num_threads, GetSize(pending), [&](int i) {
+					pending[i]->solve();
+				});
+
+				for (auto worker : pending)
+					worker->finish();
+				active.swap(still_active);
 			}
+
+			for (auto &str : group_logs)
+				log("%s", str.c_str());
+
+			for (auto cell : proven_cells)
+				cell->setPort("\\B", cell->getPort("\\A"));
+			success_counter += GetSize(proven_cells);
 		}
 
+		log("Solved %d SAT problems in %.3f seconds.\n", sat_calls, solver_time);
+		if (sim_patterns > 0)
+			log("Simulation saved %d SAT calls.\n", skipped_sat_calls);
 		log("Proved %d previously unproven $equiv cells.\n", success_counter);
 	}
 } EquivSimplePass;
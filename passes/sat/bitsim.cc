@@ -0,0 +1,508 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+enum class bitsim_op_t {
+	BUF, NOT, AND, NAND, OR, NOR, XOR, XNOR, ANDNOT, ORNOT, MUX, NMUX, AOI3, OAI3, AOI4, OAI4
+};
+
+struct BitsimGate
+{
+	bitsim_op_t op;
+	int a, b, c, d, y;
+};
+
+struct BitsimFF
+{
+	Cell *cell;
+	int d, q, e;
+	bool en_pol;
+};
+
+struct BitsimWorker
+{
+	Module *module;
+	SigMap sigmap;
+
+	// Every net is a slot of num_words consecutive 64-bit words, one bit per
+	// pattern. Slots 0 and 1 are the constants 0 and 1.
+	int num_words;
+	dict<SigBit, int> slot_index;
+	std::vector<SigBit> slot_bits;
+	std::vector<uint64_t> values;
+
+	std::vector<BitsimGate> gates;
+	std::vector<BitsimFF> ffs;
+	std::vector<int> input_slots;
+	uint64_t rng_state;
+
+	BitsimWorker(Module *module, int num_words, uint64_t seed) : module(module), sigmap(module), num_words(num_words)
+	{
+		rng_state = seed ? seed : 88172645463325252ULL;
+		slot_bits.push_back(State::S0);
+		slot_bits.push_back(State::S1);
+	}
+
+	uint64_t rng()
+	{
+		rng_state ^= rng_state << 13;
+		rng_state ^= rng_state >> 7;
+		rng_state ^= rng_state << 17;
+		return rng_state;
+	}
+
+	int slot(SigBit bit)
+	{
+		bit = sigmap(bit);
+		if (bit.wire == nullptr)
+			return bit == State::S1 ? 1 : 0;
+		auto it = slot_index.find(bit);
+		if (it != slot_index.end())
+			return it->second;
+		int idx = GetSize(slot_bits);
+		slot_index[bit] = idx;
+		slot_bits.push_back(bit);
+		return idx;
+	}
+
+	uint64_t *word(int slot_idx)
+	{
+		return values.data() + size_t(slot_idx) * num_words;
+	}
+
+	void setup()
+	{
+		static dict<IdString, bitsim_op_t> gate_types = {
+			{ID($_BUF_), bitsim_op_t::BUF}, {ID($_NOT_), bitsim_op_t::NOT},
+			{ID($_AND_), bitsim_op_t::AND}, {ID($_NAND_), bitsim_op_t::NAND},
+			{ID($_OR_), bitsim_op_t::OR}, {ID($_NOR_), bitsim_op_t::NOR},
+			{ID($_XOR_), bitsim_op_t::XOR}, {ID($_XNOR_), bitsim_op_t::XNOR},
+			{ID($_ANDNOT_), bitsim_op_t::ANDNOT}, {ID($_ORNOT_), bitsim_op_t::ORNOT},
+			{ID($_MUX_), bitsim_op_t::MUX}, {ID($_NMUX_), bitsim_op_t::NMUX},
+			{ID($_AOI3_), bitsim_op_t::AOI3}, {ID($_OAI3_), bitsim_op_t::OAI3},
+			{ID($_AOI4_), bitsim_op_t::AOI4}, {ID($_OAI4_), bitsim_op_t::OAI4}
+		};
+
+		for (auto wire : module->wires())
+			if (wire->port_input)
+				for (auto bit : SigSpec(wire))
+					input_slots.push_back(slot(bit));
+
+		std::vector<BitsimGate> unordered_gates;
+
+		for (auto cell : module->cells())
+		{
+			auto it = gate_types.find(cell->type);
+			if (it != gate_types.end()) {
+				BitsimGate g;
+				g.op = it->second;
+				g.a = slot(cell->getPort(ID::A));
+				g.b = cell->hasPort(ID::B) ? slot(cell->getPort(ID::B)) : 0;
+				g.c = cell->hasPort(ID(C)) ? slot(cell->getPort(ID(C))) : 0;
+				g.d = cell->hasPort(ID(D)) ? slot(cell->getPort(ID(D))) : 0;
+				if (g.op == bitsim_op_t::MUX || g.op == bitsim_op_t::NMUX)
+					g.c = slot(cell->getPort(ID(S)));
+				g.y = slot(cell->getPort(ID::Y));
+				unordered_gates.push_back(g);
+				continue;
+			}
+
+			if (cell->type.in(ID($_DFF_P_), ID($_DFF_N_), ID($_DFFE_PP_), ID($_DFFE_PN_), ID($_DFFE_NP_), ID($_DFFE_NN_))) {
+				BitsimFF ff;
+				ff.cell = cell;
+				ff.d = slot(cell->getPort(ID(D)));
+				ff.q = slot(cell->getPort(ID(Q)));
+				ff.e = cell->hasPort(ID(E)) ? slot(cell->getPort(ID(E))) : -1;
+				ff.en_pol = cell->type.in(ID($_DFFE_PP_), ID($_DFFE_NP_));
+				ffs.push_back(ff);
+				continue;
+			}
+
+			log_error("Unsupported cell type %s (%s.%s). Run 'simplemap' and 'dffsr2dff' first.\n",
+					log_id(cell->type), log_id(module), log_id(cell));
+		}
+
+		// Levelize the gates. Inputs, constants and FF outputs are sources.
+		dict<int, int> driver;
+		for (int i = 0; i < GetSize(unordered_gates); i++)
+			driver[unordered_gates[i].y] = i;
+
+		std::vector<int> num_deps(GetSize(unordered_gates));
+		std::vector<std::vector<int>> users(GetSize(unordered_gates));
+		for (int i = 0; i < GetSize(unordered_gates); i++) {
+			const BitsimGate &g = unordered_gates[i];
+			for (int s : {g.a, g.b, g.c, g.d}) {
+				auto it = driver.find(s);
+				if (it != driver.end()) {
+					num_deps[i]++;
+					users[it->second].push_back(i);
+				}
+			}
+		}
+
+		std::vector<int> order;
+		for (int i = 0; i < GetSize(unordered_gates); i++)
+			if (num_deps[i] == 0)
+				order.push_back(i);
+		for (int k = 0; k < GetSize(order); k++)
+			for (int u : users[order[k]])
+				if (--num_deps[u] == 0)
+					order.push_back(u);
+
+		if (GetSize(order) != GetSize(unordered_gates))
+			log_error("Module %s contains a combinational loop.\n", log_id(module));
+
+		for (int i : order)
+			gates.push_back(unordered_gates[i]);
+
+		values.resize(size_t(GetSize(slot_bits)) * num_words);
+		for (int w = 0; w < num_words; w++)
+			word(1)[w] = ~uint64_t(0);
+
+		log("Simulating %d gates and %d FFs on %d nets with %d patterns.\n",
+				GetSize(gates), GetSize(ffs), GetSize(slot_bits), 64*num_words);
+	}
+
+	void init_ffs(bool random_init)
+	{
+		for (auto &ff : ffs)
+		{
+			SigBit q = sigmap(ff.cell->getPort(ID(Q)));
+			State init = State::Sx;
+			if (q.wire != nullptr && q.wire->attributes.count(ID(init))) {
+				Const initval = q.wire->attributes.at(ID(init));
+				if (q.offset < GetSize(initval))
+					init = initval[q.offset];
+			}
+
+			uint64_t *qv = word(ff.q);
+			for (int w = 0; w < num_words; w++)
+				qv[w] = init == State::S1 ? ~uint64_t(0) : init == State::S0 || !random_init ? 0 : rng();
+		}
+	}
+
+	void eval()
+	{
+		const int W = num_words;
+		for (auto &g : gates)
+		{
+			const uint64_t *a = word(g.a), *b = word(g.b), *c = word(g.c), *d = word(g.d);
+			uint64_t *y = word(g.y);
+
+			switch (g.op)
+			{
+			case bitsim_op_t::BUF:    for (int w = 0; w < W; w++) y[w] = a[w]; break;
+			case bitsim_op_t::NOT:    for (int w = 0; w < W; w++) y[w] = ~a[w]; break;
+			case bitsim_op_t::AND:    for (int w = 0; w < W; w++) y[w] = a[w] & b[w]; break;
+			case bitsim_op_t::NAND:   for (int w = 0; w < W; w++) y[w] = ~(a[w] & b[w]); break;
+			case bitsim_op_t::OR:     for (int w = 0; w < W; w++) y[w] = a[w] | b[w]; break;
+			case bitsim_op_t::NOR:    for (int w = 0; w < W; w++) y[w] = ~(a[w] | b[w]); break;
+			case bitsim_op_t::XOR:    for (int w = 0; w < W; w++) y[w] = a[w] ^ b[w]; break;
+			case bitsim_op_t::XNOR:   for (int w = 0; w < W; w++) y[w] = ~(a[w] ^ b[w]); break;
+			case bitsim_op_t::ANDNOT: for (int w = 0; w < W; w++) y[w] = a[w] & ~b[w]; break;
+			case bitsim_op_t::ORNOT:  for (int w = 0; w < W; w++) y[w] = a[w] | ~b[w]; break;
+			case bitsim_op_t::MUX:    for (int w = 0; w < W; w++) y[w] = (a[w] & ~c[w]) | (b[w] & c[w]); break;
+			case bitsim_op_t::NMUX:   for (int w = 0; w < W; w++) y[w] = ~((a[w] & ~c[w]) | (b[w] & c[w])); break;
+			case bitsim_op_t::AOI3:   for (int w = 0; w < W; w++) y[w] = ~((a[w] & b[w]) | c[w]); break;
+			case bitsim_op_t::OAI3:   for (int w = 0; w < W; w++) y[w] = ~((a[w] | b[w]) & c[w]); break;
+			case bitsim_op_t::AOI4:   for (int w = 0; w < W; w++) y[w] = ~((a[w] & b[w]) | (c[w] & d[w])); break;
+			case bitsim_op_t::OAI4:   for (int w = 0; w < W; w++) y[w] = ~((a[w] | b[w]) & (c[w] | d[w])); break;
+			}
+		}
+	}
+
+	void clock()
+	{
+		const int W = num_words;
+
+		// Sample all D inputs before updating any Q output.
+		std::vector<uint64_t> next(ffs.size() * W);
+		for (int i = 0; i < GetSize(ffs); i++) {
+			const BitsimFF &ff = ffs[i];
+			const uint64_t *d = word(ff.d), *q = word(ff.q);
+			uint64_t *n = next.data() + size_t(i) * W;
+			if (ff.e < 0) {
+				for (int w = 0; w < W; w++)
+					n[w] = d[w];
+			} else {
+				const uint64_t *e = word(ff.e);
+				for (int w = 0; w < W; w++) {
+					uint64_t en = ff.en_pol ? e[w] : ~e[w];
+					n[w] = (d[w] & en) | (q[w] & ~en);
+				}
+			}
+		}
+
+		for (int i = 0; i < GetSize(ffs); i++)
+			memcpy(word(ffs[i].q), next.data() + size_t(i) * W, W * sizeof(uint64_t));
+	}
+
+	void random_inputs()
+	{
+		for (int s : input_slots) {
+			uint64_t *v = word(s);
+			for (int w = 0; w < num_words; w++)
+				v[w] = rng();
+		}
+	}
+
+	// Each line of the stimulus file holds one pattern: a binary string with
+	// one character per input bit, MSB of the last input port first (i.e. the
+	// inputs concatenated like in a Verilog '{...}' expression in reverse
+	// declaration order). Consecutive lines fill pattern 0, 1, 2, ... of a cycle.
+	bool file_inputs(std::istream &f)
+	{
+		int num_inputs = GetSize(input_slots);
+		for (int s : input_slots)
+			memset(word(s), 0, num_words * sizeof(uint64_t));
+
+		for (int p = 0; p < 64*num_words; p++)
+		{
+			std::string line;
+			do {
+				if (!std::getline(f, line)) {
+					if (p > 0)
+						log_warning("Ignoring %d patterns of an incomplete cycle at the end of the stimulus file.\n", p);
+					return false;
+				}
+				line = line.substr(0, line.find('#'));
+				line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+			} while (line.empty());
+
+			if (GetSize(line) != num_inputs)
+				log_error("Stimulus line has %d bits, expected %d.\n", GetSize(line), num_inputs);
+
+			for (int i = 0; i < num_inputs; i++) {
+				char ch = line[num_inputs-1-i];
+				if (ch != '0' && ch != '1')
+					log_error("Invalid character '%c' in stimulus file.\n", ch);
+				if (ch == '1')
+					word(input_slots[i])[p / 64] |= uint64_t(1) << (p % 64);
+			}
+		}
+
+		return true;
+	}
+};
+
+struct BitsimPass : public Pass {
+	BitsimPass() : Pass("bitsim", "bit-parallel multi-pattern simulation") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    bitsim [options] [selection]\n");
+		log("\n");
+		log("This command simulates a gate-level module under many independent input\n");
+		log("patterns at once. Every net holds one bit per pattern in a vector of 64-bit\n");
+		log("words, so that each gate is evaluated for 64 patterns per word operation.\n");
+		log("\n");
+		log("Only fine-grained cells ($_AND_, $_XOR_, $_MUX_, ...) and $_DFF_[NP]_ and\n");
+		log("$_DFFE_[NP][NP]_ flip-flops are supported. The simulation is cycle based: all\n");
+		log("flip-flops are clocked once per cycle, regardless of their clock signal.\n");
+		log("\n");
+		log("The top module (or the single selected module) is simulated. The selection\n");
+		log("also determines which wires are written by -sig (default: all public wires).\n");
+		log("\n");
+		log("    -words <n>\n");
+		log("        simulate 64*n patterns in parallel (default: 4)\n");
+		log("\n");
+		log("    -n <cycles>\n");
+		log("        number of cycles to simulate (default: 1)\n");
+		log("\n");
+		log("    -seed <n>\n");
+		log("        seed for the random number generator\n");
+		log("\n");
+		log("    -stim <file>\n");
+		log("        read input patterns from the given file instead of using random\n");
+		log("        values. every line holds the values for all input bits of one\n");
+		log("        pattern as binary string, with the inputs concatenated in reverse\n");
+		log("        declaration order. the first 64*n lines are used for the first\n");
+		log("        cycle, the next 64*n lines for the second cycle, etc. if the file\n");
+		log("        ends early the simulation stops after the last complete cycle.\n");
+		log("\n");
+		log("    -rinit\n");
+		log("        randomly initialize flip-flops without init attribute (default:\n");
+		log("        initialize them with zero)\n");
+		log("\n");
+		log("    -sig <file>\n");
+		log("        write a signature for every selected wire bit to the given file:\n");
+		log("        the name of the bit followed by its values for all patterns in all\n");
+		log("        cycles as hex words (pattern 0 is the LSB of the first word).\n");
+		log("\n");
+		log("    -classes\n");
+		log("        group all nets by their signatures (modulo inversion) and report\n");
+		log("        the resulting candidate equivalence classes\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
+	{
+		int num_words = 4, num_cycles = 1;
+		uint64_t seed = 0;
+		bool random_init = false, classes = false;
+		std::string stim_file, sig_file;
+
+		log_header(design, "Executing BITSIM pass (bit-parallel multi-pattern simulation).\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			if (args[argidx] == "-words" && argidx+1 < args.size()) {
+				num_words = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-n" && argidx+1 < args.size()) {
+				num_cycles = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-seed" && argidx+1 < args.size()) {
+				seed = strtoull(args[++argidx].c_str(), nullptr, 0);
+				continue;
+			}
+			if (args[argidx] == "-stim" && argidx+1 < args.size()) {
+				stim_file = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-sig" && argidx+1 < args.size()) {
+				sig_file = args[++argidx];
+				continue;
+			}
+			if (args[argidx] == "-rinit") {
+				random_init = true;
+				continue;
+			}
+			if (args[argidx] == "-classes") {
+				classes = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (num_words < 1)
+			log_cmd_error("Invalid number of words: %d\n", num_words);
+
+		Module *top_mod = nullptr;
+		if (design->full_selection()) {
+			top_mod = design->top_module();
+			if (!top_mod)
+				log_cmd_error("Design has no top module, use the 'hierarchy' command to specify one.\n");
+		} else {
+			auto mods = design->selected_modules();
+			if (GetSize(mods) != 1)
+				log_cmd_error("Only one module must be selected.\n");
+			top_mod = mods.front();
+		}
+
+		BitsimWorker worker(top_mod, num_words, seed);
+
+		std::vector<SigBit> sig_bits;
+		for (auto wire : top_mod->selected_wires())
+			if (!design->full_selection() || wire->name[0] == '\\')
+				for (auto bit : SigSpec(wire)) {
+					sig_bits.push_back(bit);
+					worker.slot(bit);
+				}
+
+		worker.setup();
+		worker.init_ffs(random_init);
+
+		std::ifstream stim;
+		if (!stim_file.empty()) {
+			stim.open(stim_file);
+			if (stim.fail())
+				log_cmd_error("Can't open stimulus file `%s'.\n", stim_file.c_str());
+		}
+
+		// Signatures of all slots, one vector of words per slot (all cycles).
+		int num_slots = GetSize(worker.slot_bits);
+		std::vector<std::vector<uint64_t>> signatures(num_slots);
+
+		PerformanceTimer timer;
+		timer.begin();
+
+		int cycle;
+		for (cycle = 0; cycle < num_cycles; cycle++)
+		{
+			if (stim_file.empty())
+				worker.random_inputs();
+			else if (!worker.file_inputs(stim))
+				break;
+
+			worker.eval();
+
+			if (!sig_file.empty() || classes)
+				for (int s = 0; s < num_slots; s++)
+					signatures[s].insert(signatures[s].end(), worker.word(s), worker.word(s) + num_words);
+
+			worker.clock();
+		}
+
+		timer.end();
+		log("Simulated %d cycles of %d patterns in %.3f seconds (%.0f gate evaluations/s).\n",
+				cycle, 64*num_words, timer.sec(), timer.sec() > 0 ? 64.0 * num_words * cycle * GetSize(worker.gates) / timer.sec() : 0.0);
+
+		if (!sig_file.empty())
+		{
+			std::ofstream f(sig_file);
+			if (f.fail())
+				log_error("Can't open file `%s' for writing: %s\n", sig_file.c_str(), strerror(errno));
+			for (auto bit : sig_bits) {
+				f << log_signal(bit);
+				for (auto w : signatures[worker.slot(bit)])
+					f << stringf(" %016llx", (unsigned long long)w);
+				f << "\n";
+			}
+		}
+
+		if (classes)
+		{
+			// Normalize the polarity so that inverted nets end up in the same class.
+			std::map<std::vector<uint64_t>, std::vector<int>> class_map;
+			for (int s = 2; s < num_slots; s++) {
+				std::vector<uint64_t> sig = signatures[s];
+				if (!sig.empty() && (sig[0] & 1))
+					for (auto &w : sig)
+						w = ~w;
+				class_map[sig].push_back(s);
+			}
+
+			int num_classes = 0, num_members = 0;
+			for (auto &it : class_map) {
+				if (GetSize(it.second) < 2)
+					continue;
+				num_classes++;
+				num_members += GetSize(it.second);
+				log("  class %d:", num_classes);
+				for (int s : it.second) {
+					const std::vector<uint64_t> &sig = signatures[s];
+					log(" %s%s", !sig.empty() && (sig[0] & 1) ? "~" : "", log_signal(worker.slot_bits[s]));
+				}
+				log("\n");
+			}
+			log("Found %d candidate equivalence classes with %d nets in total.\n", num_classes, num_members);
+		}
+	}
+} BitsimPass;
+
+PRIVATE_NAMESPACE_END
@@ -23,6 +23,8 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
+#include "passes/equiv/equiv_sim.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -32,8 +34,8 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 bool inv_mode;
-int verbose_level, reduce_counter, reduce_stop_at;
-typedef std::map<RTLIL::SigBit, std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>>> drivers_t;
+int verbose_level, reduce_counter, reduce_stop_at, sim_patterns, num_threads;
+typedef dict<RTLIL::SigBit, std::pair<RTLIL::Cell*, pool<RTLIL::SigBit>>> drivers_t;
 std::string dump_prefix;
 
 struct equiv_bit_t
@@ -57,9 +59,9 @@ struct equiv_bit_t
 struct CountBitUsage
 {
 	SigMap &sigmap;
-	std::map<RTLIL::SigBit, int> &cache;
+	dict<RTLIL::SigBit, int> &cache;
 
-	CountBitUsage(SigMap &sigmap, std::map<RTLIL::SigBit, int> &cache) : sigmap(sigmap), cache(cache) { }
+	CountBitUsage(SigMap &sigmap, dict<RTLIL::SigBit, int> &cache) : sigmap(sigmap), cache(cache) { }
 
 	void operator()(RTLIL::SigSpec &sig) {
 		std::vector<RTLIL::SigBit> vec = sigmap(sig).to_sigbit_vector();
@@ -74,12 +76,24 @@ struct FindReducedInputs
 	drivers_t &drivers;
 
 	ezSatPtr ez;
-	std::set<RTLIL::Cell*> ez_cells;
+	pool<RTLIL::Cell*> ez_cells;
 	SatGen satgen;
 
-	std::map<RTLIL::SigBit, int> sat_pi;
+	dict<RTLIL::SigBit, int> sat_pi;
 	std::vector<int> sat_pi_uniq_bitvec;
 
+	struct query_t
+	{
+		RTLIL::SigBit output;
+		int perc;
+		std::vector<RTLIL::SigBit> pi;
+		pool<RTLIL::SigBit> sim_relevant;
+		int output_a, output_b, output_undef_a, output_undef_b;
+		std::vector<RTLIL::SigBit> reduced_inputs;
+	};
+
+	std::vector<query_t> queries;
+
 	FindReducedInputs(SigMap &sigmap, drivers_t &drivers) :
 			sigmap(sigmap), drivers(drivers), satgen(ez.get(), &sigmap)
 	{
@@ -130,7 +144,7 @@ struct FindReducedInputs
 				ez->assume(ez->OR(ez->NOT(sat_pi[bit]), sat_pi_uniq_bitvec[i]));
 	}
 
-	void register_cone_worker(std::set<RTLIL::SigBit> &pi, std::set<RTLIL::SigBit> &sigdone, RTLIL::SigBit out)
+	void register_cone_worker(pool<RTLIL::SigBit> &pi, pool<RTLIL::SigBit> &sigdone, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
 			return;
@@ -139,7 +153,7 @@ struct FindReducedInputs
 		sigdone.insert(out);
 
 		if (drivers.count(out) != 0) {
-			std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> &drv = drivers.at(out);
+			std::pair<RTLIL::Cell*, pool<RTLIL::SigBit>> &drv = drivers.at(out);
 			if (ez_cells.count(drv.first) == 0) {
 				satgen.setContext(&sigmap, "A");
 				if (!satgen.importCell(drv.first))
@@ -159,37 +173,92 @@ struct FindReducedInputs
 
 	void register_cone(std::vector<RTLIL::SigBit> &pi, RTLIL::SigBit out)
 	{
-		std::set<RTLIL::SigBit> pi_set, sigdone;
+		pool<RTLIL::SigBit> pi_set, sigdone;
 		register_cone_worker(pi_set, sigdone, out);
 		pi.clear();
 		pi.insert(pi.end(), pi_set.begin(), pi_set.end());
+		std::sort(pi.begin(), pi.end());
 	}
 
-	void analyze(std::vector<RTLIL::SigBit> &reduced_inputs, RTLIL::SigBit output, int prec)
+	// Imports the input cone of an output. All cones of a batch are imported
+	// (on the main thread) before any of them is solved.
+	void prepare(RTLIL::SigBit output, int perc)
 	{
-		if (verbose_level >= 1)
-			log("[%2d%%]  Analyzing input cone for signal %s:\n", prec, log_signal(output));
-
-		std::vector<RTLIL::SigBit> pi;
-		register_cone(pi, output);
-
-		if (verbose_level >= 1)
-			log("         Found %d input signals and %d cells.\n", int(pi.size()), int(ez_cells.size()));
+		query_t q;
+		q.output = output;
+		q.perc = perc;
+		register_cone(q.pi, output);
 
 		satgen.setContext(&sigmap, "A");
-		int output_a = satgen.importSigSpec(output).front();
-		int output_undef_a = satgen.importUndefSigSpec(output).front();
+		q.output_a = satgen.importSigSpec(output).front();
+		q.output_undef_a = satgen.importUndefSigSpec(output).front();
 
 		satgen.setContext(&sigmap, "B");
-		int output_b = satgen.importSigSpec(output).front();
-		int output_undef_b = satgen.importUndefSigSpec(output).front();
+		q.output_b = satgen.importSigSpec(output).front();
+		q.output_undef_b = satgen.importUndefSigSpec(output).front();
+
+		queries.push_back(q);
+	}
+
+	// An input is relevant for an output if flipping it changes the output.
+	// Inputs for which the random simulation finds such a pattern (with the
+	// output defined before and after the flip) do not need a SAT call.
+	void simulate(RTLIL::Module *module)
+	{
+		std::vector<RTLIL::Cell*> cells(ez_cells.begin(), ez_cells.end());
+		EquivSimulator sim(module, sigmap, cells, sim_patterns);
+		if (!sim.usable)
+			return;
+
+		int num_words = sim.num_words;
+		sim.eval();
+		std::vector<uint64_t> base_value = sim.value, base_known = sim.known;
+
+		for (auto &it : sat_pi)
+		{
+			int s = sim.slot(it.first);
+			if (s <= sim.slot_sink)
+				continue;
+
+			for (int w = 0; w < num_words; w++)
+				sim.value[s*num_words + w] = ~base_value[s*num_words + w];
+			sim.eval(false);
+
+			for (auto &q : queries) {
+				int o = sim.slot(q.output);
+				for (int w = 0; w < num_words; w++)
+					if (base_known[o*num_words + w] & sim.known[o*num_words + w] & (base_value[o*num_words + w] ^ sim.value[o*num_words + w])) {
+						q.sim_relevant.insert(it.first);
+						break;
+					}
+			}
+
+			for (int w = 0; w < num_words; w++)
+				sim.value[s*num_words + w] = base_value[s*num_words + w];
+		}
+	}
+
+	// Finds the remaining relevant inputs with SAT. This does not touch the
+	// design and may run on a worker thread (but logs, so not with -v).
+	void solve(int query_idx)
+	{
+		query_t &q = queries[query_idx];
+		std::vector<RTLIL::SigBit> &pi = q.pi;
+
+		if (verbose_level >= 1) {
+			log("[%2d%%]  Analyzing input cone for signal %s:\n", q.perc, log_signal(q.output));
+			log("         Found %d input signals and %d cells.\n", int(pi.size()), int(ez_cells.size()));
+		}
 
 		std::set<int> unused_pi_idx;
 
 		for (size_t i = 0; i < pi.size(); i++)
-			unused_pi_idx.insert(i);
+			if (q.sim_relevant.count(pi[i]) == 0)
+				unused_pi_idx.insert(i);
+			else if (verbose_level >= 2)
+				log("         Found relevant input in simulation: %s\n", log_signal(pi[i]));
 
-		while (1)
+		while (!unused_pi_idx.empty())
 		{
 			std::vector<int> model_pi_idx;
 			std::vector<int> model_expr;
@@ -201,7 +270,7 @@ struct FindReducedInputs
 					model_expr.push_back(sat_pi.at(pi[i]));
 				}
 
-			if (!ez->solve(model_expr, model, ez->expression(ezSAT::OpOr, model_expr), ez->XOR(output_a, output_b), ez->NOT(output_undef_a), ez->NOT(output_undef_b)))
+			if (!ez->solve(model_expr, model, ez->expression(ezSAT::OpOr, model_expr), ez->XOR(q.output_a, q.output_b), ez->NOT(q.output_undef_a), ez->NOT(q.output_undef_b)))
 				break;
 
 			int found_count = 0;
@@ -217,10 +286,10 @@ struct FindReducedInputs
 
 		for (size_t i = 0; i < pi.size(); i++)
 			if (unused_pi_idx.count(i) == 0)
-				reduced_inputs.push_back(pi[i]);
+				q.reduced_inputs.push_back(pi[i]);
 
 		if (verbose_level >= 1)
-			log("         Reduced input cone contains %d inputs.\n", int(reduced_inputs.size()));
+			log("         Reduced input cone contains %d inputs.\n", int(q.reduced_inputs.size()));
 	}
 };
 
@@ -228,7 +297,7 @@ struct PerformReduction
 {
 	SigMap &sigmap;
 	drivers_t &drivers;
-	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs;
+	pool<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs;
 	pool<SigBit> recursion_guard;
 
 	ezSatPtr ez;
@@ -238,9 +307,11 @@ struct PerformReduction
 	std::vector<RTLIL::SigBit> out_bits, pi_bits;
 	std::vector<bool> out_inverted;
 	std::vector<int> out_depth;
+	std::vector<RTLIL::Cell*> cone_cells;
+	std::vector<std::vector<int>> sim_groups;
 	int cone_size;
 
-	int register_cone_worker(std::set<RTLIL::Cell*> &celldone, std::map<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
+	int register_cone_worker(pool<RTLIL::Cell*> &celldone, dict<RTLIL::SigBit, int> &sigdepth, RTLIL::SigBit out)
 	{
 		if (out.wire == NULL)
 			return 0;
@@ -257,11 +328,12 @@ struct PerformReduction
 		recursion_guard.insert(out);
 
 		if (drivers.count(out) != 0) {
-			std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> &drv = drivers.at(out);
+			std::pair<RTLIL::Cell*, pool<RTLIL::SigBit>> &drv = drivers.at(out);
 			if (celldone.count(drv.first) == 0) {
 				if (!satgen.importCell(drv.first))
 					log_error("Can't create SAT model for cell %s (%s)!\n", RTLIL::id2cstr(drv.first->name), RTLIL::id2cstr(drv.first->type));
 				celldone.insert(drv.first);
+				cone_cells.push_back(drv.first);
 			}
 			int max_child_depth = 0;
 			for (auto &bit : drv.second)
@@ -278,13 +350,13 @@ struct PerformReduction
 		return sigdepth.at(out);
 	}
 
-	PerformReduction(SigMap &sigmap, drivers_t &drivers, std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
+	PerformReduction(SigMap &sigmap, drivers_t &drivers, pool<std::pair<RTLIL::SigBit, RTLIL::SigBit>> &inv_pairs, std::vector<RTLIL::SigBit> &bits, int cone_size) :
 			sigmap(sigmap), drivers(drivers), inv_pairs(inv_pairs), satgen(ez.get(), &sigmap), out_bits(bits), cone_size(cone_size)
 	{
 		satgen.model_undef = true;
 
-		std::set<RTLIL::Cell*> celldone;
-		std::map<RTLIL::SigBit, int> sigdepth;
+		pool<RTLIL::Cell*> celldone;
+		dict<RTLIL::SigBit, int> sigdepth;
 
 		for (auto &bit : bits) {
 			out_depth.push_back(register_cone_worker(celldone, sigdepth, bit));
@@ -487,6 +559,48 @@ struct PerformReduction
 		}
 	}
 
+	// Splits the bucket by the output values under random input patterns before
+	// the SAT solver is used. Signals that are undefined in some patterns can
+	// not be split this way and are added to every group, like in analyze().
+	void simulate(RTLIL::Module *module)
+	{
+		EquivSimulator sim(module, sigmap, cone_cells, sim_patterns);
+		if (!sim.usable)
+			return;
+
+		int num_words = sim.num_words;
+		sim.eval();
+
+		dict<std::vector<int64_t>, int> signature_groups;
+		std::vector<int> undef_bits;
+
+		for (int idx = 0; idx < GetSize(out_bits); idx++)
+		{
+			int s = sim.slot(out_bits[idx]);
+			std::vector<int64_t> signature;
+			for (int w = 0; w < num_words; w++) {
+				if (sim.known[s*num_words + w] != ~uint64_t(0))
+					goto undef_bit;
+				signature.push_back(out_inverted[idx] ? ~sim.value[s*num_words + w] : sim.value[s*num_words + w]);
+			}
+
+			if (signature_groups.count(signature) == 0) {
+				signature_groups[signature] = GetSize(sim_groups);
+				sim_groups.push_back(std::vector<int>());
+			}
+			sim_groups[signature_groups.at(signature)].push_back(idx);
+			continue;
+
+		undef_bit:
+			undef_bits.push_back(idx);
+		}
+
+		if (sim_groups.empty())
+			sim_groups.push_back(std::vector<int>());
+		for (auto &group : sim_groups)
+			group.insert(group.end(), undef_bits.begin(), undef_bits.end());
+	}
+
 	void analyze(std::vector<std::vector<equiv_bit_t>> &results, int perc)
 	{
 		std::vector<int> bucket;
@@ -495,7 +609,11 @@ struct PerformReduction
 
 		std::vector<std::set<int>> results_buf;
 		std::map<int, int> results_map;
-		analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+		if (sim_groups.empty())
+			analyze(results_buf, results_map, bucket, stringf("[%2d%%] %d ", perc, cone_size), "");
+		else
+			for (auto &group : sim_groups)
+				analyze(results_buf, results_map, group, stringf("[%2d%%] %d ", perc, cone_size), "");
 
 		for (auto &r : results_buf)
 		{
@@ -566,20 +684,20 @@ struct FreduceWorker
 
 	SigMap sigmap;
 	drivers_t drivers;
-	std::set<std::pair<RTLIL::SigBit, RTLIL::SigBit>> inv_pairs;
+	pool<std::pair<RTLIL::SigBit, RTLIL::SigBit>> inv_pairs;
 
 	FreduceWorker(RTLIL::Design *design, RTLIL::Module *module) : design(design), module(module), sigmap(module)
 	{
 	}
 
-	bool find_bit_in_cone(std::set<RTLIL::Cell*> &celldone, RTLIL::SigBit needle, RTLIL::SigBit haystack)
+	bool find_bit_in_cone(pool<RTLIL::Cell*> &celldone, RTLIL::SigBit needle, RTLIL::SigBit haystack)
 	{
 		if (needle == haystack)
 			return true;
 		if (haystack.wire == NULL || needle.wire == NULL || drivers.count(haystack) == 0)
 			return false;
 
-		std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> &drv = drivers.at(haystack);
+		std::pair<RTLIL::Cell*, pool<RTLIL::SigBit>> &drv = drivers.at(haystack);
 
 		if (celldone.count(drv.first))
 			return false;
@@ -593,7 +711,7 @@ struct FreduceWorker
 
 	bool find_bit_in_cone(RTLIL::SigBit needle, RTLIL::SigBit haystack)
 	{
-		std::set<RTLIL::Cell*> celldone;
+		pool<RTLIL::Cell*> celldone;
 		return find_bit_in_cone(celldone, needle, haystack);
 	}
 
@@ -621,7 +739,8 @@ struct FreduceWorker
 			}
 		for (auto &it : module->cells_) {
 			if (ct.cell_known(it.second->type)) {
-				std::set<RTLIL::SigBit> inputs, outputs;
+				std::set<RTLIL::SigBit> outputs;
+				pool<RTLIL::SigBit> inputs;
 				for (auto &port : it.second->connections()) {
 					std::vector<RTLIL::SigBit> bits = sigmap(port.second).to_sigbit_vector();
 					if (ct.cell_output(it.second->type, port.first))
@@ -629,7 +748,7 @@ struct FreduceWorker
 					else
 						inputs.insert(bits.begin(), bits.end());
 				}
-				std::pair<RTLIL::Cell*, std::set<RTLIL::SigBit>> drv(it.second, inputs);
+				std::pair<RTLIL::Cell*, pool<RTLIL::SigBit>> drv(it.second, inputs);
 				for (auto &bit : outputs)
 					drivers[bit] = drv;
 				batches.push_back(outputs);
@@ -639,54 +758,102 @@ struct FreduceWorker
 				inv_pairs.insert(std::pair<RTLIL::SigBit, RTLIL::SigBit>(sigmap(it.second->getPort("\\A")), sigmap(it.second->getPort("\\Y"))));
 		}
 
+		settle_for_concurrent_reads(drivers);
+		settle_for_concurrent_reads(inv_pairs);
+
+		// Batches and buckets are processed in rounds: the SAT models of all
+		// batches (buckets) of a round are created on the main thread, then
+		// they are solved in parallel, each one with its own solver.
+		int round_size = num_threads == 1 ? 1 : 2*num_threads;
+
 		int bits_count = 0;
 		int bits_full_count = 0;
-		std::map<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets;
-		for (auto &batch : batches)
+		dict<std::vector<RTLIL::SigBit>, std::vector<RTLIL::SigBit>> buckets;
+		for (int round_begin = 0; round_begin < GetSize(batches);)
 		{
-			for (auto &bit : batch)
-				if (bit.wire != NULL && design->selected(module, bit.wire))
-					goto found_selected_wire;
-			bits_full_count += batch.size();
-			continue;
+			std::vector<std::unique_ptr<FindReducedInputs>> infinders;
+			std::vector<std::set<RTLIL::SigBit>*> infinder_batches;
 
-		found_selected_wire:
-			log("  Finding reduced input cone for signal batch %s%c\n",
-					log_signal(batch), verbose_level ? ':' : '.');
+			for (; round_begin < GetSize(batches) && GetSize(infinders) < round_size; round_begin++)
+			{
+				auto &batch = batches[round_begin];
+				for (auto &bit : batch)
+					if (bit.wire != NULL && design->selected(module, bit.wire))
+						goto found_selected_wire;
+				bits_full_count += batch.size();
+				continue;
 
-			FindReducedInputs infinder(sigmap, drivers);
-			for (auto &bit : batch) {
-				std::vector<RTLIL::SigBit> inputs;
-				infinder.analyze(inputs, bit, 100 * bits_full_count / bits_full_total);
-				buckets[inputs].push_back(bit);
-				bits_full_count++;
-				bits_count++;
+			found_selected_wire:
+				log("  Finding reduced input cone for signal batch %s%c\n",
+						log_signal(batch), verbose_level ? ':' : '.');
+
+				infinders.emplace_back(new FindReducedInputs(sigmap, drivers));
+				infinder_batches.push_back(&batch);
+				for (auto &bit : batch) {
+					infinders.back()->prepare(bit, 100 * bits_full_count / bits_full_total);
+					bits_full_count++;
+					bits_count++;
+				}
+				if (sim_patterns > 0)
+					infinders.back()->simulate(module);
+				settle_for_concurrent_reads(infinders.back()->sat_pi);
 			}
+
+			parallel_for(num_threads, GetSize(infinders), [&](int i) {
+				for (int j = 0; j < GetSize(infinders[i]->queries); j++)
+					infinders[i]->solve(j);
+			});
+
+			for (auto &infinder : infinders)
+				for (auto &q : infinder->queries)
+					buckets[q.reduced_inputs].push_back(q.output);
 		}
 		log("  Sorted %d signal bits into %d buckets.\n", bits_count, int(buckets.size()));
 
 		int bucket_count = 0;
 		std::vector<std::vector<equiv_bit_t>> equiv;
-		for (auto &bucket : buckets)
+		auto bucket_it = buckets.begin();
+		while (bucket_it != buckets.end())
 		{
-			bucket_count++;
+			std::vector<std::unique_ptr<PerformReduction>> reducers;
+			std::vector<int> reducer_perc, reducer_slot;
+			std::vector<std::vector<std::vector<equiv_bit_t>>> round_equiv;
 
-			if (bucket.second.size() == 1)
-				continue;
+			for (; bucket_it != buckets.end() && GetSize(reducers) < round_size; ++bucket_it)
+			{
+				auto &bucket = *bucket_it;
+				bucket_count++;
+
+				if (bucket.second.size() == 1)
+					continue;
+
+				if (bucket.first.size() == 0) {
+					log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
+					PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
+					round_equiv.emplace_back();
+					for (size_t idx = 0; idx < bucket.second.size(); idx++)
+						worker.analyze_const(round_equiv.back(), idx);
+					continue;
+				}
 
-			if (bucket.first.size() == 0) {
-				log("  Finding const values for bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				for (size_t idx = 0; idx < bucket.second.size(); idx++)
-					worker.analyze_const(equiv, idx);
-			} else {
 				log("  Trying to shatter bucket %s%c\n", log_signal(bucket.second), verbose_level ? ':' : '.');
-				PerformReduction worker(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size());
-				worker.analyze(equiv, 100 * bucket_count / (buckets.size() + 1));
+				reducers.emplace_back(new PerformReduction(sigmap, drivers, inv_pairs, bucket.second, bucket.first.size()));
+				reducer_perc.push_back(100 * bucket_count / (buckets.size() + 1));
+				reducer_slot.push_back(GetSize(round_equiv));
+				round_equiv.emplace_back();
+				if (sim_patterns > 0)
+					reducers.back()->simulate(module);
 			}
+
+			parallel_for(num_threads, GetSize(reducers), [&](int i) {
+				reducers[i]->analyze(round_equiv[reducer_slot[i]], reducer_perc[i]);
+			});
+
+			for (auto &e : round_equiv)
+				equiv.insert(equiv.end(), e.begin(), e.end());
 		}
 
-		std::map<RTLIL::SigBit, int> bitusage;
+		dict<RTLIL::SigBit, int> bitusage;
 		CountBitUsage bitusage_worker(sigmap, bitusage);
 		module->rewrite_sigspecs(bitusage_worker);
 
@@ -784,6 +951,16 @@ struct FreducePass : public Pass {
 		log("        dump the design to <prefix>_<module>_<num>.il after each reduction\n");
 		log("        operation. this is mostly used for debugging the freduce command.\n");
 		log("\n");
+		log("    -sim <N>\n");
+		log("        simulate the input cones with N random input patterns before calling\n");
+		log("        the SAT solver. inputs and signals that the simulation can already tell\n");
+		log("        apart need no SAT calls. 0 disables the simulation. (default = 256)\n");
+		log("\n");
+		log("    -threads <N>\n");
+		log("        solve the SAT problems for independent signal batches and buckets on N\n");
+		log("        threads. N may be zero to use all available cores. (default = 1)\n");
+		log("        -v and -vv always use a single thread.\n");
+		log("\n");
 		log("This pass is undef-aware, i.e. it considers don't-care values for detecting\n");
 		log("equivalent nodes.\n");
 		log("\n");
@@ -797,6 +974,8 @@ struct FreducePass : public Pass {
 		reduce_stop_at = 0;
 		verbose_level = 0;
 		inv_mode = false;
+		sim_patterns = 256;
+		num_threads = 1;
 		dump_prefix = std::string();
 
 		log_header(design, "Executing FREDUCE pass (perform functional reduction).\n");
@@ -823,10 +1002,22 @@ struct FreducePass : public Pass {
 				dump_prefix = args[++argidx];
 				continue;
 			}
+			if (args[argidx] == "-sim" && argidx+1 < args.size()) {
+				sim_patterns = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		// the verbose messages are written from the SAT workers
+		if (verbose_level > 0)
+			num_threads = 1;
+
 		int bitcount = 0;
 		for (auto &mod_it : design->modules_) {
 			RTLIL::Module *module = mod_it.second;
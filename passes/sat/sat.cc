@@ -27,6 +27,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include "kernel/satgen.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <algorithm>
@@ -62,6 +63,7 @@ struct SatHelper
 	std::vector<std::string> shows;
 	SigPool show_signal_pool;
 	SigSet<RTLIL::Cell*> show_drivers;
+	dict<std::pair<RTLIL::SigSpec, int>, std::pair<std::vector<int>, std::vector<int>>> model_sig_cache;
 	int max_timestep, timeout;
 	bool gotTimeout;
 
@@ -496,6 +498,23 @@ struct SatHelper
 		backupValues.swap(modelValues);
 	}
 
+	// Importing a signal looks up one named literal per bit. Cache the imported
+	// model signals, so that generate_model() only needs to import the new time
+	// steps when it is called again after adding a time step.
+	const std::pair<std::vector<int>, std::vector<int>> &import_model_sig(const RTLIL::SigSpec &sig, int timestep)
+	{
+		auto key = std::make_pair(sig, timestep);
+		auto it = model_sig_cache.find(key);
+		if (it != model_sig_cache.end())
+			return it->second;
+
+		auto &entry = model_sig_cache[key];
+		entry.first = satgen.importSigSpec(sig, timestep);
+		if (enable_undef)
+			entry.second = satgen.importUndefSigSpec(sig, timestep);
+		return entry;
+	}
+
 	void generate_model()
 	{
 		RTLIL::SigSpec modelSig;
@@ -565,13 +584,9 @@ struct SatHelper
 					info.offset = modelExpressions.size();
 					modelInfo.insert(info);
 
-					std::vector<int> vec = satgen.importSigSpec(chunksig, timestep);
-					modelExpressions.insert(modelExpressions.end(), vec.begin(), vec.end());
-
-					if (enable_undef) {
-						std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, timestep);
-						modelUndefExpressions.insert(modelUndefExpressions.end(), undef_vec.begin(), undef_vec.end());
-					}
+					auto &vecs = import_model_sig(chunksig, timestep);
+					modelExpressions.insert(modelExpressions.end(), vecs.first.begin(), vecs.first.end());
+					modelUndefExpressions.insert(modelUndefExpressions.end(), vecs.second.begin(), vecs.second.end());
 				}
 			}
 
@@ -590,13 +605,9 @@ struct SatHelper
 				info.description = log_signal(chunksig);
 				modelInfo.insert(info);
 
-				std::vector<int> vec = satgen.importSigSpec(chunksig, 1);
-				modelExpressions.insert(modelExpressions.end(), vec.begin(), vec.end());
-
-				if (enable_undef) {
-					std::vector<int> undef_vec = satgen.importUndefSigSpec(chunksig, 1);
-					modelUndefExpressions.insert(modelUndefExpressions.end(), undef_vec.begin(), undef_vec.end());
-				}
+				auto &vecs = import_model_sig(chunksig, 1);
+				modelExpressions.insert(modelExpressions.end(), vecs.first.begin(), vecs.first.end());
+				modelUndefExpressions.insert(modelUndefExpressions.end(), vecs.second.begin(), vecs.second.end());
 			}
 
 		modelExpressions.insert(modelExpressions.end(), modelUndefExpressions.begin(), modelUndefExpressions.end());
@@ -1047,6 +1058,11 @@ struct SatPass : public Pass {
 		log("    -timeout <N>\n");
 		log("        Maximum number of seconds a single SAT instance may take.\n");
 		log("\n");
+		log("    -threads <N>\n");
+		log("        With N>1, solve the base case and the induction step of a temporal\n");
+		log("        induction proof concurrently on two threads. N=0 uses all cores.\n");
+		log("        (default: 1)\n");
+		log("\n");
 		log("    -verify\n");
 		log("        Return an error and stop the synthesis script if the proof fails.\n");
 		log("\n");
@@ -1073,7 +1089,7 @@ struct SatPass : public Pass {
 		bool show_regs = false, show_public = false, show_all = false;
 		bool ignore_unknown_cells = false, falsify = false, tempinduct_def = false, set_init_def = false;
 		bool tempinduct_baseonly = false, tempinduct_inductonly = false, set_assumes = false;
-		int tempinduct_skip = 0, stepsize = 1;
+		int tempinduct_skip = 0, stepsize = 1, num_threads = 1;
 		std::string vcd_file_name, json_file_name, cnf_file_name;
 
 		log_header(design, "Executing SAT pass (solving SAT problems in the circuit).\n");
@@ -1106,6 +1122,10 @@ struct SatPass : public Pass {
 				timeout = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx+1 < args.size()) {
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			if (args[argidx] == "-max" && argidx+1 < args.size()) {
 				loopcount = atoi(args[++argidx].c_str());
 				continue;
@@ -1435,39 +1455,22 @@ struct SatPass : public Pass {
 			{
 				log("\n** Trying induction with length %d **\n", inductlen);
 
-				// phase 1: proving base case
+				// phase 1: set up base case
+
+				int base_property = 0;
+				bool base_solve = false, base_result = false;
 
 				if (!tempinduct_inductonly)
 				{
 					basecase.setup(seq_len + inductlen, seq_len + inductlen == 1);
-					int property = basecase.setup_proof(seq_len + inductlen);
+					base_property = basecase.setup_proof(seq_len + inductlen);
 					basecase.generate_model();
 
 					if (inductlen > 1)
 						basecase.force_unique_state(seq_len + 1, seq_len + inductlen);
 
 					if (tempinduct_skip < inductlen)
-					{
-						log("\n[base case %d] Solving problem with %d variables and %d clauses..\n",
-								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
-						log_flush();
-
-						if (basecase.solve(basecase.ez->NOT(property))) {
-							log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
-							print_proof_failed();
-							basecase.print_model();
-							if(!vcd_file_name.empty())
-								basecase.dump_model_to_vcd(vcd_file_name);
-							if(!json_file_name.empty())
-								basecase.dump_model_to_json(json_file_name);
-							goto tip_failed;
-						}
-
-						if (basecase.gotTimeout)
-							goto timeout;
-
-						log("Base case for induction length %d proven.\n", inductlen);
-					}
+						base_solve = true;
 					else
 					{
 						log("\n[base case %d] Skipping prove for this step (-tempinduct-skip %d).",
@@ -1475,15 +1478,17 @@ struct SatPass : public Pass {
 						log("\n[base case %d] Problem size so far: %d variables and %d clauses.\n",
 								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
 					}
-					basecase.ez->assume(property);
 				}
 
-				// phase 2: proving induction step
+				// phase 2: set up induction step
+
+				int induct_property = 0;
+				bool induct_solve = false, induct_result = false;
 
 				if (!tempinduct_baseonly)
 				{
 					inductstep.setup(inductlen + 1);
-					int property = inductstep.setup_proof(inductlen + 1);
+					induct_property = inductstep.setup_proof(inductlen + 1);
 					inductstep.generate_model();
 
 					if (inductlen > 1)
@@ -1502,7 +1507,6 @@ struct SatPass : public Pass {
 									inductlen, stepsize);
 						log("\n[induction step %d] Problem size so far: %d variables and %d clauses.\n",
 								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
-						inductstep.ez->assume(property);
 					}
 					else
 					{
@@ -1519,24 +1523,83 @@ struct SatPass : public Pass {
 							inductstep.ez->printDIMACS(f, false);
 							fclose(f);
 						}
+						induct_solve = true;
+					}
+				}
+
+				// phase 3: solve both problems. Both solvers are kept between
+				// iterations, so every iteration only adds the clauses for the new
+				// time step and the solvers keep what they have learned so far.
 
+				if (base_solve && induct_solve && num_threads > 1)
+				{
+					log("\n[base case %d] Solving problem with %d variables and %d clauses..\n",
+							inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
+					log("[induction step %d] Solving problem with %d variables and %d clauses..\n",
+							inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
+					log_flush();
+
+					int base_query = basecase.ez->NOT(base_property);
+					int induct_query = inductstep.ez->NOT(induct_property);
+					parallel_for(2, 2, [&](int i) {
+						if (i == 0)
+							base_result = basecase.solve(base_query);
+						else
+							induct_result = inductstep.solve(induct_query);
+					});
+				}
+				else
+				{
+					if (base_solve) {
+						log("\n[base case %d] Solving problem with %d variables and %d clauses..\n",
+								inductlen, basecase.ez->numCnfVariables(), basecase.ez->numCnfClauses());
+						log_flush();
+						base_result = basecase.solve(basecase.ez->NOT(base_property));
+					}
+					if (induct_solve && !base_result && !basecase.gotTimeout) {
 						log("\n[induction step %d] Solving problem with %d variables and %d clauses..\n",
 								inductlen, inductstep.ez->numCnfVariables(), inductstep.ez->numCnfClauses());
 						log_flush();
+						induct_result = inductstep.solve(inductstep.ez->NOT(induct_property));
+					}
+				}
 
-						if (!inductstep.solve(inductstep.ez->NOT(property))) {
-							if (inductstep.gotTimeout)
-								goto timeout;
-							log("Induction step proven: SUCCESS!\n");
-							print_qed();
-							goto tip_success;
-						}
+				if (base_solve)
+				{
+					if (base_result) {
+						log("SAT temporal induction proof finished - model found for base case: FAIL!\n");
+						print_proof_failed();
+						basecase.print_model();
+						if(!vcd_file_name.empty())
+							basecase.dump_model_to_vcd(vcd_file_name);
+						if(!json_file_name.empty())
+							basecase.dump_model_to_json(json_file_name);
+						goto tip_failed;
+					}
+
+					if (basecase.gotTimeout)
+						goto timeout;
+
+					log("Base case for induction length %d proven.\n", inductlen);
+				}
+				if (!tempinduct_inductonly)
+					basecase.ez->assume(base_property);
 
-						log("Induction step failed. Incrementing induction length.\n");
-						inductstep.ez->assume(property);
-						inductstep.print_model();
+				if (induct_solve)
+				{
+					if (!induct_result) {
+						if (inductstep.gotTimeout)
+							goto timeout;
+						log("Induction step proven: SUCCESS!\n");
+						print_qed();
+						goto tip_success;
 					}
+
+					log("Induction step failed. Incrementing induction length.\n");
+					inductstep.print_model();
 				}
+				if (!tempinduct_baseonly)
+					inductstep.ez->assume(induct_property);
 			}
 
 			if (tempinduct_baseonly) {
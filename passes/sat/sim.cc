@@ -21,6 +21,17 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 
+#ifdef YOSYS_ENABLE_ZLIB
+#  include <zlib.h>
+#endif
+
+#ifdef YOSYS_ENABLE_THREADS
+#  include <thread>
+#  include <mutex>
+#  include <condition_variable>
+#  include <deque>
+#endif
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -30,9 +41,173 @@ struct SimShared
 	bool hide_internal = true;
 	bool writeback = false;
 	bool zinit = false;
+	bool compiled = false;
+	bool dump_selected = false;
+	RTLIL::Selection dump_selection;
 	int rstlen = 1;
 };
 
+// Collects the VCD output in large blocks and hands them to a writer thread
+// (when built with thread support), so that the simulation never waits for
+// the file system. Files ending in ".gz" are written gzip compressed.
+struct VcdWriter
+{
+	static const size_t block_size = 1 << 20;
+	static const size_t max_queued_blocks = 4;
+
+	std::string filename;
+	std::string buffer;
+	FILE *f = nullptr;
+#ifdef YOSYS_ENABLE_ZLIB
+	gzFile gzf = nullptr;
+#endif
+	bool write_failed = false;
+
+#ifdef YOSYS_ENABLE_THREADS
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<std::string> queue;
+	bool done = false;
+#endif
+
+	~VcdWriter()
+	{
+		close(false);
+	}
+
+	bool is_open() const
+	{
+#ifdef YOSYS_ENABLE_ZLIB
+		if (gzf != nullptr)
+			return true;
+#endif
+		return f != nullptr;
+	}
+
+	void open(const std::string &fn)
+	{
+		filename = fn;
+		buffer.reserve(block_size + block_size / 4);
+
+		if (filename.size() > 3 && filename.compare(filename.size()-3, std::string::npos, ".gz") == 0) {
+#ifdef YOSYS_ENABLE_ZLIB
+			gzf = gzopen(filename.c_str(), "wb");
+			if (gzf == nullptr)
+				log_cmd_error("Can't open file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+#else
+			log_cmd_error("Yosys is compiled without zlib support, unable to write gzip output.\n");
+#endif
+		} else {
+			f = fopen(filename.c_str(), "wb");
+			if (f == nullptr)
+				log_cmd_error("Can't open file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+		}
+
+#ifdef YOSYS_ENABLE_THREADS
+		thread = std::thread([this]() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (1) {
+				cond.wait(lock, [this]() { return done || !queue.empty(); });
+				if (queue.empty())
+					break;
+				std::string block;
+				block.swap(queue.front());
+				queue.pop_front();
+				cond.notify_all();
+				lock.unlock();
+				write_block(block);
+				lock.lock();
+			}
+		});
+#endif
+	}
+
+	// Runs on the writer thread, must not call log_*().
+	void write_block(const std::string &block)
+	{
+		if (block.empty() || write_failed)
+			return;
+#ifdef YOSYS_ENABLE_ZLIB
+		if (gzf != nullptr) {
+			if (gzwrite(gzf, block.data(), block.size()) != int(block.size()))
+				write_failed = true;
+			return;
+		}
+#endif
+		if (fwrite(block.data(), 1, block.size(), f) != block.size())
+			write_failed = true;
+	}
+
+	void flush()
+	{
+#ifdef YOSYS_ENABLE_THREADS
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this]() { return queue.size() < max_queued_blocks; });
+		queue.emplace_back();
+		queue.back().swap(buffer);
+		cond.notify_all();
+		lock.unlock();
+		buffer.reserve(block_size + block_size / 4);
+#else
+		write_block(buffer);
+		buffer.clear();
+#endif
+	}
+
+	// Called after every complete time step.
+	void flush_if_full()
+	{
+		if (buffer.size() >= block_size)
+			flush();
+	}
+
+	void close(bool report_errors = true)
+	{
+		if (!is_open())
+			return;
+
+		flush();
+
+#ifdef YOSYS_ENABLE_THREADS
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+		}
+		cond.notify_all();
+		thread.join();
+#endif
+
+#ifdef YOSYS_ENABLE_ZLIB
+		if (gzf != nullptr) {
+			if (gzclose(gzf) != Z_OK)
+				write_failed = true;
+			gzf = nullptr;
+		}
+#endif
+		if (f != nullptr) {
+			if (fclose(f) != 0)
+				write_failed = true;
+			f = nullptr;
+		}
+
+		if (write_failed && report_errors)
+			log_error("Writing VCD file `%s' failed.\n", filename.c_str());
+	}
+};
+
+// VCD identifier codes are short strings of the printable characters '!'
+// to '~', assigned in order.
+std::string vcd_id_code(int id)
+{
+	std::string code;
+	do {
+		code += char('!' + id % 94);
+		id /= 94;
+	} while (id-- > 0);
+	return code;
+}
+
 void zinit(State &v)
 {
 	if (v != State::S1)
@@ -83,7 +258,46 @@ struct SimInstance
 	dict<Cell*, mem_state_t> mem_database;
 	pool<Cell*> formal_database;
 
-	dict<Wire*, pair<int, Const>> vcd_database;
+	struct vcd_wire_t
+	{
+		Wire *wire;
+		std::string code;
+		std::vector<SigBit> bits;
+		std::vector<int> slots;
+		std::vector<State> last_value;
+	};
+
+	std::vector<vcd_wire_t> vcd_database;
+
+	// Compiled mode: every net is a slot in a flat state array (slots 0-3 hold
+	// the constants S0, S1, Sx and Sz) and the combinational cells are
+	// evaluated in a precomputed topological order with a specialized kernel
+	// per cell type. Cells in or behind combinational loops are iterated until
+	// they settle. Only modules without submodules are compiled, and they pass
+	// all their output ports to the parent after each evaluation.
+	//
+	// The kernels match CellTypes::eval(): $not inverts 0 and 1 and turns x and z
+	// into x, like the other bitwise cells, while $_NOT_ keeps x and z.
+
+	enum compiled_kind_t {
+		CK_BUF, CK_NOT, CK_GATE_NOT, CK_AND, CK_NAND, CK_OR, CK_NOR, CK_XOR, CK_XNOR,
+		CK_ANDNOT, CK_ORNOT, CK_MUX, CK_GENERIC, CK_MEM
+	};
+
+	struct compiled_cell_t
+	{
+		Cell *cell;
+		compiled_kind_t kind;
+		std::vector<int> a, b, c, s, y;
+	};
+
+	bool compiled = false;
+	bool comb_dirty = false;
+	dict<SigBit, int> slot_index;
+	std::vector<State> slots;
+	std::vector<compiled_cell_t> compiled_cells;
+	std::vector<Wire*> compiled_outports;
+	int num_levelized = 0;
 
 	SimInstance(SimShared *shared, Module *module, Cell *instance = nullptr, SimInstance *parent = nullptr) :
 			shared(shared), module(module), instance(instance), parent(parent), sigmap(module)
@@ -185,6 +399,323 @@ struct SimInstance
 				zinit(mem.data);
 			}
 		}
+
+		if (shared->compiled && children.empty())
+			compile();
+	}
+
+	int slot(SigBit bit) const
+	{
+		if (bit.wire == nullptr)
+			return bit.data <= State::Sz ? int(bit.data) : int(State::Sx);
+		return slot_index.at(bit);
+	}
+
+	std::vector<int> slots_of(SigSpec sig, int width = -1, bool is_signed = false)
+	{
+		std::vector<int> result;
+		for (auto bit : sigmap(sig))
+			result.push_back(slot(bit));
+		if (width >= 0) {
+			int padding = is_signed && !result.empty() ? result.back() : int(State::S0);
+			while (GetSize(result) < width)
+				result.push_back(padding);
+			result.resize(width);
+		}
+		return result;
+	}
+
+	void compile()
+	{
+		for (int i = 0; i < 4; i++)
+			slots.push_back(State(i));
+
+		for (auto &it : state_nets) {
+			slot_index[it.first] = GetSize(slots);
+			slots.push_back(it.second);
+		}
+		state_nets.clear();
+
+		std::vector<compiled_cell_t> comb_cells;
+
+		for (auto cell : module->cells())
+		{
+			if (ff_database.count(cell) || formal_database.count(cell))
+				continue;
+
+			compiled_cell_t cc;
+			cc.cell = cell;
+
+			if (mem_database.count(cell)) {
+				if (cell->getParam("\\RD_CLK_ENABLE").as_bool())
+					log_error("Memory %s.%s has clocked read ports. Run 'memory' with -nordff.\n", log_id(module), log_id(cell));
+				cc.kind = CK_MEM;
+				cc.a = slots_of(cell->getPort("\\RD_ADDR"));
+				cc.y = slots_of(cell->getPort("\\RD_DATA"));
+				comb_cells.push_back(cc);
+				continue;
+			}
+
+			if (!yosys_celltypes.cell_evaluable(cell->type))
+				log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
+
+			bool has_a = cell->hasPort("\\A"), has_b = cell->hasPort("\\B"), has_c = cell->hasPort("\\C");
+			bool has_d = cell->hasPort("\\D"), has_s = cell->hasPort("\\S"), has_y = cell->hasPort("\\Y");
+
+			if (!has_a || has_d || !has_y || (has_c && (!has_b || has_s)) || (has_s && !has_b)) {
+				log_warning("Unsupported evaluable cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
+				continue;
+			}
+
+			int width = GetSize(cell->getPort("\\Y"));
+			bool signed_a = cell->hasParam("\\A_SIGNED") && cell->getParam("\\A_SIGNED").as_bool();
+			bool signed_b = cell->hasParam("\\B_SIGNED") && cell->getParam("\\B_SIGNED").as_bool();
+
+			cc.kind = CK_GENERIC;
+			if (cell->type.in("$_BUF_", "$pos")) cc.kind = CK_BUF;
+			if (cell->type == "$_NOT_") cc.kind = CK_GATE_NOT;
+			if (cell->type == "$not") cc.kind = CK_NOT;
+			if (cell->type.in("$_AND_", "$and")) cc.kind = CK_AND;
+			if (cell->type == "$_NAND_") cc.kind = CK_NAND;
+			if (cell->type.in("$_OR_", "$or")) cc.kind = CK_OR;
+			if (cell->type == "$_NOR_") cc.kind = CK_NOR;
+			if (cell->type.in("$_XOR_", "$xor")) cc.kind = CK_XOR;
+			if (cell->type.in("$_XNOR_", "$xnor")) cc.kind = CK_XNOR;
+			if (cell->type == "$_ANDNOT_") cc.kind = CK_ANDNOT;
+			if (cell->type == "$_ORNOT_") cc.kind = CK_ORNOT;
+			if (cell->type.in("$_MUX_", "$mux")) cc.kind = CK_MUX;
+
+			if (cc.kind == CK_GENERIC) {
+				cc.a = slots_of(cell->getPort("\\A"));
+				if (has_b) cc.b = slots_of(cell->getPort("\\B"));
+				if (has_c) cc.c = slots_of(cell->getPort("\\C"));
+				if (has_s) cc.s = slots_of(cell->getPort("\\S"));
+			} else {
+				// Binary bitwise operators only sign extend if both operands are signed.
+				if (has_b && !cell->type.in("$_MUX_", "$mux"))
+					signed_a = signed_b = signed_a && signed_b;
+				cc.a = slots_of(cell->getPort("\\A"), width, signed_a);
+				if (has_b) cc.b = slots_of(cell->getPort("\\B"), width, signed_b);
+				if (has_s) cc.s = slots_of(cell->getPort("\\S"));
+			}
+			cc.y = slots_of(cell->getPort("\\Y"));
+			comb_cells.push_back(cc);
+		}
+
+		// Levelize with Kahn's algorithm. Whatever cannot be ordered is part of
+		// (or depends on) a combinational loop and goes to the end of the list.
+		dict<int, int> driver;
+		for (int i = 0; i < GetSize(comb_cells); i++)
+			for (int bit : comb_cells[i].y)
+				driver[bit] = i;
+
+		std::vector<int> num_deps(GetSize(comb_cells));
+		std::vector<std::vector<int>> users(GetSize(comb_cells));
+		for (int i = 0; i < GetSize(comb_cells); i++) {
+			pool<int> deps;
+			for (auto sigs : {&comb_cells[i].a, &comb_cells[i].b, &comb_cells[i].c, &comb_cells[i].s})
+				for (int bit : *sigs) {
+					auto it = driver.find(bit);
+					if (it != driver.end())
+						deps.insert(it->second);
+				}
+			num_deps[i] = GetSize(deps);
+			for (int d : deps)
+				users[d].push_back(i);
+		}
+
+		std::vector<int> order;
+		std::vector<bool> ordered(GetSize(comb_cells));
+		for (int i = 0; i < GetSize(comb_cells); i++)
+			if (num_deps[i] == 0)
+				order.push_back(i);
+		for (int k = 0; k < GetSize(order); k++) {
+			ordered[order[k]] = true;
+			for (int u : users[order[k]])
+				if (--num_deps[u] == 0)
+					order.push_back(u);
+		}
+
+		num_levelized = GetSize(order);
+		for (int i = 0; i < GetSize(comb_cells); i++)
+			if (!ordered[i])
+				order.push_back(i);
+
+		for (int i : order)
+			compiled_cells.push_back(comb_cells[i]);
+
+		if (num_levelized < GetSize(compiled_cells))
+			log("Module %s: %d of %d cells are in or behind combinational loops and are simulated event-driven.\n",
+					log_id(module), GetSize(compiled_cells) - num_levelized, GetSize(compiled_cells));
+
+		if (parent != nullptr)
+			for (auto wire : module->wires())
+				if (wire->port_output && instance->hasPort(wire->name))
+					compiled_outports.push_back(wire);
+
+		compiled = true;
+		comb_dirty = true;
+	}
+
+	static State not3(State a)
+	{
+		if (a == State::S0) return State::S1;
+		if (a == State::S1) return State::S0;
+		return State::Sx;
+	}
+
+	static State and3(State a, State b)
+	{
+		if (a == State::S0 || b == State::S0) return State::S0;
+		if (a == State::S1 && b == State::S1) return State::S1;
+		return State::Sx;
+	}
+
+	static State or3(State a, State b)
+	{
+		if (a == State::S1 || b == State::S1) return State::S1;
+		if (a == State::S0 && b == State::S0) return State::S0;
+		return State::Sx;
+	}
+
+	static State xor3(State a, State b)
+	{
+		if ((a != State::S0 && a != State::S1) || (b != State::S0 && b != State::S1)) return State::Sx;
+		return a != b ? State::S1 : State::S0;
+	}
+
+	Const get_slots(const std::vector<int> &sig) const
+	{
+		Const value;
+		value.bits.reserve(sig.size());
+		for (int bit : sig)
+			value.bits.push_back(slots[bit]);
+		return value;
+	}
+
+	// Returns true if any output changed.
+	bool eval_compiled_cell(const compiled_cell_t &cc)
+	{
+		bool changed = false;
+
+		auto set = [&](int bit, State value) {
+			if (slots[bit] != value) {
+				slots[bit] = value;
+				changed = true;
+			}
+		};
+
+		int width = GetSize(cc.y);
+
+		switch (cc.kind)
+		{
+		case CK_BUF:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], slots[cc.a[i]]);
+			break;
+		case CK_NOT:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], not3(slots[cc.a[i]]));
+			break;
+		case CK_GATE_NOT:
+			for (int i = 0; i < width; i++) {
+				State a = slots[cc.a[i]];
+				set(cc.y[i], a == State::S0 || a == State::S1 ? not3(a) : a);
+			}
+			break;
+		case CK_AND:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], and3(slots[cc.a[i]], slots[cc.b[i]]));
+			break;
+		case CK_NAND:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], not3(and3(slots[cc.a[i]], slots[cc.b[i]])));
+			break;
+		case CK_OR:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], or3(slots[cc.a[i]], slots[cc.b[i]]));
+			break;
+		case CK_NOR:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], not3(or3(slots[cc.a[i]], slots[cc.b[i]])));
+			break;
+		case CK_XOR:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], xor3(slots[cc.a[i]], slots[cc.b[i]]));
+			break;
+		case CK_XNOR:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], not3(xor3(slots[cc.a[i]], slots[cc.b[i]])));
+			break;
+		case CK_ANDNOT:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], and3(slots[cc.a[i]], not3(slots[cc.b[i]])));
+			break;
+		case CK_ORNOT:
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], or3(slots[cc.a[i]], not3(slots[cc.b[i]])));
+			break;
+		case CK_MUX: {
+			const std::vector<int> &src = slots[cc.s[0]] == State::S1 ? cc.b : cc.a;
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], slots[src[i]]);
+			break;
+		}
+		case CK_GENERIC: {
+			Const value;
+			if (!cc.c.empty())
+				value = CellTypes::eval(cc.cell, get_slots(cc.a), get_slots(cc.b), get_slots(cc.c));
+			else if (!cc.s.empty())
+				value = CellTypes::eval(cc.cell, get_slots(cc.a), get_slots(cc.b), get_slots(cc.s));
+			else
+				value = CellTypes::eval(cc.cell, get_slots(cc.a), get_slots(cc.b));
+			for (int i = 0; i < width; i++)
+				set(cc.y[i], value[i]);
+			break;
+		}
+		case CK_MEM: {
+			mem_state_t &mem = mem_database.at(cc.cell);
+			int size = cc.cell->getParam("\\SIZE").as_int();
+			int offset = cc.cell->getParam("\\OFFSET").as_int();
+			int abits = cc.cell->getParam("\\ABITS").as_int();
+			int mem_width = cc.cell->getParam("\\WIDTH").as_int();
+
+			for (int port_idx = 0; port_idx*mem_width < width; port_idx++)
+			{
+				Const addr = get_slots(std::vector<int>(cc.a.begin() + port_idx*abits, cc.a.begin() + (port_idx+1)*abits));
+				int index = addr.is_fully_def() ? addr.as_int() - offset : -1;
+
+				for (int i = 0; i < mem_width; i++)
+					set(cc.y[port_idx*mem_width + i], index >= 0 && index < size ? mem.data[index*mem_width + i] : State::Sx);
+			}
+			break;
+		}
+		}
+
+		return changed;
+	}
+
+	void eval_compiled()
+	{
+		for (int i = 0; i < num_levelized; i++)
+			eval_compiled_cell(compiled_cells[i]);
+
+		if (num_levelized == GetSize(compiled_cells))
+			return;
+
+		for (int iter = 0;; iter++)
+		{
+			bool changed = false;
+			for (int i = num_levelized; i < GetSize(compiled_cells); i++)
+				if (eval_compiled_cell(compiled_cells[i]))
+					changed = true;
+			if (!changed)
+				break;
+			if (iter > GetSize(compiled_cells)) {
+				log_warning("Combinational loop in module %s does not settle.\n", log_id(module));
+				break;
+			}
+		}
 	}
 
 	~SimInstance()
@@ -215,6 +746,8 @@ struct SimInstance
 		for (auto bit : sigmap(sig))
 			if (bit.wire == nullptr)
 				value.bits.push_back(bit.data);
+			else if (compiled)
+				value.bits.push_back(slot_index.count(bit) ? slots[slot_index.at(bit)] : State::Sz);
 			else if (state_nets.count(bit))
 				value.bits.push_back(state_nets.at(bit));
 			else
@@ -233,7 +766,14 @@ struct SimInstance
 		log_assert(GetSize(sig) <= GetSize(value));
 
 		for (int i = 0; i < GetSize(sig); i++)
-			if (state_nets.at(sig[i]) != value[i]) {
+			if (compiled) {
+				State &slot_value = slots[slot_index.at(sig[i])];
+				if (slot_value != value[i]) {
+					slot_value = value[i];
+					comb_dirty = true;
+					did_something = true;
+				}
+			} else if (state_nets.at(sig[i]) != value[i]) {
 				state_nets.at(sig[i]) = value[i];
 				dirty_bits.insert(sig[i]);
 				did_something = true;
@@ -347,6 +887,19 @@ struct SimInstance
 
 	void update_ph1()
 	{
+		if (compiled) {
+			if (comb_dirty || !dirty_cells.empty()) {
+				eval_compiled();
+				comb_dirty = false;
+				dirty_cells.clear();
+				for (auto wire : compiled_outports) {
+					Const value = get_state(wire);
+					parent->set_state(instance->getPort(wire->name), value);
+				}
+			}
+			return;
+		}
+
 		pool<Cell*> queue_cells;
 		pool<Wire*> queue_outports;
 
@@ -571,49 +1124,73 @@ struct SimInstance
 			it.second->writeback(wbmods);
 	}
 
-	void write_vcd_header(std::ofstream &f, int &id)
+	void write_vcd_header(std::string &f, int &id)
 	{
-		f << stringf("$scope module %s $end\n", log_id(name()));
+		f += stringf("$scope module %s $end\n", log_id(name()));
 
 		for (auto wire : module->wires())
 		{
 			if (shared->hide_internal && wire->name[0] == '$')
 				continue;
 
-			f << stringf("$var wire %d n%d %s%s $end\n", GetSize(wire), id, wire->name[0] == '$' ? "\\" : "", log_id(wire));
-			vcd_database[wire] = make_pair(id++, Const());
+			if (shared->dump_selected && !shared->dump_selection.selected_member(module->name, wire->name))
+				continue;
+
+			vcd_wire_t entry;
+			entry.wire = wire;
+			entry.code = vcd_id_code(id++);
+			entry.bits = sigmap(wire);
+			if (compiled)
+				for (auto bit : entry.bits)
+					entry.slots.push_back(bit.wire == nullptr || slot_index.count(bit) ? slot(bit) : int(State::Sz));
+			vcd_database.push_back(entry);
+
+			f += stringf("$var wire %d %s %s%s $end\n", GetSize(wire), entry.code.c_str(), wire->name[0] == '$' ? "\\" : "", log_id(wire));
 		}
 
 		for (auto child : children)
 			child.second->write_vcd_header(f, id);
 
-		f << stringf("$upscope $end\n");
+		f += stringf("$upscope $end\n");
 	}
 
-	void write_vcd_step(std::ofstream &f)
+	// Only wires that changed since the last step are written.
+	void write_vcd_step(std::string &f)
 	{
-		for (auto &it : vcd_database)
+		static const char state_chars[] = "01xz";
+		std::vector<State> value;
+
+		for (auto &entry : vcd_database)
 		{
-			Wire *wire = it.first;
-			Const value = get_state(wire);
-			int id = it.second.first;
+			value.clear();
+			if (compiled) {
+				for (int s : entry.slots)
+					value.push_back(slots[s]);
+			} else {
+				for (auto bit : entry.bits)
+					if (bit.wire == nullptr)
+						value.push_back(bit.data);
+					else {
+						auto it = state_nets.find(bit);
+						value.push_back(it != state_nets.end() ? it->second : State::Sz);
+					}
+			}
 
-			if (it.second.second == value)
+			if (value == entry.last_value)
 				continue;
 
-			it.second.second = value;
+			entry.last_value = value;
 
-			f << "b";
-			for (int i = GetSize(value)-1; i >= 0; i--) {
-				switch (value[i]) {
-					case State::S0: f << "0"; break;
-					case State::S1: f << "1"; break;
-					case State::Sx: f << "x"; break;
-					default: f << "z";
-				}
+			if (GetSize(value) == 1) {
+				f += state_chars[value[0] <= State::Sz ? int(value[0]) : 3];
+			} else {
+				f += 'b';
+				for (int i = GetSize(value)-1; i >= 0; i--)
+					f += state_chars[value[i] <= State::Sz ? int(value[i]) : 3];
+				f += ' ';
 			}
-
-			f << stringf(" n%d\n", id);
+			f += entry.code;
+			f += '\n';
 		}
 
 		for (auto child : children)
@@ -624,7 +1201,7 @@ struct SimInstance
 struct SimWorker : SimShared
 {
 	SimInstance *top = nullptr;
-	std::ofstream vcdfile;
+	VcdWriter vcdfile;
 	pool<IdString> clock, clockn, reset, resetn;
 
 	~SimWorker()
@@ -637,10 +1214,10 @@ struct SimWorker : SimShared
 		if (!vcdfile.is_open())
 			return;
 
-		int id = 1;
-		top->write_vcd_header(vcdfile, id);
+		int id = 0;
+		top->write_vcd_header(vcdfile.buffer, id);
 
-		vcdfile << stringf("$enddefinitions $end\n");
+		vcdfile.buffer += stringf("$enddefinitions $end\n");
 	}
 
 	void write_vcd_step(int t)
@@ -648,8 +1225,9 @@ struct SimWorker : SimShared
 		if (!vcdfile.is_open())
 			return;
 
-		vcdfile << stringf("#%d\n", t);
-		top->write_vcd_step(vcdfile);
+		vcdfile.buffer += stringf("#%d\n", t);
+		top->write_vcd_step(vcdfile.buffer);
+		vcdfile.flush_if_full();
 	}
 
 	void update()
@@ -692,6 +1270,12 @@ struct SimWorker : SimShared
 		log_assert(top == nullptr);
 		top = new SimInstance(this, topmod);
 
+		if (compiled && !top->compiled)
+			log("Module %s has submodules, using the compiled simulator only for modules without submodules. (Run 'flatten' to compile the whole design.)\n", log_id(topmod));
+
+		PerformanceTimer timer;
+		timer.begin();
+
 		if (debug)
 			log("\n===== 0 =====\n");
 		else
@@ -738,6 +1322,12 @@ struct SimWorker : SimShared
 
 		write_vcd_step(10*numcycles + 2);
 
+		timer.end();
+		log("Simulated %d cycles in %.3f seconds (%.0f cycles/s).\n", numcycles, timer.sec(),
+				timer.sec() > 0 ? numcycles / timer.sec() : 0.0);
+
+		vcdfile.close();
+
 		if (writeback) {
 			pool<Module*> wbmods;
 			top->writeback(wbmods);
@@ -756,7 +1346,12 @@ struct SimPass : public Pass {
 		log("This command simulates the circuit using the given top-level module.\n");
 		log("\n");
 		log("    -vcd <filename>\n");
-		log("        write the simulation results to the given VCD file\n");
+		log("        write the simulation results to the given VCD file. the file is\n");
+		log("        written gzip compressed if the filename ends in '.gz'.\n");
+		log("\n");
+		log("    -dump <selection>\n");
+		log("        only write the selected wires to the VCD file. this option can be\n");
+		log("        used multiple times, the selections are combined.\n");
 		log("\n");
 		log("    -clock <portname>\n");
 		log("        name of top-level clock input\n");
@@ -788,10 +1383,17 @@ struct SimPass : public Pass {
 		log("    -d\n");
 		log("        enable debug output\n");
 		log("\n");
+		log("    -compiled\n");
+		log("        levelize the combinational logic and evaluate it in a precomputed\n");
+		log("        order on a flat state array instead of event-driven. this is much\n");
+		log("        faster for larger designs. in a hierarchical design only modules\n");
+		log("        without submodules are compiled, so run 'flatten' first.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		SimWorker worker;
+		std::vector<std::string> dump_args;
 		int numcycles = 20;
 
 		log_header(design, "Executing SIM pass (simulate the circuit).\n");
@@ -799,9 +1401,15 @@ struct SimPass : public Pass {
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			if (args[argidx] == "-vcd" && argidx+1 < args.size()) {
+				if (worker.vcdfile.is_open())
+					log_cmd_error("Option -vcd can only be used once.\n");
 				worker.vcdfile.open(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-dump" && argidx+1 < args.size()) {
+				dump_args.push_back(args[++argidx]);
+				continue;
+			}
 			if (args[argidx] == "-n" && argidx+1 < args.size()) {
 				numcycles = atoi(args[++argidx].c_str());
 				continue;
@@ -842,10 +1450,19 @@ struct SimPass : public Pass {
 				worker.zinit = true;
 				continue;
 			}
+			if (args[argidx] == "-compiled") {
+				worker.compiled = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		if (!dump_args.empty()) {
+			worker.dump_selected = true;
+			worker.dump_selection = eval_select_args(dump_args, design);
+		}
+
 		Module *top_mod = nullptr;
 
 		if (design->full_selection()) {
@@ -59,6 +59,12 @@
 #  include <dirent.h>
 #endif
 
+#if defined(YOSYS_ENABLE_THREADS) && !defined(_WIN32)
+#  define ABC_STREAM_OUTPUT
+#  include <fcntl.h>
+#  include <thread>
+#endif
+
 #include "frontends/blif/blifparse.h"
 
 #ifdef YOSYS_LINK_ABC
@@ -118,6 +124,26 @@ bool recover_init, cmos_cost;
 bool clk_polarity, en_polarity;
 RTLIL::SigSpec clk_sig, en_sig;
 dict<int, std::string> pi_map, po_map;
+std::string shared_tempdir_name;
+void (*shared_tempdir_prev_atexit)() = NULL;
+
+void remove_shared_tempdir()
+{
+	if (!shared_tempdir_name.empty()) {
+		log("Removing temp directory.\n");
+		remove_directory(shared_tempdir_name);
+		shared_tempdir_name.clear();
+	}
+}
+
+// log_error() exits without unwinding the stack, so the shared temp dir
+// is also removed from the error hook.
+void shared_tempdir_atexit()
+{
+	remove_shared_tempdir();
+	if (shared_tempdir_prev_atexit)
+		shared_tempdir_prev_atexit();
+}
 
 int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
 {
@@ -655,6 +681,58 @@ struct abc_output_filter
 	}
 };
 
+#ifdef ABC_STREAM_OUTPUT
+// Receives the mapped netlist that ABC writes to an inherited pipe, so that it
+// does not make a round trip through the file system. A helper thread drains
+// the pipe while ABC is running (so that ABC never blocks on a full pipe); the
+// data is parsed on the main thread once ABC has exited.
+struct abc_output_pipe
+{
+	int fds[2] = {-1, -1};
+	std::string data;
+	std::thread reader;
+
+	bool open()
+	{
+		if (pipe(fds) != 0)
+			return false;
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		reader = std::thread([this]() {
+			char buf[65536];
+			while (1) {
+				ssize_t n = read(fds[0], buf, sizeof(buf));
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n <= 0)
+					break;
+				data.append(buf, n);
+			}
+		});
+		return true;
+	}
+
+	std::string filename() const
+	{
+		return stringf("/dev/fd/%d", fds[1]);
+	}
+
+	void finish()
+	{
+		if (fds[1] >= 0)
+			close(fds[1]), fds[1] = -1;
+		if (reader.joinable())
+			reader.join();
+		if (fds[0] >= 0)
+			close(fds[0]), fds[0] = -1;
+	}
+
+	~abc_output_pipe()
+	{
+		finish();
+	}
+};
+#endif
+
 void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		std::string liberty_file, std::string constr_file, bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
 		bool keepff, std::string delay_target, std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
@@ -702,10 +780,13 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (dff_mode && clk_sig.empty())
 		log_cmd_error("Clock domain %s not found.\n", clk_str.c_str());
 
-	std::string tempdir_name = "/tmp/yosys-abc-XXXXXX";
-	if (!cleanup)
-		tempdir_name[0] = tempdir_name[4] = '_';
-	tempdir_name = make_temp_dir(tempdir_name);
+	std::string tempdir_name = shared_tempdir_name;
+	if (tempdir_name.empty()) {
+		tempdir_name = "/tmp/yosys-abc-XXXXXX";
+		if (!cleanup)
+			tempdir_name[0] = tempdir_name[4] = '_';
+		tempdir_name = make_temp_dir(tempdir_name);
+	}
 	log_header(design, "Extracting gate netlist of module `%s' to `%s/input.blif'..\n",
 			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str());
 
@@ -764,7 +845,17 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		abc_script = abc_script.substr(0, pos) + lutin_shared + abc_script.substr(pos+3);
 	if (abc_dress)
 		abc_script += "; dress";
-	abc_script += stringf("; write_blif %s/output.blif", tempdir_name.c_str());
+
+	// With -nocleanup the output stays in the temp dir for inspection,
+	// otherwise it is streamed back to us over a pipe when possible.
+	std::string output_blif = stringf("%s/output.blif", tempdir_name.c_str());
+	std::string output_pipe_name;
+#ifdef ABC_STREAM_OUTPUT
+	abc_output_pipe output_pipe;
+	if (cleanup && output_pipe.open())
+		output_blif = output_pipe_name = output_pipe.filename();
+#endif
+	abc_script += stringf("; write_blif %s", output_blif.c_str());
 	abc_script = add_echos_to_abc_cmd(abc_script);
 
 	for (size_t i = 0; i+1 < abc_script.size(); i++)
@@ -988,6 +1079,11 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
+		// The temp dir is shared by all ABC runs of this pass, so make sure
+		// a failed run can't leave us reading the netlist of a previous one.
+		if (output_blif != output_pipe_name)
+			remove(output_blif.c_str());
+
 		buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
 		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
@@ -1012,17 +1108,29 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		if (ret != 0)
 			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
-		std::ifstream ifs;
-		ifs.open(buffer);
-		if (ifs.fail())
-			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
-
 		bool builtin_lib = liberty_file.empty();
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
 
-		ifs.close();
+#ifdef ABC_STREAM_OUTPUT
+		if (output_pipe.reader.joinable())
+		{
+			output_pipe.finish();
+			if (output_pipe.data.empty())
+				log_error("ABC did not write a mapped netlist.\n");
+			std::istringstream iss(output_pipe.data);
+			output_pipe.data.clear();
+			parse_blif(mapped_design, iss, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		}
+		else
+#endif
+		{
+			std::ifstream ifs;
+			ifs.open(output_blif);
+			if (ifs.fail())
+				log_error("Can't open ABC output file `%s'.\n", output_blif.c_str());
+			parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+			ifs.close();
+		}
 
 		log_header(design, "Re-integrating ABC results.\n");
 		RTLIL::Module *mapped_mod = mapped_design->modules_[ID(netlist)];
@@ -1281,7 +1389,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (cleanup && shared_tempdir_name.empty())
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
@@ -1858,6 +1966,20 @@ struct AbcPass : public Pass {
 			// enabled_gates.insert("NMUX");
 		}
 
+		// All modules and clock domains share one temp dir, unless the files
+		// for each ABC run should be kept around for inspection.
+		shared_tempdir_name = cleanup ? make_temp_dir("/tmp/yosys-abc-XXXXXX") : std::string();
+
+		// The guard cleans up when abc_module() throws a command error.
+		shared_tempdir_prev_atexit = log_error_atexit;
+		log_error_atexit = shared_tempdir_atexit;
+		struct SharedTempdirGuard {
+			~SharedTempdirGuard() {
+				log_error_atexit = shared_tempdir_prev_atexit;
+				remove_shared_tempdir();
+			}
+		} shared_tempdir_guard;
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -2044,6 +2166,8 @@ struct AbcPass : public Pass {
 		pi_map.clear();
 		po_map.clear();
 
+		remove_shared_tempdir();
+
 		log_pop();
 	}
 } AbcPass;
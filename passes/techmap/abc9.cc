@@ -165,6 +165,11 @@ struct Abc9Pass : public ScriptPass
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -showtime\n");
+		log("        print a breakdown of the time spent in the different stages of the\n");
+		log("        flow (preparation, writing the XAIGER and box files, running ABC,\n");
+		log("        reading the result and reintegrating it into the design).\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -183,6 +188,24 @@ struct Abc9Pass : public ScriptPass
 	bool lut_mode;
 	int maxlut;
 	std::string box_file;
+	bool show_time;
+
+	std::vector<std::string> stage_names;
+	dict<std::string, int64_t> stage_times;
+
+	void add_stage_time(const std::string &stage, int64_t time_ns)
+	{
+		if (!stage_times.count(stage))
+			stage_names.push_back(stage);
+		stage_times[stage] += time_ns;
+	}
+
+	void run_stage(const std::string &stage, const std::string &command)
+	{
+		int64_t begin = PerformanceTimer::query();
+		run_nocheck(command);
+		add_stage_time(stage, PerformanceTimer::query() - begin);
+	}
 
 	void clear_flags() YS_OVERRIDE
 	{
@@ -193,6 +216,9 @@ struct Abc9Pass : public ScriptPass
 		lut_mode = false;
 		maxlut = 0;
 		box_file = "";
+		show_time = false;
+		stage_names.clear();
+		stage_times.clear();
 	}
 
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
@@ -231,6 +257,10 @@ struct Abc9Pass : public ScriptPass
 				exe_cmd << " " << arg;
 				continue;
 			}
+			if (arg == "-showtime") {
+				show_time = true;
+				continue;
+			}
 			if (arg == "-nocleanup") {
 				cleanup = false;
 				continue;
@@ -269,12 +299,24 @@ struct Abc9Pass : public ScriptPass
 
 		run_script(design, run_from, run_to);
 
+		if (show_time) {
+			int64_t total_ns = 0;
+			for (auto &it : stage_times)
+				total_ns += it.second;
+			log("\nTime spent in ABC9 stages:\n");
+			for (auto &stage : stage_names)
+				log("  %-14s %10.3f sec  %5.1f%%\n", stage.c_str(), stage_times.at(stage) / 1e9,
+						total_ns ? 100.0 * stage_times.at(stage) / total_ns : 0.0);
+			log("  %-14s %10.3f sec\n", "total", total_ns / 1e9);
+		}
+
 		log_pop();
 	}
 
 	void script() YS_OVERRIDE
 	{
 		if (check_label("pre")) {
+			int64_t begin = PerformanceTimer::query();
 			run("abc9_ops -check");
 			run("scc -set_attr abc9_scc_id {}");
 			if (help_mode)
@@ -297,6 +339,8 @@ struct Abc9Pass : public ScriptPass
 			run("opt -purge @abc9_holes");
 			run("aigmap");
 			run("wbflip @abc9_holes");
+			if (!help_mode)
+				add_stage_time("prep", PerformanceTimer::query() - begin);
 		}
 
 		if (check_label("map")) {
@@ -304,9 +348,9 @@ struct Abc9Pass : public ScriptPass
 				run("foreach module in selection");
 				run("    abc9_ops -write_lut <abc-temp-dir>/input.lut", "(skip if '-lut' or '-luts')");
 				run("    abc9_ops -write_box <abc-temp-dir>/input.box");
-				run("    write_xaiger -map <abc-temp-dir>/input.sym <abc-temp-dir>/input.xaig");
+				run("    write_xaiger -map_scratchpad abc9.map <abc-temp-dir>/input.xaig");
 				run("    abc9_exe [options] -cwd <abc-temp-dir> [-lut <abc-temp-dir>/input.lut] -box <abc-temp-dir>/input.box");
-				run("    read_aiger -xaiger -wideports -module_name <module-name>$abc9 -map <abc-temp-dir>/input.sym <abc-temp-dir>/output.aig");
+				run("    read_aiger -xaiger -wideports -module_name <module-name>$abc9 -map_scratchpad abc9.map <abc-temp-dir>/output.aig");
 				run("    abc9_ops -reintegrate");
 			}
 			else {
@@ -332,9 +376,17 @@ struct Abc9Pass : public ScriptPass
 					tempdir_name = make_temp_dir(tempdir_name);
 
 					if (!lut_mode)
-						run_nocheck(stringf("abc9_ops -write_lut %s/input.lut", tempdir_name.c_str()));
-					run_nocheck(stringf("abc9_ops -write_box %s/input.box", tempdir_name.c_str()));
-					run_nocheck(stringf("write_xaiger -map %s/input.sym %s/input.xaig", tempdir_name.c_str(), tempdir_name.c_str()));
+						run_stage("write_lut/box", stringf("abc9_ops -write_lut %s/input.lut", tempdir_name.c_str()));
+					run_stage("write_lut/box", stringf("abc9_ops -write_box %s/input.box", tempdir_name.c_str()));
+
+					// The symbol map is only ever read back by Yosys, so it is kept in the design
+					// scratchpad instead of going through the temp dir. It is still written to
+					// input.sym when the temp dir is kept, for debugging.
+					if (cleanup)
+						run_stage("write_xaiger", stringf("write_xaiger -map_scratchpad abc9.map %s/input.xaig", tempdir_name.c_str()));
+					else
+						run_stage("write_xaiger", stringf("write_xaiger -map %s/input.sym -map_scratchpad abc9.map %s/input.xaig",
+								tempdir_name.c_str(), tempdir_name.c_str()));
 
 					int num_outputs = active_design->scratchpad_get_int("write_xaiger.num_outputs");
 
@@ -350,12 +402,13 @@ struct Abc9Pass : public ScriptPass
 						if (!lut_mode)
 							abc9_exe_cmd += stringf(" -lut %s/input.lut", tempdir_name.c_str());
 						abc9_exe_cmd += stringf(" -box %s/input.box", tempdir_name.c_str());
-						run_nocheck(abc9_exe_cmd);
-						run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
-						run_nocheck("abc9_ops -reintegrate");
+						run_stage("abc9_exe", abc9_exe_cmd);
+						run_stage("read_aiger", stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map_scratchpad abc9.map %s/output.aig", log_id(mod), tempdir_name.c_str()));
+						run_stage("reintegrate", "abc9_ops -reintegrate");
 					}
 					else
 						log("Don't call ABC as there is nothing to map.\n");
+					active_design->scratchpad_unset("abc9.map");
 
 					if (cleanup) {
 						log("Removing temp directory.\n");
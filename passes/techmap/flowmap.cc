@@ -99,6 +99,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/modtools.h"
 #include "kernel/consteval.h"
+#include "kernel/threading.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -384,11 +385,18 @@ struct FlowGraph
 		return path.back() == sink_prime;
 	}
 
+	// Only the question "is the maximum flow at most `order`?" matters to FlowMap, so the flow is
+	// never augmented past `order`. If augmentation stops early because no path is left, the flow
+	// is already maximal and the residual graph does not have to be searched a second time.
 	int maximum_flow(int order)
 	{
 		int flow = 0;
-		while (flow < order && find_augmenting_path(/*commit=*/true))
+		while (flow < order)
+		{
+			if (!find_augmenting_path(/*commit=*/true))
+				return flow;
 			flow++;
+		}
 		return flow + find_augmenting_path(/*commit=*/false);
 	}
 
@@ -448,6 +456,7 @@ struct FlowmapWorker
 	int order;
 	int r_alpha, r_beta, r_gamma;
 	bool debug, debug_relax;
+	int num_threads;
 
 	RTLIL::Module *module;
 	SigMap sigmap;
@@ -532,7 +541,18 @@ struct FlowmapWorker
 		dump_dot_graph(filename, mode, lut_and_input_nodes, lut_edges_fw, lut_gates);
 	}
 
-	pool<RTLIL::SigBit> find_subgraph(RTLIL::SigBit sink)
+	// Unlike edges_bw[node], this never inserts into edges_bw, and so is safe to call while labeling
+	// nodes on several threads.
+	const pool<RTLIL::SigBit> &node_preds(RTLIL::SigBit node) const
+	{
+		static const pool<RTLIL::SigBit> no_preds;
+		auto it = edges_bw.find(node);
+		if (it == edges_bw.end())
+			return no_preds;
+		return it->second;
+	}
+
+	pool<RTLIL::SigBit> find_subgraph(RTLIL::SigBit sink) const
 	{
 		pool<RTLIL::SigBit> subgraph;
 		pool<RTLIL::SigBit> worklist = {sink};
@@ -540,7 +560,7 @@ struct FlowmapWorker
 		{
 			auto node = worklist.pop();
 			subgraph.insert(node);
-			for (auto source : edges_bw[node])
+			for (auto source : node_preds(node))
 			{
 				if (!subgraph[source])
 					worklist.insert(source);
@@ -549,7 +569,7 @@ struct FlowmapWorker
 		return subgraph;
 	}
 
-	FlowGraph build_flow_graph(RTLIL::SigBit sink, int p)
+	FlowGraph build_flow_graph(RTLIL::SigBit sink, int p) const
 	{
 		FlowGraph flow_graph;
 		flow_graph.sink = sink;
@@ -560,14 +580,14 @@ struct FlowmapWorker
 			auto node = worklist.pop();
 			visited.insert(node);
 
-			auto collapsed_node = labels[node] == p ? sink : node;
+			auto collapsed_node = labels.at(node) == p ? sink : node;
 			if (node != collapsed_node)
 				flow_graph.collapsed[collapsed_node].insert(node);
 			flow_graph.nodes.insert(collapsed_node);
 
-			for (auto node_pred : edges_bw[node])
+			for (auto node_pred : node_preds(node))
 			{
-				auto collapsed_node_pred = labels[node_pred] == p ? sink : node_pred;
+				auto collapsed_node_pred = labels.at(node_pred) == p ? sink : node_pred;
 				if (node_pred != collapsed_node_pred)
 					flow_graph.collapsed[collapsed_node_pred].insert(node_pred);
 				if (collapsed_node != collapsed_node_pred)
@@ -575,13 +595,13 @@ struct FlowmapWorker
 					flow_graph.edges_bw[collapsed_node].insert(collapsed_node_pred);
 					flow_graph.edges_fw[collapsed_node_pred].insert(collapsed_node);
 				}
-				if (inputs[node_pred])
+				if (inputs.count(node_pred))
 				{
 					flow_graph.edges_bw[collapsed_node_pred].insert(flow_graph.source);
 					flow_graph.edges_fw[flow_graph.source].insert(collapsed_node_pred);
 				}
 
-				if (!visited[node_pred])
+				if (!visited.count(node_pred))
 					worklist.insert(node_pred);
 			}
 		}
@@ -666,6 +686,61 @@ struct FlowmapWorker
 		}
 	}
 
+	struct NodeLabeling
+	{
+		int label, flow;
+		pool<RTLIL::SigBit> x, xi, k;
+
+		// Only kept for dumping graphs in debug mode.
+		pool<RTLIL::SigBit> subgraph;
+		std::unique_ptr<FlowGraph> flow_graph;
+	};
+
+	// Computes the label and the min-height K-feasible cut of `sink`, assuming all nodes in its
+	// fanin cone are already labeled. This only reads the gate IR, so sinks whose fanin cones
+	// are labeled can be processed concurrently.
+	void compute_node_labeling(RTLIL::SigBit sink, NodeLabeling &result) const
+	{
+		// Labels never decrease along edges, so the maximum label in the fanin cone of `sink` is
+		// the maximum label of its immediate predecessors.
+		int p = 1;
+		for (auto sink_pred : node_preds(sink))
+			p = max(p, labels.at(sink_pred));
+
+		FlowGraph flow_graph = build_flow_graph(sink, p);
+		result.flow = flow_graph.maximum_flow(order);
+		if (result.flow <= order)
+		{
+			result.label = p;
+			auto cut = flow_graph.edge_cut();
+			result.x = cut.first;
+			result.xi = cut.second;
+			for (auto xi_node : result.xi)
+			{
+				for (auto xi_node_pred : node_preds(xi_node))
+					if (result.x.count(xi_node_pred))
+						result.k.insert(xi_node_pred);
+			}
+		}
+		else
+		{
+			result.label = p + 1;
+			result.xi.insert(sink);
+			result.k = node_preds(sink);
+		}
+
+		if (debug)
+		{
+			result.subgraph = find_subgraph(sink);
+			if (result.flow > order)
+			{
+				result.x = result.subgraph;
+				result.x.erase(sink);
+			}
+			result.flow_graph.reset(new FlowGraph(std::move(flow_graph)));
+		}
+	}
+
 	void label_nodes()
 	{
 		for (auto node : nodes)
@@ -678,90 +753,79 @@ struct FlowmapWorker
 				labels[input] = 0;
 		}
 
-		pool<RTLIL::SigBit> worklist = nodes;
-		int debug_num = 0;
-		while (!worklist.empty())
+		// Nodes are labeled one topological level at a time; a node becomes ready once all of its
+		// predecessors are labeled. Nodes on combinational loops never become ready, and stay unlabeled.
+		dict<RTLIL::SigBit, int> unlabeled_preds;
+		vector<RTLIL::SigBit> ready, next_ready;
+		for (auto node : nodes)
 		{
-			auto sink = worklist.pop();
-			if (labels[sink] != -1)
+			if (inputs[node])
 				continue;
+			int count = 0;
+			for (auto node_pred : node_preds(node))
+				if (!inputs[node_pred])
+					count++;
+			unlabeled_preds[node] = count;
+			if (count == 0)
+				ready.push_back(node);
+		}
 
-			bool inputs_have_labels = true;
-			for (auto sink_input : edges_bw[sink])
-			{
-				if (labels[sink_input] == -1)
-				{
-					inputs_have_labels = false;
-					break;
-				}
-			}
-			if (!inputs_have_labels)
-				continue;
+		settle_for_concurrent_reads(labels);
+		settle_for_concurrent_reads(edges_bw);
+		settle_for_concurrent_reads(inputs);
 
-			if (debug)
+		int debug_num = 0, num_levels = 0, num_labeled = 0;
+		while (!ready.empty())
+		{
+			num_levels++;
+			num_labeled += GetSize(ready);
+			vector<NodeLabeling> results(GetSize(ready));
+			parallel_for(debug ? 1 : num_threads, GetSize(ready), [&](int i) {
+				compute_node_labeling(ready[i], results[i]);
+			}, 16);
+
+			for (int i = 0; i < GetSize(ready); i++)
 			{
-				debug_num++;
-				log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
-			}
-
-			pool<RTLIL::SigBit> subgraph = find_subgraph(sink);
+				auto sink = ready[i];
+				auto &result = results[i];
 
-			int p = 1;
-			for (auto subgraph_node : subgraph)
-				p = max(p, labels[subgraph_node]);
-
-			FlowGraph flow_graph = build_flow_graph(sink, p);
-			int flow = flow_graph.maximum_flow(order);
-			pool<RTLIL::SigBit> x, xi;
-			if (flow <= order)
-			{
-				labels[sink] = p;
-				auto cut = flow_graph.edge_cut();
-				x = cut.first;
-				xi = cut.second;
-			}
-			else
-			{
-				labels[sink] = p + 1;
-				x = subgraph;
-				x.erase(sink);
-				xi.insert(sink);
-			}
-			lut_gates[sink] = xi;
+				labels[sink] = result.label;
+				lut_gates[sink] = result.xi;
+				log_assert((int)result.k.size() <= order);
+				lut_edges_bw[sink] = result.k;
+				for (auto k_node : result.k)
+					lut_edges_fw[k_node].insert(sink);
 
-			pool<RTLIL::SigBit> k;
-			for (auto xi_node : xi)
-			{
-				for (auto xi_node_pred : edges_bw[xi_node])
-					if (x[xi_node_pred])
-						k.insert(xi_node_pred);
-			}
-			log_assert((int)k.size() <= order);
-			lut_edges_bw[sink] = k;
-			for (auto k_node : k)
-				lut_edges_fw[k_node].insert(sink);
+				if (debug)
+				{
+					debug_num++;
+					log("Examining subgraph %d rooted in %s.\n", debug_num, log_signal(sink));
+					log("  Maximum flow: %d. Assigned label %d.\n", result.flow, labels[sink]);
+					dump_dot_graph(stringf("flowmap-%d-sub.dot", debug_num), GraphMode::Cut, result.subgraph, {}, {}, {result.x, result.xi});
+					log("  Dumped subgraph to `flowmap-%d-sub.dot`.\n", debug_num);
+					result.flow_graph->dump_dot_graph(stringf("flowmap-%d-flow.dot", debug_num));
+					log("  Dumped flow graph to `flowmap-%d-flow.dot`.\n", debug_num);
+					log("    LUT inputs:");
+					for (auto k_node : result.k)
+						log(" %s", log_signal(k_node));
+					log(".\n");
+					log("    LUT packed gates:");
+					for (auto xi_node : result.xi)
+						log(" %s", log_signal(xi_node));
+					log(".\n");
+				}
 
-			if (debug)
-			{
-				log("  Maximum flow: %d. Assigned label %d.\n", flow, labels[sink]);
-				dump_dot_graph(stringf("flowmap-%d-sub.dot", debug_num), GraphMode::Cut, subgraph, {}, {}, {x, xi});
-				log("  Dumped subgraph to `flowmap-%d-sub.dot`.\n", debug_num);
-				flow_graph.dump_dot_graph(stringf("flowmap-%d-flow.dot", debug_num));
-				log("  Dumped flow graph to `flowmap-%d-flow.dot`.\n", debug_num);
-				log("    LUT inputs:");
-				for (auto k_node : k)
-					log(" %s", log_signal(k_node));
-				log(".\n");
-				log("    LUT packed gates:");
-				for (auto xi_node : xi)
-					log(" %s", log_signal(xi_node));
-				log(".\n");
+				for (auto sink_succ : edges_fw[sink])
+					if (--unlabeled_preds[sink_succ] == 0)
+						next_ready.push_back(sink_succ);
 			}
 
-			for (auto sink_succ : edges_fw[sink])
-				worklist.insert(sink_succ);
+			ready.swap(next_ready);
+			next_ready.clear();
 		}
 
+		log("Labeled %d nodes in %d topological levels.\n", num_labeled, num_levels);
+
 		if (debug)
 		{
 			dump_dot_graph("flowmap-labeled.dot", GraphMode::Label);
@@ -1435,10 +1499,10 @@ struct FlowmapWorker
 	}
 
 	FlowmapWorker(int order, int minlut, pool<IdString> cell_types, int r_alpha, int r_beta, int r_gamma,
-	              bool relax, int optarea, bool debug, bool debug_relax,
+	              bool relax, int optarea, bool debug, bool debug_relax, int num_threads,
 	              RTLIL::Module *module) :
 		order(order), r_alpha(r_alpha), r_beta(r_beta), r_gamma(r_gamma), debug(debug), debug_relax(debug_relax),
-		module(module), sigmap(module), index(module)
+		num_threads(num_threads), module(module), sigmap(module), index(module)
 	{
 		log("Labeling cells.\n");
 		discover_nodes(cell_types);
@@ -1504,6 +1568,11 @@ struct FlowmapPass : public Pass {
 		log("        n may be zero, to optimize for area without increasing depth.\n");
 		log("        implies -relax.\n");
 		log("\n");
+		log("    -threads n\n");
+		log("        label nodes of the same topological level on n threads. n may be zero,\n");
+		log("        to use all available cores. if not specified, defaults to 1. the result\n");
+		log("        does not depend on the number of threads.\n");
+		log("\n");
 		log("    -debug\n");
 		log("        dump intermediate graphs.\n");
 		log("\n");
@@ -1520,6 +1589,7 @@ struct FlowmapPass : public Pass {
 		int r_alpha = 8, r_beta = 2, r_gamma = 1;
 		int optarea = 0;
 		bool debug = false, debug_relax = false;
+		int num_threads = 1;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++)
@@ -1565,6 +1635,11 @@ struct FlowmapPass : public Pass {
 				optarea = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (args[argidx] == "-threads" && argidx + 1 < args.size())
+			{
+				num_threads = yosys_parse_thread_count(args[++argidx]);
+				continue;
+			}
 			if (args[argidx] == "-debug")
 			{
 				debug = true;
@@ -1597,7 +1672,7 @@ struct FlowmapPass : public Pass {
 		int gate_area = 0, lut_area = 0;
 		for (auto module : design->selected_modules())
 		{
-			FlowmapWorker worker(order, minlut, cell_types, r_alpha, r_beta, r_gamma, relax, optarea, debug, debug_relax, module);
+			FlowmapWorker worker(order, minlut, cell_types, r_alpha, r_beta, r_gamma, relax, optarea, debug, debug_relax, num_threads, module);
 			gate_count += worker.gate_count;
 			lut_count += worker.lut_count;
 			packed_count += worker.packed_count;
@@ -0,0 +1,877 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] Priority cuts
+// Alan Mishchenko, Sungmin Cho, Satrajit Chatterjee, Robert Brayton, "Combinational and Sequential
+// Mapping with Priority Cuts," Proc. ICCAD '07, pp. 354-361, Nov. 2007.
+// doi: 10.1109/ICCAD.2007.4397290
+
+// The mapper works on an AIG that is built from the AIG models of the selected fine-grained cells
+// (see kernel/cellaigs.h). Literals are 2*node+inverted, node 0 is constant false. Nodes are
+// created in topological order, so iterating over node indices visits fanins before fanouts.
+//
+// Mapping runs in three rounds, each of which selects one "best" cut per AIG node:
+//   1. depth: cuts are ranked by arrival time, then by area flow;
+//   2. area flow: cuts are ranked by area flow among those that meet the required time;
+//   3. exact area: the cuts of the current mapping are re-chosen by the number of LUTs they
+//      actually add, using reference counting, again among those that meet the required time.
+// Required times come from the mapping found in the previous round, so the depth of round 1 is
+// preserved unless -area is given.
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/cellaigs.h"
+#include "kernel/timinginfo.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+static const int LUTMAP_MAX_LUT = 8;
+static const int LUTMAP_INF_DELAY = INT_MAX / 2;
+
+struct LutmapConfig
+{
+	int lut_size = 4;
+	int cut_limit = 8;
+	int lut_delay = 1;
+	bool area_only = false;
+	bool recovery = true;
+	bool timing = false;
+};
+
+struct LutmapCut
+{
+	int size;
+	int leaves[LUTMAP_MAX_LUT];
+	unsigned int sign;
+	int arrival;
+	float area_flow;
+
+	bool contains(const LutmapCut &other) const
+	{
+		if ((sign & other.sign) != other.sign)
+			return false;
+		for (int i = 0, j = 0; j < other.size; j++) {
+			while (i < size && leaves[i] < other.leaves[j])
+				i++;
+			if (i == size || leaves[i] != other.leaves[j])
+				return false;
+		}
+		return true;
+	}
+};
+
+struct LutmapWorker
+{
+	const LutmapConfig &config;
+	RTLIL::Module *module;
+	TimingInfo *timing;
+	SigMap sigmap;
+
+	// AIG
+	vector<int> fanin0, fanin1;
+	vector<RTLIL::SigBit> pi_bits;
+	dict<pair<int, int>, int> strash;
+	dict<RTLIL::SigBit, int> bit_lits, driver_lits;
+	vector<pair<RTLIL::SigBit, int>> outputs;
+	vector<int> input_arrival, output_required;
+
+	// Mapping state
+	vector<vector<LutmapCut>> cuts;
+	vector<int> arrival, required, refs;
+	vector<float> area_flow, est_refs;
+
+	pool<RTLIL::Cell*> mapped_cells;
+	int lut_count = 0, max_depth = 0;
+
+	LutmapWorker(const LutmapConfig &config, RTLIL::Module *module, TimingInfo *timing) :
+			config(config), module(module), timing(timing), sigmap(module)
+	{
+	}
+
+	bool is_and(int node) const
+	{
+		return fanin0[node] >= 0;
+	}
+
+	int node_count() const
+	{
+		return GetSize(fanin0);
+	}
+
+	int add_input(RTLIL::SigBit bit, int arrival_time)
+	{
+		int node = node_count();
+		fanin0.push_back(-1);
+		fanin1.push_back(-1);
+		pi_bits.push_back(bit);
+		input_arrival.push_back(arrival_time);
+		return 2*node;
+	}
+
+	int add_and(int a, int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		if (a == 0 || a == (b^1))
+			return 0;
+		if (a == 1 || a == b)
+			return b;
+
+		auto key = make_pair(a, b);
+		auto it = strash.find(key);
+		if (it != strash.end())
+			return it->second;
+
+		int node = node_count();
+		fanin0.push_back(a);
+		fanin1.push_back(b);
+		pi_bits.push_back(RTLIL::SigBit());
+		input_arrival.push_back(0);
+		strash[key] = 2*node;
+		return 2*node;
+	}
+
+	int box_output_arrival(RTLIL::SigBit bit, const dict<RTLIL::SigBit, pair<RTLIL::Cell*, TimingInfo::NameBit>> &box_outputs)
+	{
+		if (timing == nullptr)
+			return 0;
+		auto it = box_outputs.find(bit);
+		if (it == box_outputs.end())
+			return 0;
+		auto &t = timing->at(it->second.first->type).arrival;
+		return t.at(it->second.second, 0);
+	}
+
+	void build_aig(const pool<IdString> &cell_types)
+	{
+		// Constant node.
+		add_input(RTLIL::SigBit(), 0);
+
+		dict<RTLIL::SigBit, RTLIL::Cell*> bit_drivers;
+		pool<RTLIL::SigBit> used_bits;
+		dict<RTLIL::SigBit, pair<RTLIL::Cell*, TimingInfo::NameBit>> box_outputs;
+		dict<RTLIL::SigBit, int> box_inputs;
+		vector<RTLIL::Cell*> cells;
+
+		// The AIG models depend on the parameters, so they are shared by the
+		// cells with the same model name. Cells without a model are not mapped.
+		vector<Aig> aigs;
+		dict<std::string, int> aig_index;
+		dict<RTLIL::Cell*, int> cell_aig;
+
+		for (auto cell : module->cells())
+		{
+			bool mappable = module->selected(cell) && cell_types.count(cell->type) && !cell->get_bool_attribute(ID::keep);
+			if (mappable)
+			{
+				Aig aig(cell);
+				if (aig.name.empty())
+					mappable = false;
+				else {
+					auto it = aig_index.find(aig.name);
+					if (it == aig_index.end()) {
+						it = aig_index.insert(make_pair(aig.name, GetSize(aigs))).first;
+						aigs.push_back(std::move(aig));
+					}
+					cell_aig[cell] = it->second;
+				}
+			}
+			if (mappable)
+			{
+				cells.push_back(cell);
+				mapped_cells.insert(cell);
+				for (auto &conn : cell->connections())
+					if (cell->output(conn.first))
+						for (auto bit : sigmap(conn.second))
+							if (bit.wire != nullptr)
+								bit_drivers[bit] = cell;
+				continue;
+			}
+
+			bool is_box = timing != nullptr && timing->count(cell->type);
+			for (auto &conn : cell->connections())
+			{
+				// Ports of unknown direction are treated as inputs, so that nothing they read is removed.
+				bool is_output = cell->known() ? cell->output(conn.first) : false;
+				bool is_input = cell->known() ? cell->input(conn.first) : true;
+				RTLIL::SigSpec sig = sigmap(conn.second);
+				for (int i = 0; i < GetSize(sig); i++) {
+					if (sig[i].wire == nullptr)
+						continue;
+					if (is_input)
+						used_bits.insert(sig[i]);
+					if (is_box && is_output)
+						box_outputs[sig[i]] = make_pair(cell, TimingInfo::NameBit(conn.first, i));
+					if (is_box && is_input) {
+						int setup = timing->at(cell->type).required.at(TimingInfo::NameBit(conn.first, i), 0);
+						box_inputs[sig[i]] = max(box_inputs.at(sig[i], 0), setup);
+					}
+				}
+			}
+		}
+
+		for (auto wire : module->wires())
+			if (wire->port_output || wire->get_bool_attribute(ID::keep))
+				for (auto bit : sigmap(wire))
+					if (bit.wire != nullptr)
+						used_bits.insert(bit);
+
+		// Convert the cells in topological order, using an explicit stack since the logic can be
+		// arbitrarily deep. A bit that is read while the cell driving it is still being converted
+		// is on a combinational loop, and is turned into an AIG input to break the loop.
+		dict<RTLIL::Cell*, int> cell_state; // 1: being converted, 2: converted
+		for (auto root_cell : cells)
+		{
+			if (cell_state.count(root_cell))
+				continue;
+
+			vector<pair<RTLIL::Cell*, bool>> stack = {{root_cell, false}};
+			while (!stack.empty())
+			{
+				RTLIL::Cell *cell = stack.back().first;
+				bool ready = stack.back().second;
+				stack.pop_back();
+
+				if (!ready)
+				{
+					if (cell_state.count(cell))
+						continue;
+					cell_state[cell] = 1;
+					stack.push_back({cell, true});
+					for (auto &conn : cell->connections())
+					{
+						if (!cell->input(conn.first))
+							continue;
+						for (auto bit : sigmap(conn.second))
+						{
+							auto it = bit_drivers.find(bit);
+							if (it == bit_drivers.end())
+								continue;
+							auto state = cell_state.find(it->second);
+							if (state == cell_state.end())
+								stack.push_back({it->second, false});
+							else if (state->second == 1 && !bit_lits.count(bit)) {
+								log_warning("Breaking combinational loop at %s in module %s.\n", log_signal(bit), log_id(module));
+								bit_lits[bit] = add_input(bit, 0);
+								used_bits.insert(bit);
+							}
+						}
+					}
+					continue;
+				}
+
+				const Aig &aig = aigs[cell_aig.at(cell)];
+
+				vector<int> node_lits(GetSize(aig.nodes));
+				for (int i = 0; i < GetSize(aig.nodes); i++)
+				{
+					const AigNode &node = aig.nodes[i];
+					int lit;
+					if (node.portbit >= 0)
+						lit = bit_lit(cell->getPort(node.portname)[node.portbit], box_outputs);
+					else if (node.left_parent < 0)
+						lit = 0;
+					else
+						lit = add_and(node_lits[node.left_parent], node_lits[node.right_parent]);
+					if (node.inverter)
+						lit ^= 1;
+					node_lits[i] = lit;
+
+					for (auto &outport : node.outports)
+					{
+						RTLIL::SigBit bit = sigmap(cell->getPort(outport.first)[outport.second]);
+						if (bit.wire == nullptr)
+							continue;
+						driver_lits[bit] = lit;
+						if (!bit_lits.count(bit))
+							bit_lits[bit] = lit;
+					}
+				}
+				cell_state[cell] = 2;
+			}
+		}
+
+		for (auto &it : driver_lits)
+			if (used_bits.count(it.first)) {
+				outputs.push_back(it);
+				output_required.push_back(box_inputs.at(it.first, 0));
+			}
+	}
+
+	int bit_lit(RTLIL::SigBit bit, const dict<RTLIL::SigBit, pair<RTLIL::Cell*, TimingInfo::NameBit>> &box_outputs)
+	{
+		bit = sigmap(bit);
+		if (bit.wire == nullptr)
+			return bit == State::S1 ? 1 : 0;
+		auto it = bit_lits.find(bit);
+		if (it != bit_lits.end())
+			return it->second;
+		int lit = add_input(bit, box_output_arrival(bit, box_outputs));
+		bit_lits[bit] = lit;
+		return lit;
+	}
+
+	// ----- cut enumeration -----
+
+	static bool merge_cuts(const LutmapCut &a, const LutmapCut &b, int lut_size, LutmapCut &result)
+	{
+		unsigned int sign = a.sign | b.sign;
+		int bits = 0;
+		for (unsigned int s = sign; s; s &= s - 1)
+			bits++;
+		if (bits > lut_size)
+			return false;
+
+		int i = 0, j = 0, k = 0;
+		while (i < a.size || j < b.size)
+		{
+			if (k == lut_size)
+				return false;
+			if (j == b.size || (i < a.size && a.leaves[i] < b.leaves[j]))
+				result.leaves[k++] = a.leaves[i++];
+			else if (i == a.size || b.leaves[j] < a.leaves[i])
+				result.leaves[k++] = b.leaves[j++];
+			else
+				result.leaves[k++] = a.leaves[i++], j++;
+		}
+		result.size = k;
+		result.sign = sign;
+		return true;
+	}
+
+	static LutmapCut trivial_cut(int node)
+	{
+		LutmapCut cut;
+		cut.size = 1;
+		cut.leaves[0] = node;
+		cut.sign = 1u << (node % 32);
+		cut.arrival = 0;
+		cut.area_flow = 0;
+		return cut;
+	}
+
+	void evaluate_cut(LutmapCut &cut)
+	{
+		cut.arrival = 0;
+		cut.area_flow = 1;
+		for (int i = 0; i < cut.size; i++) {
+			int leaf = cut.leaves[i];
+			cut.arrival = max(cut.arrival, arrival[leaf]);
+			cut.area_flow += area_flow[leaf];
+		}
+		cut.arrival += config.lut_delay;
+	}
+
+	bool cut_better(const LutmapCut &a, const LutmapCut &b, int node_required, bool by_area) const
+	{
+		if (by_area) {
+			bool a_ok = a.arrival <= node_required, b_ok = b.arrival <= node_required;
+			if (a_ok != b_ok)
+				return a_ok;
+			if (!a_ok && a.arrival != b.arrival)
+				return a.arrival < b.arrival;
+			if (a.area_flow != b.area_flow)
+				return a.area_flow < b.area_flow;
+			if (a.arrival != b.arrival)
+				return a.arrival < b.arrival;
+		} else {
+			if (a.arrival != b.arrival)
+				return a.arrival < b.arrival;
+			if (a.area_flow != b.area_flow)
+				return a.area_flow < b.area_flow;
+		}
+		return a.size < b.size;
+	}
+
+	void update_node_metrics(int node)
+	{
+		const LutmapCut &best = cuts[node].front();
+		arrival[node] = best.arrival;
+		area_flow[node] = best.area_flow / max(1.0f, est_refs[node]);
+	}
+
+	// Computes the priority cuts of every node. The first cut of every AND node is its best cut,
+	// the last cut of every node is its trivial cut, which is only used for merging.
+	//
+	// The best cut of the previous round is always a candidate. Since it met the required time in
+	// the previous round, this guarantees that a cut meeting the required time exists.
+	void enumerate_cuts(bool by_area)
+	{
+		vector<LutmapCut> previous_best;
+		for (auto &node_cuts : cuts)
+			previous_best.push_back(node_cuts.front());
+		cuts.clear();
+		cuts.resize(node_count());
+
+		vector<LutmapCut> candidates;
+		for (int node = 0; node < node_count(); node++)
+		{
+			if (!is_and(node)) {
+				arrival[node] = input_arrival[node];
+				area_flow[node] = 0;
+				cuts[node].push_back(trivial_cut(node));
+				continue;
+			}
+
+			candidates.clear();
+			const auto &cuts0 = cuts[fanin0[node] >> 1];
+			const auto &cuts1 = cuts[fanin1[node] >> 1];
+			for (auto &cut0 : cuts0)
+				for (auto &cut1 : cuts1) {
+					LutmapCut cut;
+					if (!merge_cuts(cut0, cut1, config.lut_size, cut))
+						continue;
+					evaluate_cut(cut);
+					candidates.push_back(cut);
+				}
+			if (!previous_best.empty()) {
+				candidates.push_back(previous_best[node]);
+				evaluate_cut(candidates.back());
+			}
+			log_assert(!candidates.empty());
+
+			int node_required = required[node];
+			std::sort(candidates.begin(), candidates.end(), [&](const LutmapCut &a, const LutmapCut &b) {
+				return cut_better(a, b, node_required, by_area);
+			});
+
+			auto &node_cuts = cuts[node];
+			for (auto &cut : candidates)
+			{
+				if (GetSize(node_cuts) == config.cut_limit)
+					break;
+				bool dominated = false;
+				for (auto &kept : node_cuts)
+					if (cut.contains(kept)) {
+						dominated = true;
+						break;
+					}
+				if (!dominated)
+					node_cuts.push_back(cut);
+			}
+
+			update_node_metrics(node);
+			node_cuts.push_back(trivial_cut(node));
+		}
+	}
+
+	// ----- mapping -----
+
+	// Marks the nodes used by the current mapping and computes their required times.
+	void select_mapping()
+	{
+		refs.assign(node_count(), 0);
+		for (auto &output : outputs)
+			refs[output.second >> 1]++;
+		for (int node = node_count() - 1; node > 0; node--)
+			if (is_and(node) && refs[node] > 0) {
+				auto &best = cuts[node].front();
+				for (int i = 0; i < best.size; i++)
+					refs[best.leaves[i]]++;
+			}
+
+		int target = 0;
+		for (int i = 0; i < GetSize(outputs); i++)
+			target = max(target, arrival[outputs[i].second >> 1] + output_required[i]);
+		if (config.area_only)
+			target = LUTMAP_INF_DELAY;
+		max_depth = 0;
+
+		required.assign(node_count(), LUTMAP_INF_DELAY);
+		for (int i = 0; i < GetSize(outputs); i++) {
+			int node = outputs[i].second >> 1;
+			required[node] = min(required[node], target - output_required[i]);
+		}
+		for (int node = node_count() - 1; node > 0; node--)
+			if (is_and(node) && refs[node] > 0) {
+				max_depth = max(max_depth, arrival[node]);
+				auto &best = cuts[node].front();
+				for (int i = 0; i < best.size; i++) {
+					int leaf = best.leaves[i];
+					required[leaf] = min(required[leaf], required[node] - config.lut_delay);
+				}
+			}
+
+		for (int node = 0; node < node_count(); node++)
+			est_refs[node] = (2 * est_refs[node] + max(1, refs[node])) / 3;
+	}
+
+	// Adds (or removes) the references of `cut`, recursively (de)referencing the cuts of nodes whose
+	// reference count goes from (or to) zero. Returns the number of LUTs involved.
+	int reference_cut(const LutmapCut &cut, bool add)
+	{
+		int area = 1;
+		vector<int> stack(cut.leaves, cut.leaves + cut.size);
+		while (!stack.empty())
+		{
+			int node = stack.back();
+			stack.pop_back();
+			if (!is_and(node))
+				continue;
+			if (add ? refs[node]++ != 0 : --refs[node] != 0)
+				continue;
+			area++;
+			auto &best = cuts[node].front();
+			stack.insert(stack.end(), best.leaves, best.leaves + best.size);
+		}
+		return area;
+	}
+
+	void recover_exact_area()
+	{
+		for (int node = 0; node < node_count(); node++)
+		{
+			if (!is_and(node)) {
+				arrival[node] = input_arrival[node];
+				continue;
+			}
+
+			auto &node_cuts = cuts[node];
+			for (int i = 0; i < GetSize(node_cuts) - 1; i++)
+				evaluate_cut(node_cuts[i]);
+
+			if (refs[node] == 0) {
+				arrival[node] = node_cuts.front().arrival;
+				continue;
+			}
+
+			reference_cut(node_cuts.front(), false);
+			int best_index = -1, best_area = INT_MAX;
+			for (int i = 0; i < GetSize(node_cuts) - 1; i++)
+			{
+				auto &cut = node_cuts[i];
+				if (cut.arrival > required[node])
+					continue;
+				int area = reference_cut(cut, true);
+				reference_cut(cut, false);
+				if (area < best_area || (area == best_area && cut.arrival < node_cuts[best_index].arrival)) {
+					best_index = i;
+					best_area = area;
+				}
+			}
+			if (best_index < 0) {
+				best_index = 0;
+				for (int i = 1; i < GetSize(node_cuts) - 1; i++)
+					if (node_cuts[i].arrival < node_cuts[best_index].arrival)
+						best_index = i;
+			}
+			std::swap(node_cuts[0], node_cuts[best_index]);
+			reference_cut(node_cuts.front(), true);
+			arrival[node] = node_cuts.front().arrival;
+		}
+	}
+
+	void map()
+	{
+		arrival.assign(node_count(), 0);
+		area_flow.assign(node_count(), 0);
+		required.assign(node_count(), LUTMAP_INF_DELAY);
+		est_refs.assign(node_count(), 0);
+		for (int node = 0; node < node_count(); node++)
+			if (is_and(node)) {
+				est_refs[fanin0[node] >> 1] += 1;
+				est_refs[fanin1[node] >> 1] += 1;
+			}
+		for (auto &output : outputs)
+			est_refs[output.second >> 1] += 1;
+
+		enumerate_cuts(config.area_only);
+		select_mapping();
+		log("  Depth-oriented mapping: %d LUTs, depth %d.\n", count_luts(), max_depth);
+
+		if (!config.recovery)
+			return;
+
+		enumerate_cuts(true);
+		select_mapping();
+		log("  Area flow recovery: %d LUTs, depth %d.\n", count_luts(), max_depth);
+
+		recover_exact_area();
+		select_mapping();
+		log("  Exact area recovery: %d LUTs, depth %d.\n", count_luts(), max_depth);
+	}
+
+	int count_luts() const
+	{
+		int count = 0;
+		for (int node = 1; node < node_count(); node++)
+			if (is_and(node) && refs[node] > 0)
+				count++;
+		return count;
+	}
+
+	// ----- netlist generation -----
+
+	RTLIL::Const cut_truth_table(int root, const LutmapCut &cut) const
+	{
+		int num_words = cut.size > 6 ? 1 << (cut.size - 6) : 1;
+		dict<int, vector<uint64_t>> tables;
+		static const uint64_t projections[6] = {
+			0xaaaaaaaaaaaaaaaaull, 0xccccccccccccccccull, 0xf0f0f0f0f0f0f0f0ull,
+			0xff00ff00ff00ff00ull, 0xffff0000ffff0000ull, 0xffffffff00000000ull,
+		};
+		for (int i = 0; i < cut.size; i++) {
+			vector<uint64_t> table(num_words);
+			for (int w = 0; w < num_words; w++)
+				table[w] = i < 6 ? projections[i] : ((w >> (i - 6)) & 1) ? ~0ull : 0ull;
+			tables[cut.leaves[i]] = table;
+		}
+
+		vector<int> cone;
+		vector<int> stack = {root};
+		pool<int> visited;
+		while (!stack.empty()) {
+			int node = stack.back();
+			stack.pop_back();
+			if (tables.count(node) || visited.count(node))
+				continue;
+			visited.insert(node);
+			cone.push_back(node);
+			stack.push_back(fanin0[node] >> 1);
+			stack.push_back(fanin1[node] >> 1);
+		}
+		std::sort(cone.begin(), cone.end());
+
+		for (int node : cone) {
+			const auto &table0 = tables.at(fanin0[node] >> 1);
+			const auto &table1 = tables.at(fanin1[node] >> 1);
+			uint64_t inv0 = (fanin0[node] & 1) ? ~0ull : 0ull;
+			uint64_t inv1 = (fanin1[node] & 1) ? ~0ull : 0ull;
+			vector<uint64_t> table(num_words);
+			for (int w = 0; w < num_words; w++)
+				table[w] = (table0[w] ^ inv0) & (table1[w] ^ inv1);
+			tables[node] = table;
+		}
+
+		const auto &result = tables.at(root);
+		RTLIL::Const value(State::S0, 1 << cut.size);
+		for (int i = 0; i < GetSize(value); i++)
+			if ((result[i / 64] >> (i % 64)) & 1)
+				value[i] = State::S1;
+		return value;
+	}
+
+	void emit()
+	{
+		dict<int, RTLIL::SigBit> lit_signals;
+		dict<int, RTLIL::SigBit> preferred_signals;
+		for (auto &output : outputs)
+			if (!preferred_signals.count(output.second))
+				preferred_signals[output.second] = output.first;
+
+		std::function<RTLIL::SigBit(int)> lit_signal;
+		auto make_lut = [&](int lit, RTLIL::SigBit y, RTLIL::SigSpec a, RTLIL::Const table) {
+			if (lit & 1)
+				for (auto &bit : table.bits)
+					bit = bit == State::S1 ? State::S0 : State::S1;
+			module->addLut(NEW_ID, a, y, table);
+			lut_count++;
+		};
+		lit_signal = [&](int lit) -> RTLIL::SigBit {
+			if (lit < 2)
+				return lit ? State::S1 : State::S0;
+			auto it = lit_signals.find(lit);
+			if (it != lit_signals.end())
+				return it->second;
+
+			int node = lit >> 1;
+			RTLIL::SigBit y = preferred_signals.count(lit) ? preferred_signals.at(lit) : RTLIL::SigBit(module->addWire(NEW_ID));
+			lit_signals[lit] = y;
+			if (!is_and(node)) {
+				if (lit & 1)
+					make_lut(lit, y, pi_bits[node], RTLIL::Const::from_string("10"));
+				else if (y != pi_bits[node])
+					module->connect(y, pi_bits[node]);
+				return y;
+			}
+
+			const LutmapCut &cut = cuts[node].front();
+			RTLIL::SigSpec a;
+			for (int i = 0; i < cut.size; i++)
+				a.append(lit_signal(2*cut.leaves[i]));
+			make_lut(lit, y, a, cut_truth_table(node, cut));
+			return y;
+		};
+
+		// lit_signal() recurses into the LUT inputs, so create the LUTs used as inputs of other LUTs
+		// bottom-up first to keep the recursion shallow.
+		vector<bool> needs_positive(node_count());
+		for (int node = 1; node < node_count(); node++)
+			if (is_and(node) && refs[node] > 0) {
+				auto &cut = cuts[node].front();
+				for (int i = 0; i < cut.size; i++)
+					needs_positive[cut.leaves[i]] = true;
+			}
+		for (int node = 1; node < node_count(); node++)
+			if (needs_positive[node])
+				lit_signal(2*node);
+
+		for (auto cell : mapped_cells)
+			module->remove(cell);
+
+		for (auto &output : outputs) {
+			RTLIL::SigBit y = lit_signal(output.second);
+			if (y != output.first)
+				module->connect(output.first, y);
+		}
+	}
+
+	void run(const pool<IdString> &cell_types)
+	{
+		build_aig(cell_types);
+		log("Module %s: %d cells, %d AIG nodes, %d inputs, %d outputs.\n", log_id(module), GetSize(mapped_cells),
+				node_count(), GetSize(pi_bits) - GetSize(strash) - 1, GetSize(outputs));
+		if (mapped_cells.empty())
+			return;
+		map();
+		emit();
+	}
+};
+
+struct LutmapPass : public Pass {
+	LutmapPass() : Pass("lutmap", "map gates to LUTs using priority cuts") { }
+	void help() YS_OVERRIDE
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    lutmap [options] [selection]\n");
+		log("\n");
+		log("This pass maps the selected fine-grained logic cells ($_AND_, $_OR_, $_XOR_,\n");
+		log("$_MUX_, ...) to $lut cells using cut enumeration with priority cuts, without\n");
+		log("calling an external tool. It first finds a mapping with minimal depth and then\n");
+		log("recovers area without increasing the depth, using area flow and exact local\n");
+		log("area heuristics.\n");
+		log("\n");
+		log("    -lut <k>\n");
+		log("        map to k-input LUTs (2 <= k <= %d). if not specified, defaults to 4.\n", LUTMAP_MAX_LUT);
+		log("\n");
+		log("    -cuts <n>\n");
+		log("        number of priority cuts kept per node. larger values can give better\n");
+		log("        results at the cost of runtime. if not specified, defaults to 8.\n");
+		log("\n");
+		log("    -area\n");
+		log("        minimize the number of LUTs without any depth constraint.\n");
+		log("\n");
+		log("    -norecovery\n");
+		log("        do not perform area recovery, only use the depth-oriented mapping.\n");
+		log("\n");
+		log("    -timing\n");
+		log("        take arrival and setup times into account for cells that instantiate\n");
+		log("        blackbox modules with specify blocks (see 'read_verilog -specify').\n");
+		log("        the outputs of such cells arrive at their $specify3 delays, and their\n");
+		log("        inputs are required earlier by their $setup limits.\n");
+		log("\n");
+		log("    -delay <d>\n");
+		log("        delay of a single LUT, in the units used by the specify blocks. if not\n");
+		log("        specified, defaults to 1, so that without -timing the delay of the\n");
+		log("        mapping is its depth in LUTs.\n");
+		log("\n");
+		log("    -cells <cell>[,<cell>,...]\n");
+		log("        map only the specified cell types. only cells with an AIG model (see\n");
+		log("        kernel/cellaigs.cc) are mapped, other cells are left unchanged.\n");
+		log("\n");
+		log("Cells with the 'keep' attribute are not mapped.\n");
+		log("\n");
+	}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
+	{
+		LutmapConfig config;
+		pool<IdString> cell_types = {
+			ID($_BUF_), ID($_NOT_), ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_),
+			ID($_ANDNOT_), ID($_ORNOT_), ID($_MUX_), ID($_AOI3_), ID($_OAI3_), ID($_AOI4_), ID($_OAI4_)
+		};
+
+		log_header(design, "Executing LUTMAP pass (map gates to LUTs using priority cuts).\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			if (args[argidx] == "-lut" && argidx+1 < args.size()) {
+				config.lut_size = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-cuts" && argidx+1 < args.size()) {
+				config.cut_limit = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-area") {
+				config.area_only = true;
+				continue;
+			}
+			if (args[argidx] == "-norecovery") {
+				config.recovery = false;
+				continue;
+			}
+			if (args[argidx] == "-timing") {
+				config.timing = true;
+				continue;
+			}
+			if (args[argidx] == "-delay" && argidx+1 < args.size()) {
+				config.lut_delay = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-cells" && argidx+1 < args.size()) {
+				cell_types.clear();
+				for (auto &type : split_tokens(args[++argidx], ","))
+					cell_types.insert(RTLIL::escape_id(type));
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (config.lut_size < 2 || config.lut_size > LUTMAP_MAX_LUT)
+			log_cmd_error("LUT size must be between 2 and %d.\n", LUTMAP_MAX_LUT);
+		if (config.cut_limit < 1)
+			log_cmd_error("Number of priority cuts must be at least 1.\n");
+		if (config.lut_delay < 1)
+			log_cmd_error("LUT delay must be at least 1.\n");
+
+		TimingInfo timing;
+		if (config.timing)
+		{
+			for (auto module : design->selected_modules())
+				for (auto cell : module->cells()) {
+					RTLIL::Module *inst_module = design->module(cell->type);
+					if (inst_module == nullptr || !inst_module->get_blackbox_attribute() || timing.count(cell->type))
+						continue;
+					if (!cell->parameters.empty())
+						log_warning("Ignoring parameters of %s.%s for timing purposes.\n", log_id(module), log_id(cell));
+					timing.setup_module(inst_module);
+				}
+		}
+
+		int total_luts = 0, total_cells = 0;
+		for (auto module : design->selected_modules())
+		{
+			if (module->has_processes_warn())
+				continue;
+
+			LutmapWorker worker(config, module, config.timing ? &timing : nullptr);
+			worker.run(cell_types);
+			total_cells += GetSize(worker.mapped_cells);
+			total_luts += worker.lut_count;
+		}
+
+		log("Mapped %d cells to %d LUTs.\n", total_cells, total_luts);
+	}
+} LutmapPass;
+
+PRIVATE_NAMESPACE_END
@@ -21,6 +21,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/rtlil.h"
 #include "kernel/log.h"
+#include "passes/cmds/synth_cache.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -81,13 +82,19 @@ struct SynthPass : public ScriptPass
 		log("    -flowmap\n");
 		log("        use FlowMap LUT techmapping instead of ABC\n");
 		log("\n");
+		log("    -incremental <dir>\n");
+		log("        reuse the synthesized netlists of modules that did not change since\n");
+		log("        an earlier run with the same options, and store the netlists of all\n");
+		log("        other modules in <dir> (see 'help synth_cache'). not supported with\n");
+		log("        -flatten or -run.\n");
+		log("\n");
 		log("\n");
 		log("The following commands are executed by this synthesis command:\n");
 		help_script();
 		log("\n");
 	}
 
-	string top_module, fsm_opts, memory_opts, abc;
+	string top_module, fsm_opts, memory_opts, abc, incremental_dir, incremental_key;
 	bool autotop, flatten, noalumacc, nofsm, noabc, noshare, flowmap;
 	int lut;
 
@@ -96,6 +103,8 @@ struct SynthPass : public ScriptPass
 		top_module.clear();
 		fsm_opts.clear();
 		memory_opts.clear();
+		incremental_dir.clear();
+		incremental_key.clear();
 
 		autotop = false;
 		flatten = false;
@@ -175,10 +184,22 @@ struct SynthPass : public ScriptPass
 				flowmap = true;
 				continue;
 			}
+			if (args[argidx] == "-incremental" && argidx+1 < args.size()) {
+				incremental_dir = args[++argidx];
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
+		if (!incremental_dir.empty()) {
+			if (flatten)
+				log_cmd_error("-incremental cannot be combined with -flatten.\n");
+			if (!run_from.empty() || !run_to.empty())
+				log_cmd_error("-incremental cannot be combined with -run.\n");
+			incremental_key = synth_cache_key(args);
+		}
+
 		if (!design->full_selection())
 			log_cmd_error("This command only operates on fully selected designs!\n");
 
@@ -210,6 +231,10 @@ struct SynthPass : public ScriptPass
 				} else
 					run(stringf("hierarchy -check -top %s", top_module.c_str()));
 			}
+			if (help_mode)
+				run("synth_cache -lookup <dir> -key <options>", "(if -incremental)");
+			else if (!incremental_dir.empty())
+				run(stringf("synth_cache -lookup %s -key %s", incremental_dir.c_str(), incremental_key.c_str()));
 		}
 
 		if (check_label("coarse"))
@@ -284,6 +309,8 @@ struct SynthPass : public ScriptPass
 
 		if (check_label("check"))
 		{
+			if (help_mode || !incremental_dir.empty())
+				run(stringf("synth_cache -restore %s", help_mode ? "<dir>" : incremental_dir.c_str()), "(if -incremental)");
 			run("hierarchy -check");
 			run("stat");
 			run("check");
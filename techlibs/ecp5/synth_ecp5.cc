@@ -88,6 +88,10 @@ struct SynthEcp5Pass : public ScriptPass
 		log("    -abc9\n");
 		log("        use new ABC9 flow (EXPERIMENTAL)\n");
 		log("\n");
+		log("    -lutmap\n");
+		log("        use the built-in priority cut LUT mapper instead of abc (EXPERIMENTAL)\n");
+		log("        only LUT4 cells are produced in this mode\n");
+		log("\n");
 		log("    -vpr\n");
 		log("        generate an output netlist (and BLIF file) suitable for VPR\n");
 		log("        (this feature is experimental and incomplete)\n");
@@ -102,7 +106,7 @@ struct SynthEcp5Pass : public ScriptPass
 	}
 
 	string top_opt, blif_file, edif_file, json_file;
-	bool noccu2, nodffe, nobram, nolutram, nowidelut, asyncprld, flatten, retime, abc2, abc9, nodsp, vpr;
+	bool noccu2, nodffe, nobram, nolutram, nowidelut, asyncprld, flatten, retime, abc2, abc9, nodsp, vpr, lutmap;
 
 	void clear_flags() YS_OVERRIDE
 	{
@@ -121,6 +125,7 @@ struct SynthEcp5Pass : public ScriptPass
 		abc2 = false;
 		vpr = false;
 		abc9 = false;
+		lutmap = false;
 		nodsp = false;
 	}
 
@@ -208,6 +213,10 @@ struct SynthEcp5Pass : public ScriptPass
 				nodsp = true;
 				continue;
 			}
+			if (args[argidx] == "-lutmap") {
+				lutmap = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -217,6 +226,8 @@ struct SynthEcp5Pass : public ScriptPass
 
 		if (abc9 && retime)
 				log_cmd_error("-retime option not currently compatible with -abc9!\n");
+		if (abc9 && lutmap)
+				log_cmd_error("-lutmap is incompatible with -abc9!\n");
 
 		log_header(design, "Executing SYNTH_ECP5 pass.\n");
 		log_push();
@@ -328,6 +339,9 @@ struct SynthEcp5Pass : public ScriptPass
 				else
 					run("abc9 -W 200");
 				run("techmap -map +/ecp5/abc9_unmap.v");
+			} else if (lutmap) {
+				run("simplemap");
+				run("lutmap -lut 4");
 			} else {
 				if (nowidelut)
 					run("abc -lut 4 -dress");
@@ -99,6 +99,9 @@ struct SynthIce40Pass : public ScriptPass
         log("    -flowmap\n");
         log("        use FlowMap LUT techmapping instead of abc (EXPERIMENTAL)\n");
         log("\n");
+		log("    -lutmap\n");
+		log("        use the built-in priority cut LUT mapper instead of abc (EXPERIMENTAL)\n");
+		log("\n");
 		log("\n");
 		log("The following commands are executed by this synthesis command:\n");
 		help_script();
@@ -106,7 +109,7 @@ struct SynthIce40Pass : public ScriptPass
 	}
 
 	string top_opt, blif_file, edif_file, json_file, device_opt;
-	bool nocarry, nodffe, nobram, dsp, flatten, retime, noabc, abc2, vpr, abc9, flowmap;
+	bool nocarry, nodffe, nobram, dsp, flatten, retime, noabc, abc2, vpr, abc9, flowmap, lutmap;
 	int min_ce_use;
 
 	void clear_flags() YS_OVERRIDE
@@ -127,6 +130,7 @@ struct SynthIce40Pass : public ScriptPass
 		vpr = false;
 		abc9 = false;
         flowmap = false;
+		lutmap = false;
 		device_opt = "hx";
 	}
 
@@ -222,6 +226,10 @@ struct SynthIce40Pass : public ScriptPass
                 flowmap = true;
                 continue;
             }
+			if (args[argidx] == "-lutmap") {
+				lutmap = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -240,6 +248,8 @@ struct SynthIce40Pass : public ScriptPass
             log_cmd_error("-abc9 is incompatible with -flowmap!\n");
         if (flowmap && noabc)
             log_cmd_error("-flowmap is incompatible with -noabc!\n");
+		if (lutmap && (noabc || abc9 || flowmap))
+			log_cmd_error("-lutmap is incompatible with -noabc, -abc9 and -flowmap!\n");
 
 		log_header(design, "Executing SYNTH_ICE40 pass.\n");
 		log_push();
@@ -362,14 +372,16 @@ struct SynthIce40Pass : public ScriptPass
 				run("ice40_opt", "(only if -abc2)");
 			}
 			run("techmap -map +/ice40/latches_map.v");
-			if (noabc || flowmap || help_mode) {
-				run("simplemap", "                               (if -noabc or -flowmap)");
+			if (noabc || flowmap || lutmap || help_mode) {
+				run("simplemap", "                               (if -noabc, -flowmap or -lutmap)");
                 if (noabc || help_mode)
 				    run("techmap -map +/gate2lut.v -D LUT_WIDTH=4", "(only if -noabc)");
                 if (flowmap || help_mode)
                     run("flowmap -maxlut 4", "(only if -flowmap)");
+				if (lutmap || help_mode)
+					run("lutmap -lut 4", "(only if -lutmap)");
 			}
-			if (!noabc) {
+			if (!noabc && !lutmap) {
 				if (abc9) {
 					run("read_verilog " + define + " -icells -lib -specify +/abc9_model.v +/ice40/abc9_model.v");
 					int wire_delay;
@@ -382,7 +394,7 @@ struct SynthIce40Pass : public ScriptPass
 					run(stringf("abc9 -W %d", wire_delay));
 				}
 				else
-					run("abc -dress -lut 4", "(skip if -noabc)");
+					run("abc -dress -lut 4", "(skip if -noabc or -lutmap)");
 			}
 			run("ice40_wrapcarry -unwrap");
 			run("techmap -D NO_LUT -map +/ice40/cells_map.v");
@@ -22,6 +22,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/rtlil.h"
 #include "kernel/log.h"
+#include "passes/cmds/synth_cache.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -135,13 +136,19 @@ struct SynthXilinxPass : public ScriptPass
 		log("    -abc9\n");
 		log("        use new ABC9 flow (EXPERIMENTAL)\n");
 		log("\n");
+		log("    -incremental <dir>\n");
+		log("        reuse the synthesized netlists of modules that did not change since\n");
+		log("        an earlier run with the same options, and store the netlists of all\n");
+		log("        other modules in <dir> (see 'help synth_cache'). not supported with\n");
+		log("        -flatten, -flatten_before_abc or -run.\n");
+		log("\n");
 		log("\n");
 		log("The following commands are executed by this synthesis command:\n");
 		help_script();
 		log("\n");
 	}
 
-	std::string top_opt, edif_file, blif_file, family;
+	std::string top_opt, edif_file, blif_file, family, incremental_dir, incremental_key;
 	bool flatten, retime, vpr, ise, noiopad, noclkbuf, nobram, nolutram, nosrl, nocarry, nowidelut, nodsp, uram;
 	bool abc9, dff_mode;
 	bool flatten_before_abc;
@@ -155,6 +162,8 @@ struct SynthXilinxPass : public ScriptPass
 		edif_file.clear();
 		blif_file.clear();
 		family = "xc7";
+		incremental_dir.clear();
+		incremental_key.clear();
 		flatten = false;
 		retime = false;
 		vpr = false;
@@ -216,6 +225,10 @@ struct SynthXilinxPass : public ScriptPass
 				flatten_before_abc = true;
 				continue;
 			}
+			if (args[argidx] == "-incremental" && argidx+1 < args.size()) {
+				incremental_dir = args[++argidx];
+				continue;
+			}
 			if (args[argidx] == "-retime") {
 				dff_mode = true;
 				retime = true;
@@ -329,6 +342,14 @@ struct SynthXilinxPass : public ScriptPass
 		if (abc9 && retime)
 			log_cmd_error("-retime option not currently compatible with -abc9!\n");
 
+		if (!incremental_dir.empty()) {
+			if (flatten || flatten_before_abc)
+				log_cmd_error("-incremental option not compatible with -flatten or -flatten_before_abc!\n");
+			if (!run_from.empty() || !run_to.empty())
+				log_cmd_error("-incremental option not compatible with -run!\n");
+			incremental_key = synth_cache_key(args);
+		}
+
 		log_header(design, "Executing SYNTH_XILINX pass.\n");
 		log_push();
 
@@ -360,6 +381,11 @@ struct SynthXilinxPass : public ScriptPass
 			run("read_verilog -lib +/xilinx/cells_xtra.v");
 
 			run(stringf("hierarchy -check %s", top_opt.c_str()));
+
+			if (help_mode)
+				run("synth_cache -lookup <dir> -key <options>", "(only if '-incremental')");
+			else if (!incremental_dir.empty())
+				run(stringf("synth_cache -lookup %s -key %s", incremental_dir.c_str(), incremental_key.c_str()));
 		}
 
 		if (check_label("prepare")) {
@@ -675,6 +701,10 @@ struct SynthXilinxPass : public ScriptPass
 		}
 
 		if (check_label("finalize")) {
+			// Restore cached modules before clkbufmap, which needs to see the
+			// clock sinks inside of submodules.
+			if (help_mode || !incremental_dir.empty())
+				run(stringf("synth_cache -restore %s", help_mode ? "<dir>" : incremental_dir.c_str()), "(only if '-incremental')");
 			if (help_mode || !noclkbuf)
 				run("clkbufmap -buf BUFG O:I", "(skip if '-noclkbuf')");
 			if (help_mode || ise)
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+# abc: the mapped netlist is read back over a pipe, or from the temp dir with
+# -nocleanup, and the temp dir is removed when ABC fails. A stand-in for ABC
+# "maps" the design by returning its input netlist unchanged.
+
+set -e
+
+cat > abc_pipe.il << 'EOT'
+module \top
+  wire input 1 \a
+  wire input 2 \b
+  wire input 3 \c
+  wire output 4 \x
+  wire output 5 \y
+  wire \t
+  cell $_AND_ $and$1
+    connect \A \a
+    connect \B \b
+    connect \Y \t
+  end
+  cell $_XOR_ $xor$1
+    connect \A \t
+    connect \B \c
+    connect \Y \x
+  end
+  cell $_OR_ $or$1
+    connect \A \a
+    connect \B \c
+    connect \Y \y
+  end
+end
+EOT
+
+cat > abc_pipe_exe.sh << 'EOT'
+#!/usr/bin/env bash
+# called as: abc -s -f <tempdir>/abc.script
+dir=$(dirname "$3")
+echo "$dir" > abc_pipe.tempdir
+if [ -z "$ABC_PIPE_FAIL" ]; then
+	cp "$dir/input.blif" "$(sed -n 's/^write_blif //p' "$3")"
+fi
+EOT
+chmod +x abc_pipe_exe.sh
+
+for args in "" "-nocleanup"; do
+	../../yosys -p "read_ilang abc_pipe.il; equiv_opt -assert abc -exe ./abc_pipe_exe.sh $args; design -load postopt; select -assert-none t:\$_AND_ t:\$_XOR_ t:\$_OR_; select -assert-count 3 t:\$lut" > abc_pipe.log
+	if [ -n "$args" ]; then
+		test -f "$(cat abc_pipe.tempdir)/output.blif"
+		rm -rf "$(cat abc_pipe.tempdir)"
+	else
+		test ! -e "$(cat abc_pipe.tempdir)"
+	fi
+done
+
+if ABC_PIPE_FAIL=1 ../../yosys -p "read_ilang abc_pipe.il; abc -exe ./abc_pipe_exe.sh" > abc_pipe.log 2>&1; then
+	exit 1
+fi
+grep -q "ERROR: ABC did not write a mapped netlist." abc_pipe.log
+test ! -e "$(cat abc_pipe.tempdir)"
+
+rm -f abc_pipe.il abc_pipe_exe.sh abc_pipe.tempdir abc_pipe.log
@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# bitsim -stim: the patterns of a cycle are read from consecutive lines, and an
+# incomplete cycle at the end of the file is not simulated.
+
+set -e
+
+cat > bitsim_stim.il << 'EOT'
+module \top
+  wire input 1 \a
+  wire input 2 \b
+  wire output 3 \x
+  cell $_AND_ $and$1
+    connect \A \a
+    connect \B \b
+    connect \Y \x
+  end
+end
+EOT
+
+# cycle 1: a & b only in pattern 0, cycle 2: a & b in patterns 62 and 63
+{
+	echo 11
+	for i in $(seq 63); do echo 01; done
+	for i in $(seq 62); do echo 10; done
+	echo 11
+	echo "1 1  # comment"
+	for i in $(seq 10); do echo 11; done
+} > bitsim_stim.txt
+
+../../yosys -p "read_ilang bitsim_stim.il; bitsim -words 1 -n 5 -stim bitsim_stim.txt -sig bitsim_stim.sig w:x" > bitsim_stim.log
+grep -q "Simulated 2 cycles of 64 patterns" bitsim_stim.log
+grep -q "Ignoring 10 patterns of an incomplete cycle at the end of the stimulus file." bitsim_stim.log
+grep -qx '\\x 0000000000000001 c000000000000000' bitsim_stim.sig
+
+../../yosys -p "read_ilang bitsim_stim.il; bitsim -words 1 -n 1 -stim bitsim_stim.txt -sig bitsim_stim.sig w:x" > bitsim_stim.log
+grep -q "Simulated 1 cycles of 64 patterns" bitsim_stim.log
+grep -qx '\\x 0000000000000001' bitsim_stim.sig
+
+rm -f bitsim_stim.il bitsim_stim.txt bitsim_stim.sig bitsim_stim.log
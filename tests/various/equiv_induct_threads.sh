@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+# equiv_induct -threads must prove the same $equiv cells as a single thread.
+
+set -e
+
+cat > equiv_induct_threads.il << 'EOT'
+module \gold
+  wire input 1 \clk
+  wire width 4 input 2 \a
+  wire width 4 input 3 \b
+  wire width 4 output 4 \y
+  wire width 4 output 5 \z
+  wire width 4 \n
+  wire width 4 \q
+  cell $add $add$1
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \q
+    connect \B \a
+    connect \Y \n
+  end
+  cell $dff $dff$2
+    parameter \CLK_POLARITY 1
+    parameter \WIDTH 4
+    connect \CLK \clk
+    connect \D \n
+    connect \Q \q
+  end
+  cell $xor $xor$3
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \q
+    connect \B \b
+    connect \Y \y
+  end
+  cell $and $and$4
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \a
+    connect \B \b
+    connect \Y \z
+  end
+end
+module \gate
+  wire input 1 \clk
+  wire width 4 input 2 \a
+  wire width 4 input 3 \b
+  wire width 4 output 4 \y
+  wire width 4 output 5 \z
+  wire width 4 \n
+  wire width 4 \q
+  cell $add $add$1
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \a
+    connect \B \q
+    connect \Y \n
+  end
+  cell $dff $dff$2
+    parameter \CLK_POLARITY 1
+    parameter \WIDTH 4
+    connect \CLK \clk
+    connect \D \n
+    connect \Q \q
+  end
+  cell $xor $xor$3
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \b
+    connect \B \q
+    connect \Y \y
+  end
+  cell $or $or$4
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \a
+    connect \B \b
+    connect \Y \z
+  end
+end
+EOT
+
+for threads in 1 4; do
+	../../yosys -p "read_ilang equiv_induct_threads.il; equiv_make gold gate equiv; hierarchy -top equiv;
+			equiv_induct -threads $threads; equiv_status; write_ilang equiv_induct_threads_$threads.out" \
+			> equiv_induct_threads.log
+	grep -q "Of those cells 12 are proven and 4 are unproven." equiv_induct_threads.log
+done
+cmp equiv_induct_threads_1.out equiv_induct_threads_4.out
+
+rm -f equiv_induct_threads.il equiv_induct_threads.log equiv_induct_threads_1.out equiv_induct_threads_4.out
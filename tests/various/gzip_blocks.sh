@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# Write and read gzip files that span many compression blocks, and compare them
+# with the uncompressed output.
+
+set -e
+
+../../yosys -q -s - <<- EOY
+  read_verilog << EOV
+    module top(input [31:0] a, b, c, output [63:0] y);
+      assign y = a * b + c;
+    endmodule
+  EOV
+  synth -flatten -top top
+  write_ilang gzip_blocks.il
+EOY
+
+../../yosys -q -z 4 -p "read_ilang gzip_blocks.il; write_ilang gzip_blocks.il.gz"
+../../yosys -q -z 1 -p "read_ilang gzip_blocks.il; write_ilang gzip_blocks_1.il.gz"
+../../yosys -q -z 4 -p "read_ilang gzip_blocks.il.gz; write_ilang gzip_blocks_2.il"
+
+test $(wc -c < gzip_blocks.il) -gt 300000
+
+gzip -t gzip_blocks.il.gz
+gzip -dc gzip_blocks.il.gz | cmp - gzip_blocks.il
+cmp gzip_blocks.il.gz gzip_blocks_1.il.gz
+cmp gzip_blocks.il gzip_blocks_2.il
+
+rm -f gzip_blocks.il gzip_blocks.il.gz gzip_blocks_1.il.gz gzip_blocks_2.il
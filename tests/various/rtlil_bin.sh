@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Round trip through write_rtlil_bin/read_rtlil_bin.
+
+set -e
+
+../../yosys -q -s - <<- EOY
+  read_verilog << EOV
+    module sub #(parameter W = 4, parameter real R = 1.5, parameter S = "str") (input [W-1:0] a, output [0:W-1] y);
+      assign y = ~a;
+    endmodule
+
+    module top(input clk, input [3:0] a, b, output reg [3:0] q, output [3:0] z);
+      reg [7:0] mem [0:15];
+      (* parallel_case *)
+      always @(posedge clk) begin
+        case (a)
+          1, 2: q <= b;
+          3: if (b[0]) q <= 4'bx01z;
+          default: q <= mem[b];
+        endcase
+        mem[a] <= {a, b};
+      end
+      sub #(.W(4), .S("xyz")) s (.a(a ^ b), .y(z));
+    endmodule
+  EOV
+  hierarchy -top top
+  write_ilang rtlil_bin_1.il
+  write_rtlil_bin rtlil_bin.rb
+  design -reset
+  read_rtlil_bin rtlil_bin.rb
+  write_ilang rtlil_bin_2.il
+EOY
+
+cmp rtlil_bin_1.il rtlil_bin_2.il
+
+../../yosys -p "read_rtlil_bin -module top rtlil_bin.rb" | grep "Read 1 of 2 modules."
+
+rm -f rtlil_bin_1.il rtlil_bin_2.il rtlil_bin.rb
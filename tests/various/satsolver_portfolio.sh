@@ -0,0 +1,195 @@
+#!/usr/bin/env bash
+# satsolver -load/-portfolio and sat -timeout, using two stand-in IPASIR
+# solvers: a small backtracking solver and one that never finds an answer and
+# only returns when the terminate callback asks it to.
+
+set -e
+
+cat > satsolver_portfolio.c << 'EOT'
+#include <stdlib.h>
+
+typedef struct {
+	int *clauses, nclauses, capclauses;
+	int *assumps, nassumps, capassumps;
+	signed char *val;
+	int nvars;
+	void *term_data;
+	int (*term)(void *data);
+} solver_t;
+
+static void push(int **v, int *n, int *cap, int x)
+{
+	if (*n == *cap) {
+		*cap = *cap ? 2 * *cap : 64;
+		*v = realloc(*v, *cap * sizeof(int));
+	}
+	(*v)[(*n)++] = x;
+}
+
+static int lit_value(solver_t *s, int lit)
+{
+	int v = s->val[abs(lit)];
+	return lit > 0 ? v : -v;
+}
+
+static int conflict(solver_t *s)
+{
+	int falsified = 1;
+	for (int i = 0; i < s->nclauses; i++) {
+		if (s->clauses[i] == 0) {
+			if (falsified)
+				return 1;
+			falsified = 1;
+		} else if (lit_value(s, s->clauses[i]) >= 0)
+			falsified = 0;
+	}
+	return 0;
+}
+
+/* 10: satisfiable, 20: unsatisfiable, 0: terminated */
+static int search(solver_t *s, int var)
+{
+	if (s->term && s->term(s->term_data))
+		return 0;
+	if (conflict(s))
+		return 20;
+	while (var <= s->nvars && s->val[var] != 0)
+		var++;
+	if (var > s->nvars)
+		return 10;
+	for (int value = 1; value >= -1; value -= 2) {
+		s->val[var] = value;
+		int res = search(s, var + 1);
+		if (res != 20)
+			return res;
+	}
+	s->val[var] = 0;
+	return 20;
+}
+
+const char *ipasir_signature() { return SIGNATURE; }
+void *ipasir_init() { return calloc(1, sizeof(solver_t)); }
+
+void ipasir_release(void *solver)
+{
+	solver_t *s = solver;
+	free(s->clauses), free(s->assumps), free(s->val), free(s);
+}
+
+static void add_var(solver_t *s, int lit)
+{
+	if (abs(lit) > s->nvars) {
+		s->val = realloc(s->val, abs(lit) + 1);
+		s->nvars = abs(lit);
+	}
+}
+
+void ipasir_add(void *solver, int lit)
+{
+	solver_t *s = solver;
+	add_var(s, lit);
+	push(&s->clauses, &s->nclauses, &s->capclauses, lit);
+}
+
+void ipasir_assume(void *solver, int lit)
+{
+	solver_t *s = solver;
+	add_var(s, lit);
+	push(&s->assumps, &s->nassumps, &s->capassumps, lit);
+}
+
+int ipasir_solve(void *solver)
+{
+	solver_t *s = solver;
+	int res = 20;
+	for (int i = 0; i <= s->nvars; i++)
+		s->val[i] = 0;
+#ifdef NEVER_DONE
+	while (!s->term || !s->term(s->term_data))
+		;
+	res = 0;
+#else
+	for (int i = 0; i < s->nassumps; i++) {
+		int lit = s->assumps[i];
+		if (lit_value(s, lit) < 0)
+			goto done;
+		s->val[abs(lit)] = lit > 0 ? 1 : -1;
+	}
+	res = search(s, 1);
+done:
+#endif
+	s->nassumps = 0;
+	return res;
+}
+
+int ipasir_val(void *solver, int lit)
+{
+	solver_t *s = solver;
+	return abs(lit) <= s->nvars && s->val[abs(lit)] < 0 ? -lit : lit;
+}
+
+void ipasir_set_terminate(void *solver, void *data, int (*terminate)(void *data))
+{
+	solver_t *s = solver;
+	s->term_data = data;
+	s->term = terminate;
+}
+EOT
+
+${CC:-gcc} -shared -fPIC -DSIGNATURE='"backtrack"' -o satsolver_portfolio_bt.so satsolver_portfolio.c
+${CC:-gcc} -shared -fPIC -DSIGNATURE='"never"' -DNEVER_DONE -o satsolver_portfolio_never.so satsolver_portfolio.c
+
+cat > satsolver_portfolio.il << 'EOT'
+module \top
+  wire width 4 input 1 \a
+  wire width 4 input 2 \b
+  wire width 5 output 3 \x
+  wire width 5 output 4 \y
+  cell $add $add$1
+    parameter \A_SIGNED 0
+    parameter \B_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 5
+    connect \A \a
+    connect \B \b
+    connect \Y \x
+  end
+  cell $add $add$2
+    parameter \A_SIGNED 0
+    parameter \B_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 5
+    connect \A \b
+    connect \B \a
+    connect \Y \y
+  end
+end
+EOT
+
+for solver in minisat bt portfolio; do
+	../../yosys -p "
+		read_ilang satsolver_portfolio.il
+		satsolver -load bt ./satsolver_portfolio_bt.so
+		satsolver -load never ./satsolver_portfolio_never.so
+		satsolver -portfolio portfolio never bt
+		satsolver $solver
+		sat -verify -prove x y
+		sat -set a 13 -set b 9 -show x -show y
+	" > satsolver_portfolio_$solver.log
+	grep -q "SAT proof finished - no model found: SUCCESS!" satsolver_portfolio_$solver.log
+	grep -qE '\\x +22 +16 +10110$' satsolver_portfolio_$solver.log
+	grep -qE '\\y +22 +16 +10110$' satsolver_portfolio_$solver.log
+done
+
+# the stand-in that never answers is stopped by the timeout
+../../yosys -p "
+	read_ilang satsolver_portfolio.il
+	satsolver -load never ./satsolver_portfolio_never.so
+	satsolver never
+	sat -timeout 1 -prove x y
+" > satsolver_portfolio_never.log
+grep -q "Interrupted SAT solver: TIMEOUT!" satsolver_portfolio_never.log
+
+rm -f satsolver_portfolio.c satsolver_portfolio.il satsolver_portfolio_*.so satsolver_portfolio_*.log
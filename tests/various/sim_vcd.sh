@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+# sim -vcd with gzip output and -dump selections, and a trace that is long
+# enough to be written in several blocks by the writer thread.
+
+set -e
+
+cat > sim_vcd.il << 'EOT'
+module \top
+  wire input 1 \clk
+  wire width 16 output 2 \cnt
+  wire width 16 output 3 \y
+  wire width 16 \next
+  cell $add $add$1
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 16
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 16
+    parameter \Y_WIDTH 16
+    connect \A \cnt
+    connect \B 16'0000000000000001
+    connect \Y \next
+  end
+  cell $dff $dff$2
+    parameter \CLK_POLARITY 1
+    parameter \WIDTH 16
+    connect \CLK \clk
+    connect \D \next
+    connect \Q \cnt
+  end
+  cell $not $not$3
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 16
+    parameter \Y_WIDTH 16
+    connect \A \cnt
+    connect \Y \y
+  end
+end
+EOT
+
+../../yosys -q -p "read_ilang sim_vcd.il; sim -clock clk -zinit -n 50000 -vcd sim_vcd.vcd"
+../../yosys -q -p "read_ilang sim_vcd.il; sim -clock clk -zinit -n 50000 -vcd sim_vcd.vcd.gz"
+
+test $(wc -c < sim_vcd.vcd) -gt 3000000
+grep '^#' sim_vcd.vcd | cut -c2- | sort -n -c -u
+gzip -dc sim_vcd.vcd.gz | cmp - sim_vcd.vcd
+
+../../yosys -q -p "read_ilang sim_vcd.il; sim -clock clk -zinit -n 10 -dump w:cnt -vcd sim_vcd.vcd"
+test $(grep -c '^\$var' sim_vcd.vcd) -eq 1
+grep -q '^\$var wire 16 .* cnt \$end$' sim_vcd.vcd
+
+../../yosys -q -p "read_ilang sim_vcd.il; sim -clock clk -zinit -n 10 -dump w:cnt -dump w:y -vcd sim_vcd.vcd"
+test $(grep -c '^\$var' sim_vcd.vcd) -eq 2
+
+if ../../yosys -q -p "read_ilang sim_vcd.il; sim -clock clk -n 2 -vcd sim_vcd.vcd -vcd sim_vcd.vcd" > sim_vcd.err 2>&1; then
+	exit 1
+fi
+grep -q "Option -vcd can only be used once." sim_vcd.err
+
+rm -f sim_vcd.il sim_vcd.vcd sim_vcd.vcd.gz sim_vcd.err
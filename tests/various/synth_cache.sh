@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Test of incremental synthesis with synth -incremental.
+
+set -e
+
+rm -rf synth_cache.tmp
+
+run_synth() {
+	../../yosys -s - <<- EOY
+	  read_verilog << EOV
+	    module sub(input [3:0] a, b, output [3:0] y);
+	      assign y = a + b;
+	    endmodule
+
+	    module top(input [3:0] a, b, output [3:0] y, z);
+	      sub s (a, b, y);
+	      assign z = $1;
+	    endmodule
+	  EOV
+	  synth -top top -incremental synth_cache.tmp
+	  write_verilog -noattr synth_cache_$2.out
+	EOY
+}
+
+echo -n "  cold cache - "
+run_synth "a & b" 1 | grep "Found 0 of 2 modules in the cache."
+
+echo -n "  warm cache - "
+run_synth "a & b" 2 | grep "Found 2 of 2 modules in the cache."
+cmp synth_cache_1.out synth_cache_2.out
+
+echo -n "  changed top - "
+run_synth "a | b" 3 | grep "Found 1 of 2 modules in the cache."
+
+rm -rf synth_cache.tmp synth_cache_*.out
@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+# write_blif -threads must produce the same output as a single thread.
+
+set -e
+
+# 24 modules, so that -threads 2 writes them in several batches
+copies=$(for i in $(seq 10 29); do echo -n "copy half_add half_add_$i; "; done)
+
+for args in "" "-gates" "-icells -param -attr" "-noalias -cname"; do
+	../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_blif $args write_blif_threads_1.blif"
+	../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_blif $args -threads 2 write_blif_threads_2.blif"
+	cmp write_blif_threads_1.blif write_blif_threads_2.blif
+done
+
+# The top module comes first, the other modules follow in the same order.
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_blif -threads 2 write_blif_threads_2.blif"
+test "$(grep '^\.model' write_blif_threads_2.blif | cut -d' ' -f2 | xargs)" = \
+		"top full_add half_add $(seq -f half_add_%g -s ' ' 10 29) toggle"
+grep -q '^\.subckt toggle clk=clk en=y\[1\] q=t$' write_blif_threads_2.blif
+grep -q '^\.latch d q re clk 2$' write_blif_threads_2.blif
+grep -A1 '^\.names a b c$' write_blif_threads_2.blif | grep -q '^11 1$'
+
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_blif -icells -cname -threads 2 write_blif_threads_2.blif"
+grep -q '^\.subckt \$_MUX_ A=q B=nq S=en Y=d$' write_blif_threads_2.blif
+grep -A1 '^\.subckt half_add a=s1 b=ci c=c2 s=s$' write_blif_threads_2.blif | grep -q '^\.cname ha2$'
+
+rm -f write_blif_threads_1.blif write_blif_threads_2.blif
@@ -0,0 +1,93 @@
+#!/usr/bin/env bash
+# write_btor: the slices and extensions of a[3:0] and b[3:0] that are used by
+# several cells are written only once, and -props writes one file for each
+# assert with the model followed by the bad property of that assert.
+
+set -e
+
+cat > write_btor_props.il << 'EOT'
+module \top
+  wire width 8 input 1 \a
+  wire width 8 input 2 \b
+  wire width 5 \s1
+  wire width 5 \s2
+  wire \p1
+  wire \p2
+  wire \p3
+  cell $add $add$1
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 5
+    connect \A \a [3:0]
+    connect \B \b [3:0]
+    connect \Y \s1
+  end
+  cell $sub $sub$2
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 5
+    connect \A \a [3:0]
+    connect \B \b [3:0]
+    connect \Y \s2
+  end
+  cell $reduce_or $reduce_or$3
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 5
+    parameter \Y_WIDTH 1
+    connect \A \s1
+    connect \Y \p1
+  end
+  cell $reduce_or $reduce_or$4
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 5
+    parameter \Y_WIDTH 1
+    connect \A \s2
+    connect \Y \p2
+  end
+  cell $ne $ne$5
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 1
+    connect \A \a [7:4]
+    connect \B \b [3:0]
+    connect \Y \p3
+  end
+  cell $assert $assert$6
+    connect \A \p1
+    connect \EN 1'1
+  end
+  cell $assert $assert$7
+    connect \A \p2
+    connect \EN 1'1
+  end
+  cell $assert $assert$8
+    connect \A \p3
+    connect \EN 1'1
+  end
+end
+EOT
+
+../../yosys -q -p "read_ilang write_btor_props.il; write_btor -props write_btor_props_ write_btor_props.btor"
+
+test $(grep -c " slice " write_btor_props.btor) -eq 3
+# (uext nodes with zero extension only name the wires)
+test $(grep -cE " uext [0-9]+ [0-9]+ 1$" write_btor_props.btor) -eq 2
+
+# the main output holds all bad properties at its end
+test $(grep -c " bad " write_btor_props.btor) -eq 3
+grep -v "^;" write_btor_props.btor | tail -n 3 | grep -c " bad " | grep -qx 3
+
+for i in 0 1 2; do
+	test $(grep -c " bad " write_btor_props_$i.btor) -eq 1
+	grep -v "^;" write_btor_props_$i.btor | grep -v " bad " > write_btor_props_model_$i.btor
+	grep -v "^;" write_btor_props.btor | grep -v " bad " | cmp - write_btor_props_model_$i.btor
+done
+test ! -e write_btor_props_3.btor
+
+rm -f write_btor_props.il write_btor_props.btor write_btor_props_*.btor
@@ -0,0 +1,77 @@
+#!/usr/bin/env bash
+# write_edif must write the nets of a module in the same order every time.
+
+set -e
+
+cat > write_edif_order.il << 'EOT'
+module \sub
+  wire input 1 \a
+  wire input 2 \b
+  wire output 3 \y
+  wire \t
+  cell $_AND_ $_AND_$1
+    connect \A \a
+    connect \B \b
+    connect \Y \t
+  end
+  cell $_NOT_ $_NOT_$2
+    connect \A \t
+    connect \Y \y
+  end
+end
+module \top
+  wire width 4 input 1 \a
+  wire width 4 input 2 \b
+  wire width 4 output 3 \y
+  wire width 2 \t
+  cell $_XOR_ $_XOR_$1
+    connect \A \a [0]
+    connect \B \b [0]
+    connect \Y \t [0]
+  end
+  cell $_OR_ $_OR_$2
+    connect \A \a [1]
+    connect \B \t [0]
+    connect \Y \t [1]
+  end
+  cell \sub \u1
+    connect \a \t [1]
+    connect \b \a [2]
+    connect \y \y [0]
+  end
+  cell \sub \u2
+    connect \a \b [3]
+    connect \b \a [3]
+    connect \y \y [1]
+  end
+  cell $_AND_ $_AND_$3
+    connect \A \t [0]
+    connect \B \t [1]
+    connect \Y \y [2]
+  end
+  connect \y [3] \a [0]
+end
+EOT
+
+for i in 1 2; do
+	../../yosys -q -p "read_ilang write_edif_order.il; hierarchy -top top; write_edif write_edif_order_$i.edif"
+done
+cmp write_edif_order_1.edif write_edif_order_2.edif
+
+../../yosys -q -p "read_ilang write_edif_order.il; hierarchy -top top; design -save d;
+		design -reset; design -load d; write_edif write_edif_order_3.edif"
+cmp write_edif_order_1.edif write_edif_order_3.edif
+
+# The sorted port refs of the net with the given name
+net() {
+	awk -v key="$1 (joined" 'index($0, key) { f = 1; next } f && /^ *\)$/ { exit } f' write_edif_order_1.edif |
+			sed 's/^ *//' | LC_ALL=C sort | tr '\n' ' '
+}
+
+test "$(net '(net t')" = "(portRef A (instanceRef id00005)) (portRef Y (instanceRef id00006)) "
+test "$(net '"a[0]")')" = "(portRef (member a 3)) (portRef (member y 0)) (portRef A (instanceRef id00009)) "
+test "$(net '"a[2]")')" = "(portRef (member a 1)) (portRef b (instanceRef u1)) "
+test "$(net '"b[3]")')" = "(portRef (member b 0)) (portRef a (instanceRef u2)) "
+test "$(net '"t[1]")')" = "(portRef B (instanceRef id00007)) (portRef Y (instanceRef id00008)) (portRef a (instanceRef u1)) "
+
+rm -f write_edif_order.il write_edif_order_*.edif
@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+# write_json -threads must produce the same output as a single thread.
+
+set -e
+
+# 24 modules, so that -threads 2 writes them in several batches
+copies=$(for i in $(seq 10 29); do echo -n "copy half_add half_add_$i; "; done)
+
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_json write_json_threads_1.json"
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_json -threads 2 write_json_threads_2.json"
+cmp write_json_threads_1.json write_json_threads_2.json
+
+# The modules are written in the same order, and every module has its own bit IDs.
+test "$(grep -o '^    "[a-z_0-9]*": {$' write_json_threads_2.json | tr -d ' "{:' | xargs)" = \
+		"full_add half_add $(seq -f half_add_%g -s ' ' 10 29) toggle top"
+grep -A2 '^        "x": {$' write_json_threads_2.json | grep -q '"bits": \[ 3, 4, 5 \]'
+grep -B2 '^          "type": "\$_DFF_P_",$' write_json_threads_2.json | grep -q '"\$dff\$6": {'
+
+rm -f write_json_threads_1.json write_json_threads_2.json
@@ -0,0 +1,74 @@
+#!/usr/bin/env bash
+# write_smt2 shares the definitions of cells that compute the same expression:
+# the duplicated $and, $not and $reduce_xor cells must not produce more
+# definitions than in the design after opt_merge.
+
+set -e
+
+cat > write_smt2_share.il << 'EOT'
+module \top
+  wire width 4 input 1 \a
+  wire width 4 input 2 \b
+  wire width 4 output 3 \y1
+  wire width 4 output 4 \y2
+  wire output 5 \y3
+  wire output 6 \y4
+  wire width 4 \x1
+  wire width 4 \x2
+  cell $and $and$1
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \a
+    connect \B \b
+    connect \Y \x1
+  end
+  cell $and $and$2
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \a
+    connect \B \b
+    connect \Y \x2
+  end
+  cell $not $not$3
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \x1
+    connect \Y \y1
+  end
+  cell $not $not$4
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \x2
+    connect \Y \y2
+  end
+  cell $reduce_xor $reduce_xor$5
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \Y_WIDTH 1
+    connect \A \x1
+    connect \Y \y3
+  end
+  cell $reduce_xor $reduce_xor$6
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \Y_WIDTH 1
+    connect \A \x2
+    connect \Y \y4
+  end
+end
+EOT
+
+../../yosys -q -p "read_ilang write_smt2_share.il; write_smt2 -wires write_smt2_share_1.smt2;
+		opt_merge; opt_clean; select -assert-count 3 t:*; write_smt2 -wires write_smt2_share_2.smt2"
+
+test $(grep -c "^(define-fun |top#" write_smt2_share_1.smt2) -eq $(grep -c "^(define-fun |top#" write_smt2_share_2.smt2)
+
+rm -f write_smt2_share.il write_smt2_share_1.smt2 write_smt2_share_2.smt2
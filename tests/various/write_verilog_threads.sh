@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# write_verilog -threads must produce the same output as a single thread.
+
+set -e
+
+# 24 modules, so that -threads 2 writes them in several batches
+copies=$(for i in $(seq 10 29); do echo -n "copy half_add half_add_$i; "; done)
+
+for args in "" "-noexpr" "-norename -siminit"; do
+	../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_verilog $args write_verilog_threads_1.v"
+	../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_verilog $args -threads 2 write_verilog_threads_2.v"
+	cmp write_verilog_threads_1.v write_verilog_threads_2.v
+done
+
+# The modules are written in the same order, with the names of the single
+# threaded output.
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_verilog -threads 2 write_verilog_threads_2.v"
+test "$(grep '^module' write_verilog_threads_2.v | cut -d'(' -f1 | xargs)" = \
+		"module full_add module half_add $(seq -f 'module half_add_%g' -s ' ' 10 29) module toggle module top"
+grep -q '^  assign s = a ^ b;$' write_verilog_threads_2.v
+grep -q '^  assign d = en ? nq : q;$' write_verilog_threads_2.v
+grep -q '^  toggle tg ($' write_verilog_threads_2.v
+
+../../yosys -q -p "read_ilang write_threads.il; hierarchy -top top; $copies write_verilog -noexpr -threads 2 write_verilog_threads_2.v"
+grep -q '^  \\$_OR_  _0_ ($' write_verilog_threads_2.v
+grep -q '^  \\$_DFF_P_  q_reg /\* _0_ \*/ ($' write_verilog_threads_2.v
+
+rm -f write_verilog_threads_1.v write_verilog_threads_2.v